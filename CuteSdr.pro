@@ -71,7 +71,10 @@ SOURCES += gui/main.cpp \
     interface/netiobase.cpp \
     interface/ad6620.cpp \
 	interface/perform.cpp \
+	interface/loadgovernor.cpp \
 	dsp/fractresampler.cpp \
+	dsp/rationalresampler.cpp \
+	dsp/scratcharena.cpp \
     dsp/fastfir.cpp \
     dsp/downconvert.cpp \
     dsp/demodulator.cpp \
@@ -82,6 +85,7 @@ SOURCES += gui/main.cpp \
 	dsp/ssbdemod.cpp \
 	dsp/smeter.cpp \
     dsp/fmdemod.cpp \
+	dsp/wfmdemod.cpp \
 	dsp/fir.cpp \
     dsp/iir.cpp \
 	dsp/noiseproc.cpp
@@ -109,7 +113,11 @@ HEADERS  += gui/mainwindow.h \
     interface/ad6620.h \
 	interface/ascpmsg.h \
 	interface/perform.h \
+	interface/loadgovernor.h \
+	interface/spscqueue.h \
 	dsp/fractresampler.h \
+	dsp/rationalresampler.h \
+	dsp/scratcharena.h \
     dsp/fastfir.h \
 	dsp/filtercoef.h \
 	dsp/downconvert.h \
@@ -122,7 +130,10 @@ HEADERS  += gui/mainwindow.h \
 	dsp/ssbdemod.h \
 	dsp/smeter.h \
     dsp/fmdemod.h \
+	dsp/wfmdemod.h \
+	dsp/fastmath.h \
 	dsp/fir.h \
+	dsp/firfilter.h \
     dsp/iir.h \
 	dsp/noiseproc.h
 
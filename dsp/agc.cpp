@@ -73,6 +73,8 @@
 								//corresponding to -160dB.
 								//K = 10^( -8 + log(32767) )
 
+#define MAGBUF_MASK (MAX_DELAY_BUF-1)	//MAX_DELAY_BUF must be a power of 2
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -86,6 +88,14 @@ CAgc::CAgc()
 	m_SlopeFactor = 0;
 	m_Decay = 0;
 	m_SampleRate = 100.0;
+	m_GainDecimation = 1;
+	m_PeakQHead = 0;
+	m_PeakQCount = 0;
+	m_MagTime = 0;
+	m_BlockPos = 0;
+	m_BlockMax = 0.0;
+	m_Gain = 0.0;
+	m_GainStep = 0.0;
 }
 
 CAgc::~CAgc()
@@ -125,16 +135,56 @@ void CAgc::SetParameters(bool AgcOn,  bool UseHang, int Threshold, int ManualGai
 		{
 			m_SigDelayBuf[i].re = 0.0;
 			m_SigDelayBuf[i].im = 0.0;
-			m_MagBuf[i] = -16.0;
 		}
 		m_SigDelayPtr = 0;
 		m_HangTimer = 0;
 		m_Peak = -16.0;
 		m_DecayAve = -5.0;
 		m_AttackAve = -5.0;
-		m_MagBufPos = 0;
+		m_PeakQHead = 0;
+		m_PeakQCount = 0;
+		m_MagTime = 0;
+		m_BlockPos = 0;
+		m_BlockMax = 0.0;
+		m_Gain = 0.0;
+		m_GainStep = 0.0;
 	}
+	CalcParameters();
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Sets how many samples share one AGC gain calculation.
+// 1 calculates the gain every sample.  Larger values calculate the envelope
+// and gain once per block of 'GainDecimation' samples and linearly interpolate
+// the gain between blocks.
+////////////////////////////////////////////////////////////////////////////////
+void CAgc::SetGainDecimation(int GainDecimation)
+{
+	if(GainDecimation < 1)
+		GainDecimation = 1;
+	if(GainDecimation == m_GainDecimation)
+		return;
+	m_Mutex.lock();
+	m_GainDecimation = GainDecimation;
+	//peak queue times are in control rate units so start it over
+	m_PeakQHead = 0;
+	m_PeakQCount = 0;
+	m_BlockPos = 0;
+	m_BlockMax = 0.0;
+	CalcParameters();
+	m_Mutex.unlock();
+}
 
+////////////////////////////////////////////////////////////////////////////////
+// Calculates internal AGC values from the current settings.
+// Time constants are calculated at the gain control rate which is the
+// sample rate divided by m_GainDecimation.
+// Called with m_Mutex locked.
+////////////////////////////////////////////////////////////////////////////////
+void CAgc::CalcParameters()
+{
+TYPEREAL ctlrate = m_SampleRate/(TYPEREAL)m_GainDecimation;
 	//convert m_ThreshGain to linear manual gain value
 	m_ManualAgcGain = MAX_MANUAL_AMPLITUDE*pow(10.0, -(100-(TYPEREAL)m_ManualGain)/20.0);
 
@@ -145,28 +195,259 @@ void CAgc::SetParameters(bool AgcOn,  bool UseHang, int Threshold, int ManualGai
 //qDebug()<<"m_Knee = "<<m_Knee<<" m_GainSlope = "<<m_GainSlope<< "m_FixedGain = "<<m_FixedGain;
 
 	//calculate fast and slow filter values.
-	m_AttackRiseAlpha = (1.0-exp(-1.0/(m_SampleRate*ATTACK_RISE_TIMECONST)) );
-	m_AttackFallAlpha = (1.0-exp(-1.0/(m_SampleRate*ATTACK_FALL_TIMECONST)) );
+	m_AttackRiseAlpha = (1.0-exp(-1.0/(ctlrate*ATTACK_RISE_TIMECONST)) );
+	m_AttackFallAlpha = (1.0-exp(-1.0/(ctlrate*ATTACK_FALL_TIMECONST)) );
 
-	m_DecayRiseAlpha = (1.0-exp(-1.0/(m_SampleRate * (TYPEREAL)m_Decay*.001*DECAY_RISEFALL_RATIO)) );	//make rise time DECAY_RISEFALL_RATIO of fall
-	m_HangTime = (int)(m_SampleRate * (TYPEREAL)m_Decay * .001);
+	m_DecayRiseAlpha = (1.0-exp(-1.0/(ctlrate * (TYPEREAL)m_Decay*.001*DECAY_RISEFALL_RATIO)) );	//make rise time DECAY_RISEFALL_RATIO of fall
+	m_HangTime = (int)(ctlrate * (TYPEREAL)m_Decay * .001);
 
 	if(m_UseHang)
-		m_DecayFallAlpha = (1.0-exp(-1.0/(m_SampleRate * RELEASE_TIMECONST)) );
+		m_DecayFallAlpha = (1.0-exp(-1.0/(ctlrate * RELEASE_TIMECONST)) );
 	else
-		m_DecayFallAlpha = (1.0-exp(-1.0/(m_SampleRate * (TYPEREAL)m_Decay *.001)) );
+		m_DecayFallAlpha = (1.0-exp(-1.0/(ctlrate * (TYPEREAL)m_Decay *.001)) );
 
 	m_DelaySamples = (int)(m_SampleRate*DELAY_TIMECONST);
-	m_WindowSamples = (int)(m_SampleRate*WINDOW_TIMECONST);
+	m_WindowSamples = (int)(ctlrate*WINDOW_TIMECONST);
 
-	//clamp Delay samples within buffer limit
+	//clamp Delay and peak window samples within buffer limit
 	if(m_DelaySamples >= MAX_DELAY_BUF-1)
 		m_DelaySamples = MAX_DELAY_BUF-1;
+	if(m_WindowSamples > MAX_DELAY_BUF)
+		m_WindowSamples = MAX_DELAY_BUF;
+	if(m_WindowSamples < 1)
+		m_WindowSamples = 1;
+}
 
-	m_Mutex.unlock();
+//////////////////////////////////////////////////////////////////////
+// Calculates log magnitudes of a block of up to MAX_DELAY_BUF input
+// samples into m_MagBuf[].  Done as separate simple loops ahead of
+// the AGC loop so the compiler can vectorize them.
+//  0==max  -8 is min==-160dB
+//////////////////////////////////////////////////////////////////////
+void CAgc::CalcLogMagnitudes(int Length, TYPECPX* pInData)
+{
+const TYPEREAL logmax = log10(MAX_AMPLITUDE);
+	for(int i=0; i<Length; i++)
+	{	//use larger of |I| or |Q| as the magnitude
+		TYPEREAL mre = fabs(pInData[i].re);
+		TYPEREAL mim = fabs(pInData[i].im);
+		m_MagBuf[i] = (mim>mre ? mim : mre) + MIN_CONSTANT;
+	}
+	for(int i=0; i<Length; i++)
+		m_MagBuf[i] = log10(m_MagBuf[i]) - logmax;
+}
+
+void CAgc::CalcLogMagnitudes(int Length, TYPEREAL* pInData)
+{
+const TYPEREAL logmax = log10(MAX_AMPLITUDE);
+	for(int i=0; i<Length; i++)
+		m_MagBuf[i] = fabs(pInData[i]) + MIN_CONSTANT;
+	for(int i=0; i<Length; i++)
+		m_MagBuf[i] = log10(m_MagBuf[i]) - logmax;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Adds a new log magnitude to the sliding window of 'm_WindowSamples'
+// magnitudes and returns the peak value within the window.
+// Uses a monotonic queue holding only samples that can still become
+// the window peak so each sample is added and removed only once.
+//////////////////////////////////////////////////////////////////////
+inline TYPEREAL CAgc::UpdatePeak(TYPEREAL mag)
+{
+	//remove the current peak if it has slid out of the window
+	if( m_PeakQCount && ((m_MagTime - m_PeakQTime[m_PeakQHead]) >= (quint32)m_WindowSamples) )
+	{
+		m_PeakQHead = (m_PeakQHead+1) & MAGBUF_MASK;
+		m_PeakQCount--;
+	}
+	//remove older samples that are not larger than the new one since they can never be the peak
+	while( m_PeakQCount && (m_PeakQVal[(m_PeakQHead+m_PeakQCount-1) & MAGBUF_MASK] <= mag) )
+		m_PeakQCount--;
+	int tail = (m_PeakQHead+m_PeakQCount) & MAGBUF_MASK;
+	m_PeakQVal[tail] = mag;
+	m_PeakQTime[tail] = m_MagTime++;
+	m_PeakQCount++;
+	return m_PeakQVal[m_PeakQHead];
+}
+
+//////////////////////////////////////////////////////////////////////
+// Runs the attack and decay averagers on the latest window peak and
+// returns the AGC gain for the resulting magnitude.
+// Called once per sample or once per block of m_GainDecimation samples.
+//////////////////////////////////////////////////////////////////////
+inline TYPEREAL CAgc::CalcGain(TYPEREAL peak)
+{
+TYPEREAL mag;
+	if(m_UseHang)
+	{	//using hang timer mode
+		if(peak>m_AttackAve)	//if power is rising (use m_AttackRiseAlpha time constant)
+			m_AttackAve = (1.0-m_AttackRiseAlpha)*m_AttackAve + m_AttackRiseAlpha*peak;
+		else					//else magnitude is falling (use  m_AttackFallAlpha time constant)
+			m_AttackAve = (1.0-m_AttackFallAlpha)*m_AttackAve + m_AttackFallAlpha*peak;
+
+		if(peak>m_DecayAve)	//if magnitude is rising (use m_DecayRiseAlpha time constant)
+		{
+			m_DecayAve = (1.0-m_DecayRiseAlpha)*m_DecayAve + m_DecayRiseAlpha*peak;
+			m_HangTimer = 0;	//reset hang timer
+		}
+		else
+		{	//here if decreasing signal
+			if(m_HangTimer<m_HangTime)
+				m_HangTimer++;	//just inc and hold current m_DecayAve
+			else	//else decay with m_DecayFallAlpha which is RELEASE_TIMECONST
+				m_DecayAve = (1.0-m_DecayFallAlpha)*m_DecayAve + m_DecayFallAlpha*peak;
+		}
+	}
+	else
+	{	//using exponential decay mode
+		// perform average of magnitude using 2 averagers each with separate rise and fall time constants
+		if(peak>m_AttackAve)	//if magnitude is rising (use m_AttackRiseAlpha time constant)
+			m_AttackAve = (1.0-m_AttackRiseAlpha)*m_AttackAve + m_AttackRiseAlpha*peak;
+		else					//else magnitude is falling (use  m_AttackFallAlpha time constant)
+			m_AttackAve = (1.0-m_AttackFallAlpha)*m_AttackAve + m_AttackFallAlpha*peak;
+
+		if(peak>m_DecayAve)	//if magnitude is rising (use m_DecayRiseAlpha time constant)
+			m_DecayAve = (1.0-m_DecayRiseAlpha)*m_DecayAve + m_DecayRiseAlpha*(peak);
+		else					//else magnitude is falling (use m_DecayFallAlpha time constant)
+			m_DecayAve = (1.0-m_DecayFallAlpha)*m_DecayAve + m_DecayFallAlpha*(peak);
+	}
+	//use greater magnitude of attack or Decay Averager
+	if(m_AttackAve>m_DecayAve)
+		mag = m_AttackAve;
+	else
+		mag = m_DecayAve;
+
+	//calc gain depending on which side of knee the magnitude is on
+	if(mag<=m_Knee)		//use fixed gain if below knee
+		return m_FixedGain;
+	else				//use variable gain if above knee
+		return AGC_OUTSCALE * pow(10.0, mag*(m_GainSlope - 1.0) );
+}
+
+//////////////////////////////////////////////////////////////////////
+// Called at the end of each block of m_GainDecimation samples with the
+// largest linear magnitude seen in the block.  Calculates the new target
+// gain and the per sample step to ramp to it over the next block.
+//////////////////////////////////////////////////////////////////////
+void CAgc::EndGainBlock()
+{
+	TYPEREAL mag = log10( m_BlockMax + MIN_CONSTANT ) - log10(MAX_AMPLITUDE);
+	m_Peak = UpdatePeak(mag);
+	m_GainStep = (CalcGain(m_Peak) - m_Gain)/(TYPEREAL)m_GainDecimation;
+	m_BlockPos = 0;
+	m_BlockMax = 0.0;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Block rate Automatic Gain Control for COMPLEX data
+// Envelope and gain are calculated once per m_GainDecimation samples and
+// the gain is linearly interpolated across each block.
+// Output matches the per sample AGC to within a small fraction of a dB
+// apart from a lag of one control block(see SetGainDecimation()).
+//////////////////////////////////////////////////////////////////////
+void CAgc::ProcessBlockGain(int Length, TYPECPX* pInData, TYPECPX* pOutData)
+{
+	int i = 0;
+	while(i < Length)
+	{
+		int n = qMin(Length-i, m_GainDecimation-m_BlockPos);
+		TYPECPX* pIn = &pInData[i];
+		TYPECPX* pOut = &pOutData[i];
+		//find largest |I| or |Q| in this part of the block
+		TYPEREAL blockmax = m_BlockMax;
+		for(int j=0; j<n; j++)
+		{
+			TYPEREAL mre = fabs(pIn[j].re);
+			TYPEREAL mim = fabs(pIn[j].im);
+			TYPEREAL m = (mim>mre ? mim : mre);
+			blockmax = (m>blockmax ? m : blockmax);
+		}
+		m_BlockMax = blockmax;
+		//run samples through the delay line applying the interpolated gain.
+		//Done in spans up to the delay line wrap so the inner loop has no
+		//branches and can be vectorized.
+		TYPEREAL gain = m_Gain;
+		TYPEREAL step = m_GainStep;
+		int j = 0;
+		while(j < n)
+		{
+			int span = qMin(n-j, m_DelaySamples-m_SigDelayPtr);
+			TYPECPX* pDelay = &m_SigDelayBuf[m_SigDelayPtr];
+			TYPECPX* pI = &pIn[j];
+			TYPECPX* pO = &pOut[j];
+			for(int k=0; k<span; k++)
+			{
+				TYPEREAL dre = pDelay[k].re;
+				TYPEREAL dim = pDelay[k].im;
+				pDelay[k].re = pI[k].re;
+				pDelay[k].im = pI[k].im;
+				TYPEREAL g = gain + step*(TYPEREAL)k;
+				pO[k].re = dre * g;
+				pO[k].im = dim * g;
+			}
+			gain += step*(TYPEREAL)span;
+			j += span;
+			m_SigDelayPtr += span;
+			if( m_SigDelayPtr >= m_DelaySamples)
+				m_SigDelayPtr = 0;
+		}
+		m_Gain = gain;
+		i += n;
+		m_BlockPos += n;
+		if(m_BlockPos >= m_GainDecimation)
+			EndGainBlock();
+	}
+}
 
+//////////////////////////////////////////////////////////////////////
+// Block rate Automatic Gain Control for REAL data
+//////////////////////////////////////////////////////////////////////
+void CAgc::ProcessBlockGain(int Length, TYPEREAL* pInData, TYPEREAL* pOutData)
+{
+	int i = 0;
+	while(i < Length)
+	{
+		int n = qMin(Length-i, m_GainDecimation-m_BlockPos);
+		TYPEREAL* pIn = &pInData[i];
+		TYPEREAL* pOut = &pOutData[i];
+		//find largest |mag| in this part of the block
+		TYPEREAL blockmax = m_BlockMax;
+		for(int j=0; j<n; j++)
+		{
+			TYPEREAL m = fabs(pIn[j]);
+			blockmax = (m>blockmax ? m : blockmax);
+		}
+		m_BlockMax = blockmax;
+		//run samples through the delay line applying the interpolated gain
+		//in branch free spans up to the delay line wrap
+		TYPEREAL gain = m_Gain;
+		TYPEREAL step = m_GainStep;
+		int j = 0;
+		while(j < n)
+		{
+			int span = qMin(n-j, m_DelaySamples-m_SigDelayPtr);
+			TYPECPX* pDelay = &m_SigDelayBuf[m_SigDelayPtr];
+			TYPEREAL* pI = &pIn[j];
+			TYPEREAL* pO = &pOut[j];
+			for(int k=0; k<span; k++)
+			{
+				TYPEREAL delayedin = pDelay[k].re;
+				pDelay[k].re = pI[k];
+				pO[k] = delayedin * (gain + step*(TYPEREAL)k);
+			}
+			gain += step*(TYPEREAL)span;
+			j += span;
+			m_SigDelayPtr += span;
+			if( m_SigDelayPtr >= m_DelaySamples)
+				m_SigDelayPtr = 0;
+		}
+		m_Gain = gain;
+		i += n;
+		m_BlockPos += n;
+		if(m_BlockPos >= m_GainDecimation)
+			EndGainBlock();
+	}
+}
 
 //////////////////////////////////////////////////////////////////////
 // Automatic Gain Control calculator for COMPLEX data
@@ -177,7 +458,11 @@ TYPEREAL gain;
 TYPEREAL mag;
 TYPECPX delayedin;
 	m_Mutex.lock();
-	if(m_AgcOn)
+	if(m_AgcOn && (m_GainDecimation>1) )
+	{	//use block rate gain calculation
+		ProcessBlockGain(Length, pInData, pOutData);
+	}
+	else if(m_AgcOn)
 	{
 		for(int i=0; i<Length; i++)
 		{
@@ -189,97 +474,18 @@ TYPECPX delayedin;
 			if( m_SigDelayPtr >= m_DelaySamples)	//deal with delay buffer wrap around
 				m_SigDelayPtr = 0;
 
-//TYPEREAL dmag = 0.5* log10(  (dsig.re*dsig.re+dsig.im*dsig.im)/(MAX_AMPLITUDE*MAX_AMPLITUDE) + 1e-16);	//clamped to -160dBfs
-//pOutData[i].re = 3000*dmag;
-#if 1
-			mag = fabs(in.re);
-			TYPEREAL mim = fabs(in.im);
-			if(mim>mag)
-				mag = mim;
-			mag = log10( mag + MIN_CONSTANT ) - log10(MAX_AMPLITUDE);		//0==max  -8 is min==-160dB
-#else
-			mag = in.re*in.re+in.im*in.im;
-			//mag is power so 0.5 factor takes square root of power
-			mag = 0.5* log10( mag/(MAX_AMPLITUDE*MAX_AMPLITUDE) + 1e-16);	//clamped to -160dBfs
-#endif
+			//calc log magnitudes a block at a time
+			if( 0 == (i & MAGBUF_MASK) )
+				CalcLogMagnitudes( qMin(Length-i, MAX_DELAY_BUF), &pInData[i]);
+			mag = m_MagBuf[i & MAGBUF_MASK];
 //pOutData[i].re = 3000*mag;
 
-//pOutData[i].re = 1500*log10( ((delayedin.re*delayedin.re)+(delayedin.im*delayedin.im))/(MAX_AMPLITUDE*MAX_AMPLITUDE) + 1e-16);;
-
-			//create a sliding window of 'm_WindowSamples' magnitudes and output the peak value within the sliding window
-			TYPEREAL tmp = m_MagBuf[m_MagBufPos];	//get oldest mag sample from buffer into tmp
-			m_MagBuf[m_MagBufPos++] = mag;			//put latest mag sample in buffer;
-			if( m_MagBufPos >= m_WindowSamples)		//deal with magnitude buffer wrap around
-				m_MagBufPos = 0;
-			if(mag > m_Peak)
-			{
-				m_Peak = mag;	//if new sample is larger than current peak then use it, no need to look at buffer values
-			}
-			else
-			{
-				if(tmp == m_Peak)		//tmp is oldest sample pulled out of buffer
-				{	//if oldest sample pulled out was last peak then need to find next highest peak in buffer
-					m_Peak = -8.0;		//set to lowest value to find next max peak
-					//search all buffer for maximum value and set as new peak
-					for(int i=0; i<m_WindowSamples; i++)
-					{
-						tmp = m_MagBuf[i];
-						if(tmp > m_Peak)
-							m_Peak = tmp;
-					}
-				}
-			}
+			//output the peak value within a sliding window of 'm_WindowSamples' magnitudes
+			m_Peak = UpdatePeak(mag);
 
 //pOutData[i].im = 3000*m_Peak;
 
-			if(m_UseHang)
-			{	//using hang timer mode
-				if(m_Peak>m_AttackAve)	//if power is rising (use m_AttackRiseAlpha time constant)
-					m_AttackAve = (1.0-m_AttackRiseAlpha)*m_AttackAve + m_AttackRiseAlpha*m_Peak;
-				else					//else magnitude is falling (use  m_AttackFallAlpha time constant)
-					m_AttackAve = (1.0-m_AttackFallAlpha)*m_AttackAve + m_AttackFallAlpha*m_Peak;
-
-				if(m_Peak>m_DecayAve)	//if magnitude is rising (use m_DecayRiseAlpha time constant)
-				{
-					m_DecayAve = (1.0-m_DecayRiseAlpha)*m_DecayAve + m_DecayRiseAlpha*m_Peak;
-					m_HangTimer = 0;	//reset hang timer
-				}
-				else
-				{	//here if decreasing signal
-					if(m_HangTimer<m_HangTime)
-						m_HangTimer++;	//just inc and hold current m_DecayAve
-					else	//else decay with m_DecayFallAlpha which is RELEASE_TIMECONST
-						m_DecayAve = (1.0-m_DecayFallAlpha)*m_DecayAve + m_DecayFallAlpha*m_Peak;
-				}
-			}
-			else
-			{	//using exponential decay mode
-				// perform average of magnitude using 2 averagers each with separate rise and fall time constants
-				if(m_Peak>m_AttackAve)	//if magnitude is rising (use m_AttackRiseAlpha time constant)
-					m_AttackAve = (1.0-m_AttackRiseAlpha)*m_AttackAve + m_AttackRiseAlpha*m_Peak;
-				else					//else magnitude is falling (use  m_AttackFallAlpha time constant)
-					m_AttackAve = (1.0-m_AttackFallAlpha)*m_AttackAve + m_AttackFallAlpha*m_Peak;
-
-//pOutData[i].im = 3000*m_AttackAve;
-				if(m_Peak>m_DecayAve)	//if magnitude is rising (use m_DecayRiseAlpha time constant)
-					m_DecayAve = (1.0-m_DecayRiseAlpha)*m_DecayAve + m_DecayRiseAlpha*(m_Peak);
-				else					//else magnitude is falling (use m_DecayFallAlpha time constant)
-					m_DecayAve = (1.0-m_DecayFallAlpha)*m_DecayAve + m_DecayFallAlpha*(m_Peak);
-//pOutData[i].im = 3000*m_DecayAve;
-			}
-			//use greater magnitude of attack or Decay Averager
-			if(m_AttackAve>m_DecayAve)
-				mag = m_AttackAve;
-			else
-				mag = m_DecayAve;
-
-//pOutData[i].im = 3000*mag;
-			//calc gain depending on which side of knee the magnitude is on
-			if(mag<=m_Knee)		//use fixed gain if below knee
-				gain = m_FixedGain;
-			else				//use variable gain if above knee
-				gain = AGC_OUTSCALE * pow(10.0, mag*(m_GainSlope - 1.0) );
-//pOutData[i].re = .5*gain;
+			gain = CalcGain(m_Peak);
 			pOutData[i].re = delayedin.re * gain;
 			pOutData[i].im = delayedin.im * gain;
 		}
@@ -304,7 +510,11 @@ TYPEREAL gain;
 TYPEREAL mag;
 TYPEREAL delayedin;
 	m_Mutex.lock();
-	if(m_AgcOn)
+	if(m_AgcOn && (m_GainDecimation>1) )
+	{	//use block rate gain calculation
+		ProcessBlockGain(Length, pInData, pOutData);
+	}
+	else if(m_AgcOn)
 	{
 		for(int i=0; i<Length; i++)
 		{
@@ -317,78 +527,15 @@ TYPEREAL delayedin;
 			if( m_SigDelayPtr >= m_DelaySamples)	//deal with delay buffer wrap around
 				m_SigDelayPtr = 0;
 
-			//convert |mag| to log |mag|
-			mag = log10( fabs(in) + MIN_CONSTANT ) - log10(MAX_AMPLITUDE);		//0==max  -8 is min==-160dB
+			//calc log |mag| a block at a time
+			if( 0 == (i & MAGBUF_MASK) )
+				CalcLogMagnitudes( qMin(Length-i, MAX_DELAY_BUF), &pInData[i]);
+			mag = m_MagBuf[i & MAGBUF_MASK];
 
-			//create a sliding window of 'm_WindowSamples' magnitudes and output the peak value within the sliding window
-			TYPEREAL tmp = m_MagBuf[m_MagBufPos];	//get oldest mag sample from buffer into tmp
-			m_MagBuf[m_MagBufPos++] = mag;			//put latest mag sample in buffer;
-			if( m_MagBufPos >= m_WindowSamples)		//deal with magnitude buffer wrap around
-				m_MagBufPos = 0;
-			if(mag > m_Peak)
-			{
-				m_Peak = mag;	//if new sample is larger than current peak then use it, no need to look at buffer values
-			}
-			else
-			{
-				if(tmp == m_Peak)		//tmp is oldest sample pulled out of buffer
-				{	//if oldest sample pulled out was last peak then need to find next highest peak in buffer
-					m_Peak = -8.0;		//set to lowest value to find next max peak
-					//search all buffer for maximum value and set as new peak
-					for(int i=0; i<m_WindowSamples; i++)
-					{
-						tmp = m_MagBuf[i];
-						if(tmp > m_Peak)
-							m_Peak = tmp;
-					}
-				}
-			}
-
-			if(m_UseHang)
-			{	//using hang timer mode
-				if(m_Peak>m_AttackAve)	//if magnitude is rising (use m_AttackRiseAlpha time constant)
-					m_AttackAve = (1.0-m_AttackRiseAlpha)*m_AttackAve + m_AttackRiseAlpha*m_Peak;
-				else					//else magnitude is falling (use  m_AttackFallAlpha time constant)
-					m_AttackAve = (1.0-m_AttackFallAlpha)*m_AttackAve + m_AttackFallAlpha*m_Peak;
-
-				if(m_Peak>m_DecayAve)	//if magnitude is rising (use m_DecayRiseAlpha time constant)
-				{
-					m_DecayAve = (1.0-m_DecayRiseAlpha)*m_DecayAve + m_DecayRiseAlpha*m_Peak;
-					m_HangTimer = 0;	//reset hang timer
-				}
-				else
-				{	//here if decreasing signal
-					if(m_HangTimer<m_HangTime)
-						m_HangTimer++;	//just inc and hold current m_DecayAve
-					else	//else decay with m_DecayFallAlpha which is RELEASE_TIMECONST
-						m_DecayAve = (1.0-m_DecayFallAlpha)*m_DecayAve + m_DecayFallAlpha*m_Peak;
-				}
-			}
-			else
-			{	//using exponential decay mode
-				// perform average of magnitude using 2 averagers each with separate rise and fall time constants
-				if(m_Peak>m_AttackAve)	//if magnitude is rising (use m_AttackRiseAlpha time constant)
-					m_AttackAve = (1.0-m_AttackRiseAlpha)*m_AttackAve + m_AttackRiseAlpha*m_Peak;
-				else					//else magnitude is falling (use  m_AttackFallAlpha time constant)
-					m_AttackAve = (1.0-m_AttackFallAlpha)*m_AttackAve + m_AttackFallAlpha*m_Peak;
-
-				if(m_Peak>m_DecayAve)	//if magnitude is rising (use m_DecayRiseAlpha time constant)
-					m_DecayAve = (1.0-m_DecayRiseAlpha)*m_DecayAve + m_DecayRiseAlpha*(m_Peak);
-				else					//else magnitude is falling (use m_DecayFallAlpha time constant)
-					m_DecayAve = (1.0-m_DecayFallAlpha)*m_DecayAve + m_DecayFallAlpha*(m_Peak);
-			}
+			//output the peak value within a sliding window of 'm_WindowSamples' magnitudes
+			m_Peak = UpdatePeak(mag);
 
-			//use greater magnitude of attack or Decay Averager
-			if(m_AttackAve>m_DecayAve)
-				mag = m_AttackAve;
-			else
-				mag = m_DecayAve;
-
-			//calc gain depending on which side of knee the magnitude is on
-			if(mag<=m_Knee)		//use fixed gain if below knee
-				gain = m_FixedGain;
-			else				//use variable gain if above knee
-				gain = AGC_OUTSCALE * pow(10.0, mag*(m_GainSlope - 1.0) );
+			gain = CalcGain(m_Peak);
 			pOutData[i] = delayedin * gain;
 		}
 	}
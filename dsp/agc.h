@@ -14,6 +14,7 @@
 #include <QMutex>
 
 #define MAX_DELAY_BUF 2048
+#define AGC_GAIN_DECIMATION 16	//samples per gain calculation in block rate mode
 
 class CAgc
 {
@@ -23,8 +24,18 @@ public:
 	void SetParameters(bool AgcOn, bool UseHang, int Threshold, int ManualGain, int Slope, int Decay, TYPEREAL SampleRate);
 	void ProcessData(int Length, TYPECPX* pInData, TYPECPX* pOutData);
 	void ProcessData(int Length, TYPEREAL* pInData, TYPEREAL* pOutData);
+	void SetGainDecimation(int GainDecimation);
 
 private:
+	void CalcParameters();
+	TYPEREAL CalcGain(TYPEREAL peak);
+	void EndGainBlock();
+	void ProcessBlockGain(int Length, TYPECPX* pInData, TYPECPX* pOutData);
+	void ProcessBlockGain(int Length, TYPEREAL* pInData, TYPEREAL* pOutData);
+	void CalcLogMagnitudes(int Length, TYPECPX* pInData);
+	void CalcLogMagnitudes(int Length, TYPEREAL* pInData);
+	TYPEREAL UpdatePeak(TYPEREAL mag);
+
 	bool m_AgcOn;				//internal copy of AGC settings parameters
 	bool m_UseHang;
 	int m_Threshold;
@@ -48,17 +59,26 @@ private:
 	TYPEREAL m_Knee;
 	TYPEREAL m_GainSlope;
 	TYPEREAL m_Peak;
+	TYPEREAL m_BlockMax;	//largest linear magnitude in current gain block
+	TYPEREAL m_Gain;		//interpolated block rate gain
+	TYPEREAL m_GainStep;
 
 	int m_SigDelayPtr;
-	int m_MagBufPos;
+	int m_PeakQHead;		//monotonic queue of window peak candidates
+	int m_PeakQCount;
+	quint32 m_MagTime;		//running sample count for peak queue entries
 	int m_DelaySize;
 	int m_DelaySamples;
 	int m_WindowSamples;
 	int m_HangTime;
 	int m_HangTimer;
+	int m_GainDecimation;	//samples per gain calculation
+	int m_BlockPos;
 
 	QMutex m_Mutex;		//for keeping threads from stomping on each other
 	TYPECPX m_SigDelayBuf[MAX_DELAY_BUF];
-	TYPEREAL m_MagBuf[MAX_DELAY_BUF];
+	TYPEREAL m_MagBuf[MAX_DELAY_BUF];		//log magnitudes of current input block
+	TYPEREAL m_PeakQVal[MAX_DELAY_BUF];
+	quint32 m_PeakQTime[MAX_DELAY_BUF];
 };
 #endif //  AGCX_H
@@ -40,6 +40,15 @@
 #include "dsp/demodulator.h"
 #include "gui/testbench.h"
 #include <QDebug>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////
+// Local Defines
+//////////////////////////////////////////////////////////////////
+#define SQL_MIN_DBM -130.0	//squelch gate threshold at SquelchValue 1
+#define SQL_MAX_DBM -30.0	//squelch gate threshold at SquelchValue 99
+#define SQL_HYSTERESIS 2.0	//gate closes this many dB below threshold
+#define GATE_COST_ALPHA 0.05	//gated and open block cost averaging constant
 
 //////////////////////////////////////////////////////////////////
 //	Constructor/Destructor
@@ -47,15 +56,43 @@
 CDemodulator::CDemodulator()
 {
 	m_DesiredMaxOutputBandwidth = 48000.0;
+	m_InputRate = 48000.0;
 	m_OutputRate = 48000.0;
+	m_AudioRate = 48000.0;
 	m_pDemodInBuf = new TYPECPX[MAX_INBUFSIZE];
-	m_pDemodTmpBuf = new TYPECPX[MAX_INBUFSIZE];
+	m_pDemodIntBuf = new qint32[2*MAX_INBUFSIZE];
+	m_IntInput = false;
+	m_NROn = false;
+	m_NotchOn = false;
+	m_NRLevel = 50.0;
+	m_GateOn = false;
+	m_GateOpen = true;
+	m_AudioGated = false;
+	m_GateThreshold = SQL_MIN_DBM;
+	m_SilenceTime = 0.0;
+	m_BlockGated = false;
+	m_OpenCost = 0.0;
+	m_GatedCost = 0.0;
+	m_GatedCostPercent = 100;
+	m_GateTimer.start();
+	m_pZoomBuf = new TYPECPX[MAX_FFT_SIZE];
+	m_ZoomFftSize = 0;
+	m_ZoomBufPos = 0;
+	m_ZoomFrameCount = 0;
+	m_ZoomdBCompensation = 0.0;
+	m_CW_Offset = 0.0;
 	m_InBufPos = 0;
 	m_InBufLimit = 1000;
 	m_DemodMode = -1;
 	m_pAmDemod = NULL;
 	m_pSamDemod = NULL;
+	m_pFmDemod = NULL;
 	m_pSsbDemod = NULL;
+	m_pWFmDemod = NULL;
+	for(int i=0; i<NUM_DEMODS; i++)
+		m_DemodRate[i] = 0.0;
+	m_Agc.SetGainDecimation(AGC_GAIN_DECIMATION);
+	m_DownConvert.SetScratchArena(&m_Scratch);
 	SetDemodFreq(0.0);
 }
 
@@ -64,8 +101,10 @@ CDemodulator::~CDemodulator()
 	DeleteAllDemods();
 	if(m_pDemodInBuf)
 		delete m_pDemodInBuf;
-	if(m_pDemodTmpBuf)
-		delete m_pDemodTmpBuf;
+	if(m_pDemodIntBuf)
+		delete m_pDemodIntBuf;
+	if(m_pZoomBuf)
+		delete m_pZoomBuf;
 }
 
 //////////////////////////////////////////////////////////////////
@@ -81,10 +120,13 @@ void CDemodulator::DeleteAllDemods()
 		delete m_pFmDemod;
 	if(m_pSsbDemod)
 		delete m_pSsbDemod;
+	if(m_pWFmDemod)
+		delete m_pWFmDemod;
 	m_pAmDemod = NULL;
 	m_pSamDemod = NULL;
 	m_pFmDemod = NULL;
 	m_pSsbDemod = NULL;
+	m_pWFmDemod = NULL;
 }
 
 
@@ -96,7 +138,66 @@ void CDemodulator::SetInputSampleRate(TYPEREAL InputRate)
 	if(m_InputRate != InputRate)
 	{
 		m_InputRate = InputRate;
-		m_OutputRate = m_DownConvert.SetDataRate(m_InputRate, m_DesiredMaxOutputBandwidth);
+		TYPEREAL OutputRate = m_DownConvert.SetDataRate(m_InputRate, m_DesiredMaxOutputBandwidth);
+		m_Mutex.lock();
+		m_OutputRate = OutputRate;
+		UpdateZoomFftParams();
+		m_AudioRate = m_OutputRate;
+		if(DEMOD_WFM == m_DemodMode)
+		{	//WFM audio rate depends on its input rate so recreate it
+			delete m_pWFmDemod;
+			m_pWFmDemod = new CWFmDemod(m_OutputRate);
+			m_DemodRate[DEMOD_WFM] = m_OutputRate;
+			m_AudioRate = m_pWFmDemod->GetOutputRate();
+		}
+		m_Mutex.unlock();
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+//	Called to turn on/off the zoom spectrum and set its FFT size.
+// The zoom FFT runs on the tuned and decimated data stream so its
+// bin width is m_OutputRate/FftSize instead of InputRate/FftSize.
+//////////////////////////////////////////////////////////////////
+void CDemodulator::SetZoomFftSize(int FftSize, TYPEREAL dBCompensation)
+{
+	m_Mutex.lock();
+	if(FftSize > MAX_FFT_SIZE)
+		FftSize = MAX_FFT_SIZE;
+	if( (FftSize > 0) && (FftSize < MIN_FFT_SIZE) )
+		FftSize = MIN_FFT_SIZE;
+	m_ZoomFftSize = FftSize;
+	m_ZoomdBCompensation = dBCompensation;
+	UpdateZoomFftParams();
+	m_Mutex.unlock();
+}
+
+//////////////////////////////////////////////////////////////////
+//	Sets up the zoom FFT for the current decimated output rate.
+// (must be called with m_Mutex locked)
+//////////////////////////////////////////////////////////////////
+void CDemodulator::UpdateZoomFftParams()
+{
+	m_ZoomBufPos = 0;
+	if(m_ZoomFftSize)
+		m_ZoomFft.SetFFTParams(m_ZoomFftSize, FALSE, m_ZoomdBCompensation, m_OutputRate);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Collects decimated samples and performs a zoom FFT each time
+// a full FFT length has been accumulated.
+//////////////////////////////////////////////////////////////////
+void CDemodulator::ZoomFftInput(int InLength, TYPECPX* pInData)
+{
+	for(int i=0; i<InLength; i++)
+	{
+		m_pZoomBuf[m_ZoomBufPos++] = pInData[i];
+		if(m_ZoomBufPos >= m_ZoomFftSize)
+		{
+			m_ZoomFft.PutInDisplayFFT(m_ZoomFftSize, m_pZoomBuf);
+			m_ZoomFrameCount++;
+			m_ZoomBufPos = 0;
+		}
 	}
 }
 
@@ -106,48 +207,88 @@ void CDemodulator::SetInputSampleRate(TYPEREAL InputRate)
 //////////////////////////////////////////////////////////////////
 void CDemodulator::SetDemod(int Mode, tDemodInfo CurrentDemodInfo)
 {
+	bool NewMode = (m_DemodMode != Mode);
+	TYPEREAL OutputRate = m_OutputRate;
+	if(NewMode)
+	{	//create decimation chain and get output sample rate before taking
+		//m_Mutex since the DSP thread waits on it. CDownConvert builds the
+		//chain unlocked and swaps it in under its own lock.
+		if((DEMOD_LSB == Mode) || (DEMOD_CWL == Mode) )
+			m_DesiredMaxOutputBandwidth = -CurrentDemodInfo.LowCutmin;
+		else if(DEMOD_WFM == Mode)
+			m_DesiredMaxOutputBandwidth = WFM_DECIMATION_BW;
+		else
+			m_DesiredMaxOutputBandwidth = CurrentDemodInfo.HiCutmax;
+		OutputRate = m_DownConvert.SetDataRate(m_InputRate, m_DesiredMaxOutputBandwidth);
+	}
 	m_Mutex.lock();
 	m_DemodInfo = CurrentDemodInfo;
-	if(m_DemodMode != Mode)	//do only if changes
-	{
-		DeleteAllDemods();		//remove current demod object
+	if(NewMode)	//do only if changes
+	{	//demod objects are kept when switching modes so switching back is
+		//instant. One is only recreated if the rate it was built for changed.
 		m_DemodMode = Mode;
-		//create decimation chain and get output sample rate
-		if((DEMOD_LSB == m_DemodMode) || (DEMOD_CWL == m_DemodMode) )
-			m_DesiredMaxOutputBandwidth = -m_DemodInfo.LowCutmin;
-		else
-			m_DesiredMaxOutputBandwidth = m_DemodInfo.HiCutmax;
-		m_OutputRate = m_DownConvert.SetDataRate(m_InputRate, m_DesiredMaxOutputBandwidth);
-		//now create correct demodulator
+		m_OutputRate = OutputRate;
+		UpdateZoomFftParams();
+		m_AudioRate = m_OutputRate;
+		//now create correct demodulator if not already built at this rate
+		bool create = (m_DemodRate[m_DemodMode] != m_OutputRate);
+		m_DemodRate[m_DemodMode] = m_OutputRate;
 		switch(m_DemodMode)
 		{
 			case DEMOD_AM:
-				m_pAmDemod = new CAmDemod(m_OutputRate);
+				if(create && m_pAmDemod)
+					delete m_pAmDemod;
+				if(create || !m_pAmDemod)
+					m_pAmDemod = new CAmDemod(m_OutputRate);
 				break;
 			case DEMOD_SAM:
-				m_pSamDemod = new CSamDemod(m_OutputRate);
+				if(create && m_pSamDemod)
+					delete m_pSamDemod;
+				if(create || !m_pSamDemod)
+					m_pSamDemod = new CSamDemod(m_OutputRate);
 				break;
 			case DEMOD_FM:
-				m_pFmDemod = new CFmDemod(m_OutputRate);
+				if(create && m_pFmDemod)
+					delete m_pFmDemod;
+				if(create || !m_pFmDemod)
+					m_pFmDemod = new CFmDemod(m_OutputRate, &m_Scratch);
 				break;
 			case DEMOD_USB:
 			case DEMOD_LSB:
 			case DEMOD_CWU:
 			case DEMOD_CWL:
-				m_pSsbDemod = new CSsbDemod();
+				if(!m_pSsbDemod)
+					m_pSsbDemod = new CSsbDemod();
+				break;
+			case DEMOD_WFM:
+				if(create && m_pWFmDemod)
+					delete m_pWFmDemod;
+				if(create || !m_pWFmDemod)
+					m_pWFmDemod = new CWFmDemod(m_OutputRate);
+				m_AudioRate = m_pWFmDemod->GetOutputRate();
 				break;
 		}
 	}
 	m_CW_Offset = m_DemodInfo.Offset;
 	m_DownConvert.SetCwOffset(m_CW_Offset);
 	m_FastFIR.SetupParameters(m_DemodInfo.LowCut, m_DemodInfo.HiCut,m_CW_Offset,m_OutputRate);
+	UpdateFilterBinGain();
 	//set input buffer limit so that decimated output is abt 10mSec or more of data
 	m_InBufLimit = (m_OutputRate/100.0) * m_InputRate/m_OutputRate;	//process abt .01sec of output samples at a time
 	m_InBufLimit &= 0xFFFFFF00;	//keep modulo 256 since decimation is only in power of 2
 	m_Agc.SetParameters(m_DemodInfo.AgcOn, m_DemodInfo.AgcHangOn, m_DemodInfo.AgcThresh,
 						m_DemodInfo.AgcManualGain, m_DemodInfo.AgcSlope, m_DemodInfo.AgcDecay, m_OutputRate);
+	//level squelch gate for the AM and SSB modes.  FM is gated by its own
+	//noise squelch and WFM has no squelch.
+	m_GateOn = (m_DemodInfo.SquelchValue > 0) &&
+				(DEMOD_FM != m_DemodMode) && (DEMOD_WFM != m_DemodMode);
+	m_GateThreshold = SQL_MIN_DBM +
+				(SQL_MAX_DBM-SQL_MIN_DBM)*(TYPEREAL)m_DemodInfo.SquelchValue/99.0;
 	if(	m_pFmDemod != NULL)
+	{
 		m_pFmDemod->SetSquelch(m_DemodInfo.SquelchValue);
+		m_pFmDemod->SetFastDiscriminator(m_DemodInfo.FmFastDisc);
+	}
 	if(m_pAmDemod != NULL)
 		m_pAmDemod->SetBandwidth( (m_DemodInfo.HiCut-m_DemodInfo.LowCut)/2.0);
 
@@ -156,14 +297,118 @@ void CDemodulator::SetDemod(int Mode, tDemodInfo CurrentDemodInfo)
 //qDebug()<<"m_InBufLimit="<<m_InBufLimit;
 }
 
+//////////////////////////////////////////////////////////////////
+//	Called to change the spectral noise reduction and auto notch
+// settings of the channel filter.  NRLevel is 0 to 99.
+//////////////////////////////////////////////////////////////////
+void CDemodulator::SetupNoiseReduction(bool NROn, TYPEREAL NRLevel, bool NotchOn)
+{
+	m_Mutex.lock();
+	m_NROn = NROn;
+	m_NRLevel = NRLevel;
+	m_NotchOn = NotchOn;
+	UpdateFilterBinGain();
+	m_Mutex.unlock();
+}
+
+//////////////////////////////////////////////////////////////////
+//	Sets the channel filter bin gains for the current demod mode.
+// FM discriminators need the whole signal and a CW signal is itself
+//a steady carrier so those modes skip the parts that would harm them.
+// Called with m_Mutex locked.
+//////////////////////////////////////////////////////////////////
+void CDemodulator::UpdateFilterBinGain()
+{
+	bool NROn = m_NROn && (DEMOD_FM != m_DemodMode) && (DEMOD_WFM != m_DemodMode);
+	bool NotchOn = m_NotchOn && ( (DEMOD_AM == m_DemodMode) || (DEMOD_SAM == m_DemodMode) ||
+								(DEMOD_USB == m_DemodMode) || (DEMOD_LSB == m_DemodMode) );
+	m_FastFIR.SetupBinGain(NROn, m_NRLevel, NotchOn);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Returns the most audio samples ProcessData() can return for
+// InLength input samples with the current settings.
+//////////////////////////////////////////////////////////////////
+int CDemodulator::GetMaxOutputLength(int InLength)
+{
+	m_Mutex.lock();
+	//number of demod blocks that can complete during one call
+	int blocks = (m_InBufLimit > 0) ? (InLength/m_InBufLimit + 1) : (InLength + 1);
+	int n = blocks*( (int)(m_InBufLimit*m_OutputRate/m_InputRate) + 1);
+	m_Mutex.unlock();
+	return m_FastFIR.GetMaxOutputLength(n);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Returns the scratch arena bytes used while processing one demod
+// block.  The decimator buffer is given back before the filter output
+// buffer is taken.
+//////////////////////////////////////////////////////////////////
+int CDemodulator::GetScratchBytes()
+{
+	m_Mutex.lock();
+	int n = m_FastFIR.GetMaxOutputLength( (int)(m_InBufLimit*m_OutputRate/m_InputRate) + 1);
+	int bytes = CScratchArena::AlignedSize(n*sizeof(TYPECPX));
+	if(DEMOD_FM == m_DemodMode)
+		bytes += CFmDemod::GetScratchBytes(n);
+	int dcbytes = m_DownConvert.GetScratchBytes(m_InBufLimit);
+	m_Mutex.unlock();
+	return (dcbytes > bytes) ? dcbytes : bytes;
+}
+
 //////////////////////////////////////////////////////////////////
 //	Called with complex data from radio and performs the demodulation
 // with MONO audio output
 //////////////////////////////////////////////////////////////////
 int CDemodulator::ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData)
+{
+	return BufferData(InLength, pInData, pOutData);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Called with complex data from radio and performs the demodulation
+// with STEREO audio output
+//////////////////////////////////////////////////////////////////
+int CDemodulator::ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
+{
+	return BufferData(InLength, pInData, pOutData);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Called with raw interleaved I/Q integers from radio and performs
+// the demodulation with MONO audio output.  Scale converts the data
+// to the +-32768 range.
+//////////////////////////////////////////////////////////////////
+int CDemodulator::ProcessData(int InLength, const qint32* pInData, TYPEREAL Scale, TYPEREAL* pOutData)
+{
+	return BufferData(InLength, pInData, Scale, pOutData);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Called with raw interleaved I/Q integers from radio and performs
+// the demodulation with STEREO audio output
+//////////////////////////////////////////////////////////////////
+int CDemodulator::ProcessData(int InLength, const qint32* pInData, TYPEREAL Scale, TYPECPX* pOutData)
+{
+	return BufferData(InLength, pInData, Scale, pOutData);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Collects complex input samples and runs a demod block each time
+// m_InBufLimit samples are available.
+//////////////////////////////////////////////////////////////////
+template <class T>
+int CDemodulator::BufferData(int InLength, TYPECPX* pInData, T* pOutData)
 {
 int ret = 0;
 	m_Mutex.lock();
+	m_AudioGated = true;	//cleared by any block that is not squelched
+	if(m_IntInput)
+	{	//partial block is integer data so throw it away
+		m_IntInput = false;
+		m_InBufPos = 0;
+		m_DownConvert.ResetChain();
+	}
 	for(int i=0; i<InLength; i++)
 	{	//place in demod buffer
 		m_pDemodInBuf[m_InBufPos++] = pInData[i];
@@ -172,42 +417,10 @@ int ret = 0;
 
 			//perform baseband tuning and decimation
 			int n = m_DownConvert.ProcessData(m_InBufPos, m_pDemodInBuf, m_pDemodInBuf);
-			g_pTestBench->DisplayData(n, m_pDemodInBuf, m_OutputRate,PROFILE_1);
-
-
-			//perform main bandpass filtering
-			n = m_FastFIR.ProcessData(n, m_pDemodInBuf, m_pDemodTmpBuf);
-			g_pTestBench->DisplayData(n, m_pDemodTmpBuf, m_OutputRate,PROFILE_2);
-
-			//perform S-Meter processing
-			m_SMeter.ProcessData(n, m_pDemodTmpBuf, m_OutputRate);
-
-			//perform AGC
-			m_Agc.ProcessData(n, m_pDemodTmpBuf, m_pDemodTmpBuf );
-			g_pTestBench->DisplayData(n, m_pDemodTmpBuf, m_OutputRate, PROFILE_3);
-
-			//perform the desired demod action
-			switch(m_DemodMode)
-			{
-				case DEMOD_AM:
-					n = m_pAmDemod->ProcessData(n, m_pDemodTmpBuf, pOutData );
-					break;
-				case DEMOD_SAM:
-					n = m_pSamDemod->ProcessData(n, m_pDemodTmpBuf, pOutData );
-					break;
-				case DEMOD_FM:
-					n = m_pFmDemod->ProcessData(n, m_DemodInfo.HiCut, m_pDemodTmpBuf, pOutData );
-					break;
-				case DEMOD_USB:
-				case DEMOD_LSB:
-				case DEMOD_CWU:
-				case DEMOD_CWL:
-					n = m_pSsbDemod->ProcessData(n, m_pDemodTmpBuf, pOutData);
-					break;
-			}
-			g_pTestBench->DisplayData(n, pOutData, m_OutputRate,PROFILE_4);
 			m_InBufPos = 0;
-			ret += n;
+			qint64 start = m_GateTimer.nsecsElapsed();
+			ret += ProcessBlock(n, &pOutData[ret]);
+			UpdateGateCost(n, m_GateTimer.nsecsElapsed() - start);
 		}
 	}
 	m_Mutex.unlock();
@@ -215,59 +428,281 @@ int ret = 0;
 }
 
 //////////////////////////////////////////////////////////////////
-//	Called with complex data from radio and performs the demodulation
-// with STEREO audio output
+//	Collects raw integer input samples and runs a demod block each
+// time m_InBufLimit samples are available.  The down converter does
+// the tuning and first decimation stages in integer.
 //////////////////////////////////////////////////////////////////
-int CDemodulator::ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
+template <class T>
+int CDemodulator::BufferData(int InLength, const qint32* pInData, TYPEREAL Scale, T* pOutData)
 {
 int ret = 0;
 	m_Mutex.lock();
+	m_AudioGated = true;	//cleared by any block that is not squelched
+	if(!m_IntInput)
+	{	//partial block is floating point data so throw it away
+		m_IntInput = true;
+		m_InBufPos = 0;
+		m_DownConvert.ResetChain();
+	}
 	for(int i=0; i<InLength; i++)
 	{	//place in demod buffer
-		m_pDemodInBuf[m_InBufPos++] = pInData[i];
+		m_pDemodIntBuf[2*m_InBufPos] = pInData[2*i];
+		m_pDemodIntBuf[2*m_InBufPos+1] = pInData[2*i+1];
+		m_InBufPos++;
 		if(m_InBufPos >= m_InBufLimit)
 		{	//when have enough samples, call demod routine sequence
 
 			//perform baseband tuning and decimation
-			int n = m_DownConvert.ProcessData(m_InBufPos, m_pDemodInBuf, m_pDemodInBuf);
-			g_pTestBench->DisplayData(n, m_pDemodInBuf, m_OutputRate,PROFILE_1);
-
-
-			//perform main bandpass filtering
-			n = m_FastFIR.ProcessData(n, m_pDemodInBuf, m_pDemodTmpBuf);
-			g_pTestBench->DisplayData(n, m_pDemodTmpBuf, m_OutputRate,PROFILE_2);
-
-			//perform S-Meter processing
-			m_SMeter.ProcessData(n, m_pDemodTmpBuf, m_OutputRate);
-
-			//perform AGC
-			m_Agc.ProcessData(n, m_pDemodTmpBuf, m_pDemodTmpBuf );
-			g_pTestBench->DisplayData(n, m_pDemodTmpBuf, m_OutputRate, PROFILE_3);
-
-			//perform the desired demod action
-			switch(m_DemodMode)
-			{
-				case DEMOD_AM:
-					n = m_pAmDemod->ProcessData(n, m_pDemodTmpBuf, pOutData );
-					break;
-				case DEMOD_SAM:
-					n = m_pSamDemod->ProcessData(n, m_pDemodTmpBuf, pOutData );
-					break;
-				case DEMOD_FM:
-					n = m_pFmDemod->ProcessData(n, m_DemodInfo.HiCut, m_pDemodTmpBuf, pOutData );
-					break;
-				case DEMOD_USB:
-				case DEMOD_LSB:
-				case DEMOD_CWU:
-				case DEMOD_CWL:
-					n = m_pSsbDemod->ProcessData(n, m_pDemodTmpBuf, pOutData);
-					break;
-			}
-		g_pTestBench->DisplayData(n, pOutData, m_OutputRate,PROFILE_4);
+			int n = m_DownConvert.ProcessData(m_InBufPos, m_pDemodIntBuf, Scale, m_pDemodInBuf);
 			m_InBufPos = 0;
-			ret += n;
+			qint64 start = m_GateTimer.nsecsElapsed();
+			ret += ProcessBlock(n, &pOutData[ret]);
+			UpdateGateCost(n, m_GateTimer.nsecsElapsed() - start);
 		}
 	}
 	m_Mutex.unlock();
 	return ret;
 }
+
+//////////////////////////////////////////////////////////////////
+//	Filters and demodulates 'InLength' decimated samples in
+// m_pDemodInBuf with MONO audio output.  Mono SSB and CW only use the
+// real part of the filtered signal so only that is calculated.
+//////////////////////////////////////////////////////////////////
+int CDemodulator::ProcessBlock(int InLength, TYPEREAL* pOutData)
+{
+	switch(m_DemodMode)
+	{
+		case DEMOD_USB:
+		case DEMOD_LSB:
+		case DEMOD_CWU:
+		case DEMOD_CWL:
+			return ProcessRealBlock(InLength, pOutData);
+	}
+	return ProcessCpxBlock(InLength, pOutData);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Filters and demodulates 'InLength' decimated samples in
+// m_pDemodInBuf.  Returns number of audio samples put in pOutData.
+//////////////////////////////////////////////////////////////////
+template <class T>
+int CDemodulator::ProcessCpxBlock(int InLength, T* pOutData)
+{
+int n = InLength;
+	g_pTestBench->DisplayData(n, m_pDemodInBuf, m_OutputRate,PROFILE_1);
+	if(m_ZoomFftSize)
+		ZoomFftInput(n, m_pDemodInBuf);
+
+	int mark = m_Scratch.GetMark();
+	TYPECPX* pTmpBuf = m_Scratch.Alloc<TYPECPX>(m_FastFIR.GetMaxOutputLength(n));
+	//perform main bandpass filtering
+	n = m_FastFIR.ProcessData(n, m_pDemodInBuf, pTmpBuf);
+	g_pTestBench->DisplayData(n, pTmpBuf, m_OutputRate,PROFILE_2);
+
+	//perform S-Meter processing
+	m_SMeter.ProcessData(n, pTmpBuf, m_OutputRate);
+
+	//skip AGC and demod if squelched.  FM is gated by its noise squelch
+	//state from the last block and only runs the detector while closed.
+	eGate gate = UpdateSquelchGate();
+	if( (DEMOD_FM == m_DemodMode) && m_pFmDemod->IsSquelched() )
+	{
+		m_pFmDemod->UpdateSquelch(n, m_DemodInfo.HiCut, pTmpBuf);
+		gate = GATE_CLOSED;
+	}
+	m_GateTotal.fetchAndAddRelaxed(n);
+	m_BlockGated = (GATE_CLOSED == gate);
+	if(m_BlockGated)
+	{
+		m_GateSkipped.fetchAndAddRelaxed(n);
+		n = GatedSilence(n, pOutData);
+		m_Scratch.Release(mark);
+		return n;
+	}
+
+	//perform AGC
+	m_Agc.ProcessData(n, pTmpBuf, pTmpBuf );
+	g_pTestBench->DisplayData(n, pTmpBuf, m_OutputRate, PROFILE_3);
+
+	//perform the desired demod action
+	switch(m_DemodMode)
+	{
+		case DEMOD_AM:
+			n = m_pAmDemod->ProcessData(n, pTmpBuf, pOutData );
+			break;
+		case DEMOD_SAM:
+			n = m_pSamDemod->ProcessData(n, pTmpBuf, pOutData );
+			break;
+		case DEMOD_FM:
+			n = m_pFmDemod->ProcessData(n, m_DemodInfo.HiCut, pTmpBuf, pOutData );
+			break;
+		case DEMOD_USB:
+		case DEMOD_LSB:
+		case DEMOD_CWU:
+		case DEMOD_CWL:
+			n = m_pSsbDemod->ProcessData(n, pTmpBuf, pOutData);
+			break;
+		case DEMOD_WFM:
+			n = m_pWFmDemod->ProcessData(n, pTmpBuf, pOutData);
+			break;
+	}
+	//the FM noise squelch zeroes the audio of the block it closes on
+	if( (DEMOD_FM != m_DemodMode) || !m_pFmDemod->IsSquelched() )
+		m_AudioGated = false;
+	if(GATE_OPEN != gate)
+		RampAudio(n, pOutData, GATE_OPENING == gate);
+	g_pTestBench->DisplayData(n, pOutData, m_AudioRate,PROFILE_4);
+	m_Scratch.Release(mark);
+	return n;
+}
+
+//////////////////////////////////////////////////////////////////
+//	Mono SSB and CW version of ProcessBlock().  The main filter only
+// calculates the real part of its output which goes straight into
+// pOutData, so the reverse FFT, S-Meter and AGC do half the work.
+//////////////////////////////////////////////////////////////////
+int CDemodulator::ProcessRealBlock(int InLength, TYPEREAL* pOutData)
+{
+int n = InLength;
+	g_pTestBench->DisplayData(n, m_pDemodInBuf, m_OutputRate,PROFILE_1);
+	if(m_ZoomFftSize)
+		ZoomFftInput(n, m_pDemodInBuf);
+
+	//perform main bandpass filtering
+	n = m_FastFIR.ProcessData(n, m_pDemodInBuf, pOutData);
+	g_pTestBench->DisplayData(n, pOutData, m_OutputRate,PROFILE_2);
+
+	//perform S-Meter processing
+	m_SMeter.ProcessData(n, pOutData, m_OutputRate);
+
+	//skip AGC and demod if squelched
+	eGate gate = UpdateSquelchGate();
+	m_GateTotal.fetchAndAddRelaxed(n);
+	m_BlockGated = (GATE_CLOSED == gate);
+	if(m_BlockGated)
+	{
+		m_GateSkipped.fetchAndAddRelaxed(n);
+		return GatedSilence(n, pOutData);
+	}
+	m_AudioGated = false;
+
+	//perform AGC
+	m_Agc.ProcessData(n, pOutData, pOutData );
+	g_pTestBench->DisplayData(n, pOutData, m_OutputRate, PROFILE_3);
+
+	n = m_pSsbDemod->ProcessData(n, pOutData, pOutData);
+	if(GATE_OPEN != gate)
+		RampAudio(n, pOutData, GATE_OPENING == gate);
+	g_pTestBench->DisplayData(n, pOutData, m_AudioRate,PROFILE_4);
+	return n;
+}
+
+//////////////////////////////////////////////////////////////////
+//	Opens or closes the squelch gate from the S-Meter average of the
+// filtered signal.  The average has a fast attack and slow decay so it
+// also gives the gate its hang time.  Returns GATE_OPENING or
+// GATE_CLOSING for the one block that is faded in or out.
+//////////////////////////////////////////////////////////////////
+CDemodulator::eGate CDemodulator::UpdateSquelchGate()
+{
+	bool WasOpen = m_GateOpen;
+	if(!m_GateOn)
+	{
+		m_GateOpen = true;
+	}
+	else
+	{
+		TYPEREAL level = m_SMeter.GetAve();
+		if(m_GateOpen)
+		{
+			if(level < (m_GateThreshold-SQL_HYSTERESIS))
+				m_GateOpen = false;
+		}
+		else if(level >= m_GateThreshold)
+		{
+			m_GateOpen = true;
+		}
+	}
+	if(m_GateOpen)
+		return WasOpen ? GATE_OPEN : GATE_OPENING;
+	return WasOpen ? GATE_CLOSING : GATE_CLOSED;
+}
+
+//////////////////////////////////////////////////////////////////
+//	Places the silence for 'InLength' squelched filter output samples
+// in pOutData.  The channel filter and S-Meter keep running but the AGC
+// and demod objects are left as they were when the gate closed.
+//////////////////////////////////////////////////////////////////
+template <class T>
+int CDemodulator::GatedSilence(int InLength, T* pOutData)
+{
+	m_SilenceTime += (TYPEREAL)InLength*m_AudioRate/m_OutputRate;
+	int n = (int)m_SilenceTime;
+	m_SilenceTime -= (TYPEREAL)n;
+	memset(pOutData, 0, n*sizeof(T));
+	return n;
+}
+
+//////////////////////////////////////////////////////////////////
+//	Linear fade in(Up) or out of one block of audio so the squelch
+// gate opens and closes without a click.
+//////////////////////////////////////////////////////////////////
+void CDemodulator::RampAudio(int Length, TYPEREAL* pData, bool Up)
+{
+	TYPEREAL step = 1.0/(TYPEREAL)Length;
+	for(int i=0; i<Length; i++)
+	{
+		TYPEREAL g = step*(TYPEREAL)i;
+		pData[i] *= Up ? g : (1.0-g);
+	}
+}
+
+void CDemodulator::RampAudio(int Length, TYPECPX* pData, bool Up)
+{
+	TYPEREAL step = 1.0/(TYPEREAL)Length;
+	for(int i=0; i<Length; i++)
+	{
+		TYPEREAL g = step*(TYPEREAL)i;
+		if(!Up)
+			g = 1.0-g;
+		pData[i].re *= g;
+		pData[i].im *= g;
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+//	Averages the processing time per sample of gated and open blocks.
+// Gated blocks still run the channel filter, S-Meter and FM squelch
+// detector so only the difference between the two is saved.
+//////////////////////////////////////////////////////////////////
+void CDemodulator::UpdateGateCost(int Length, qint64 Time)
+{
+	if(Length <= 0)
+		return;
+	TYPEREAL cost = (TYPEREAL)Time/(TYPEREAL)Length;
+	TYPEREAL& ave = m_BlockGated ? m_GatedCost : m_OpenCost;
+	if(ave <= 0.0)
+		ave = cost;
+	else
+		ave += GATE_COST_ALPHA*(cost - ave);
+	if( (m_OpenCost > 0.0) && (m_GatedCost > 0.0) )
+		m_GatedCostPercent = (qint32)(100.0*qMin(m_GatedCost/m_OpenCost, 1.0) + 0.5);
+}
+
+//////////////////////////////////////////////////////////////////
+//	Returns the percent of the demod block processing time the squelch
+// saved since the last call.  The squelched share of the signal is
+// scaled by the measured saving of a gated block against an open one.
+// Until both have been timed no saving is reported.  Called from the
+// GUI thread so the counters are swapped out atomically.
+//////////////////////////////////////////////////////////////////
+qint32 CDemodulator::GetGatedPercent()
+{
+	qint32 skipped = m_GateSkipped.fetchAndStoreOrdered(0);
+	qint32 total = m_GateTotal.fetchAndStoreOrdered(0);
+	if(total <= 0)
+		return 0;
+	qint64 saved = (qint64)skipped*(100 - m_GatedCostPercent);
+	return qMin( (qint32)(saved/total), 100);
+}
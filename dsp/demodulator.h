@@ -10,12 +10,16 @@
 
 #include "dsp/downconvert.h"
 #include "dsp/fastfir.h"
+#include "dsp/fft.h"
 #include "smeter.h"
 #include "dsp/agc.h"
 #include "dsp/amdemod.h"
 #include "dsp/samdemod.h"
 #include "dsp/fmdemod.h"
 #include "dsp/ssbdemod.h"
+#include "dsp/wfmdemod.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
 
 #define DEMOD_AM 0		//defines for supported demod modes
 #define DEMOD_SAM 1
@@ -24,8 +28,9 @@
 #define DEMOD_LSB 4
 #define DEMOD_CWU 5
 #define DEMOD_CWL 6
+#define DEMOD_WFM 7
 
-#define NUM_DEMODS 7	//manually update if modify number of demod types
+#define NUM_DEMODS 8	//manually update if modify number of demod types
 
 #define MAX_INBUFSIZE 250000	//maximum size of demod input buffer
 								//pick so that worst case decimation leaves
@@ -49,6 +54,7 @@ typedef struct _sdmd
 	int AgcDecay;
 	bool AgcOn;
 	bool AgcHangOn;
+	bool FmFastDisc;	//use delay line discriminator for FM
 	bool Symetric;	//not saved in settings
 	QString txt;	//not saved in settings
 }tDemodInfo;
@@ -60,33 +66,99 @@ public:
 	virtual ~CDemodulator();
 
 	void SetInputSampleRate(TYPEREAL InputRate);
-	double GetOutputRate(){return m_OutputRate;}
+	double GetOutputRate(){return m_AudioRate;}
 	double GetSMeterPeak(){return m_SMeter.GetPeak();}
 	double GetSMeterAve(){return m_SMeter.GetAve();}
 
 	void SetDemod(int Mode, tDemodInfo CurrentDemodInfo);
 	void SetDemodFreq(TYPEREAL Freq){m_DownConvert.SetCwOffset(m_CW_Offset);
 										m_DownConvert.SetFrequency(Freq);}
+	//spectral noise reduction and auto notch done in the channel filter
+	void SetupNoiseReduction(bool NROn, TYPEREAL NRLevel, bool NotchOn);
+	//squelch gate after the channel filter
+	bool IsAudioGated(){return m_AudioGated;}	//last ProcessData() output is all silence
+	qint32 GetGatedPercent();	//percent of demod time saved by the squelch since last call
 
 	//overloaded functions to perform demod mono or stereo
 	int ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData);
 	int ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
+	//integer front end versions for raw interleaved I/Q radio data
+	int ProcessData(int InLength, const qint32* pInData, TYPEREAL Scale, TYPEREAL* pOutData);
+	int ProcessData(int InLength, const qint32* pInData, TYPEREAL Scale, TYPECPX* pOutData);
+	bool HasIntFrontEnd(){return m_DownConvert.HasIntFrontEnd();}
+
+	//scratch arena shared by the pipeline stages and the audio output
+	CScratchArena* GetScratchArena(){return &m_Scratch;}
+	int GetMaxOutputLength(int InLength);
+	int GetScratchBytes();
+
+	//zoom spectrum of the decimated baseband stream(FftSize==0 turns it off)
+	void SetZoomFftSize(int FftSize, TYPEREAL dBCompensation);
+	int GetZoomFftSize(){return m_ZoomFftSize;}
+	TYPEREAL GetZoomSampleRate(){return m_OutputRate;}
+	TYPEREAL GetZoomCenterOffset(){return -m_CW_Offset;}
+	qint32 GetZoomFrameCount(){return m_ZoomFrameCount;}
+	bool GetScreenIntegerZoomFFTData(qint32 MaxHeight, qint32 MaxWidth,
+									double MaxdB, double MindB,
+									qint32 StartFreq, qint32 StopFreq,
+									qint32* OutBuf )
+			{ return m_ZoomFft.GetScreenIntegerFFTData(MaxHeight, MaxWidth,
+									MaxdB, MindB, StartFreq, StopFreq, OutBuf); }
 
 private:
 	void DeleteAllDemods();
+	void UpdateZoomFftParams();
+	void UpdateFilterBinGain();
+	enum eGate {GATE_OPEN, GATE_OPENING, GATE_CLOSING, GATE_CLOSED};
+	eGate UpdateSquelchGate();
+	template <class T> int GatedSilence(int InLength, T* pOutData);
+	void UpdateGateCost(int Length, qint64 Time);
+	void RampAudio(int Length, TYPEREAL* pData, bool Up);
+	void RampAudio(int Length, TYPECPX* pData, bool Up);
+	void ZoomFftInput(int InLength, TYPECPX* pInData);
+	template <class T> int BufferData(int InLength, TYPECPX* pInData, T* pOutData);
+	template <class T> int BufferData(int InLength, const qint32* pInData, TYPEREAL Scale, T* pOutData);
+	int ProcessBlock(int InLength, TYPEREAL* pOutData);
+	int ProcessBlock(int InLength, TYPECPX* pOutData){return ProcessCpxBlock(InLength, pOutData);}
+	template <class T> int ProcessCpxBlock(int InLength, T* pOutData);
+	int ProcessRealBlock(int InLength, TYPEREAL* pOutData);
+	CScratchArena m_Scratch;
 	CDownConvert m_DownConvert;
 	CFastFIR m_FastFIR;
 	CAgc m_Agc;
 	CSMeter m_SMeter;
+	CFft m_ZoomFft;
 	QMutex m_Mutex;		//for keeping threads from stomping on each other
 	tDemodInfo m_DemodInfo;
 	TYPEREAL m_InputRate;
 	TYPEREAL m_OutputRate;
+	TYPEREAL m_AudioRate;		//demod output rate(differs from m_OutputRate for WFM)
 	TYPEREAL m_DesiredMaxOutputBandwidth;
 	TYPECPX* m_pDemodInBuf;
-	TYPECPX* m_pDemodTmpBuf;
+	qint32* m_pDemodIntBuf;		//interleaved I/Q for the integer front end
+	bool m_IntInput;			//m_InBufPos counts integer samples
+	bool m_NROn;
+	bool m_NotchOn;
+	TYPEREAL m_NRLevel;
+	bool m_GateOn;
+	bool m_GateOpen;
+	bool m_AudioGated;
+	TYPEREAL m_GateThreshold;	//S-Meter dBm that opens the gate
+	TYPEREAL m_SilenceTime;		//fractional silent output samples
+	QAtomicInt m_GateTotal;		//filter output samples since GetGatedPercent()
+	QAtomicInt m_GateSkipped;	//those that were squelched
+	QElapsedTimer m_GateTimer;	//times each demod block
+	bool m_BlockGated;			//last demod block skipped the AGC and demod
+	TYPEREAL m_OpenCost;		//average nSec per sample of open blocks
+	TYPEREAL m_GatedCost;		//average nSec per sample of gated blocks
+	volatile qint32 m_GatedCostPercent;	//gated block cost in percent of an open one
 	TYPEREAL m_CW_Offset;
+	TYPEREAL m_ZoomdBCompensation;
+	TYPECPX* m_pZoomBuf;
 	int m_DemodMode;
+	int m_ZoomFftSize;
+	int m_ZoomBufPos;
+	qint32 m_ZoomFrameCount;
 	int m_InBufPos;
 	int m_InBufLimit;
 	int m_AGClength;
@@ -97,6 +169,8 @@ private:
 	CSamDemod* m_pSamDemod;
 	CFmDemod* m_pFmDemod;
 	CSsbDemod* m_pSsbDemod;	//includes CW modes
+	CWFmDemod* m_pWFmDemod;
+	TYPEREAL m_DemodRate[NUM_DEMODS];	//rate each demod object was built for
 };
 
 #endif // DEMODULATOR_H
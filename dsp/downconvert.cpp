@@ -51,7 +51,18 @@
 
 #define MIN_OUTPUT_RATE (7900.0*2.0)
 
-#define MAX_HALF_BAND_BUFSIZE 32768
+#define INTFE_MAX_STAGES 8		//max decimate by 2 stages done by the integer front end CIC
+
+#define INTFE_NCO_BITS 14		//integer NCO table address bits, worst spur measured -89dBc
+#define INTFE_NCO_AMPL 32767.0	//integer NCO table amplitude
+#define INTFE_MIX_SHIFT 8		//mixer output right shift, 24 bit data stays in 32 bits
+#define INTFE_NCO_GAIN 0.974679	//sqrt(.95), level the quadrature oscillator settles to
+#define INTFE_NCO_QUARTER ((quint64)1<<62)	//quarter cycle of the 64 bit NCO phase
+#define INTFE_NCO_ROUND ((quint64)1<<(63-INTFE_NCO_BITS))	//half a table step
+
+//sine table shared by all integer front end NCOs
+static bool IntNcoTableBuilt = false;
+static qint16 IntNcoTable[1<<INTFE_NCO_BITS];
 
 
 //////////////////////////////////////////////////////////////////////
@@ -66,30 +77,69 @@ int i;
 	m_CW_Offset = 0.0;
 	m_InRate = 100000.0;
 	m_MaxBW = 10000.0;
-	for(i=0; i<MAX_DECSTAGES; i++)
-		m_pDecimatorPtrs[i] = NULL;
+	m_pScratch = NULL;
+	m_ChainUseCount = 0;
+	for(int j=0; j<DECCHAIN_CACHE_SIZE; j++)
+	{
+		m_ChainCache[j].LastUse = 0;
+		m_ChainCache[j].IntStages = 0;
+		m_ChainCache[j].IntSkip = 0;
+		m_ChainCache[j].PrimeLength = 0;
+		for(i=0; i<MAX_DECSTAGES; i++)
+			m_ChainCache[j].pStages[i] = NULL;
+	}
+	m_pDecimatorPtrs = m_ChainCache[0].pStages;
+	m_PrimeChain = false;
+	m_PrimeNeed = 0;
+	m_PrimeLength = 0;
+	m_PrimeBufSize = 0;
+	m_pPrimeBuf = NULL;
+	m_IntStages = 0;
+	m_IntSkip = 0;
+	m_IntNcoPhase = 0;
+	m_IntNcoInc = 0;
+	m_IntRatio = 0;
+	m_IntPhase = 0;
 	m_Osc1.re = 1.0;	//initialize unit vector that will get rotated
 	m_Osc1.im = 0.0;
+	if(!IntNcoTableBuilt)
+	{
+		IntNcoTableBuilt = true;
+		for(i=0; i<(1<<INTFE_NCO_BITS); i++)
+			IntNcoTable[i] = (qint16)floor(INTFE_NCO_AMPL*sin(K_2PI*i/(1<<INTFE_NCO_BITS)) + 0.5);
+	}
 }
 
 CDownConvert::~CDownConvert()
 {
 	DeleteFilters();
+	if(m_pPrimeBuf)
+		delete[] m_pPrimeBuf;
 }
 
 //////////////////////////////////////////////////////////////////////
-// Delete all active Filters in m_pDecimatorPtrs array
+// Delete all Filters in every cached decimation chain
 //////////////////////////////////////////////////////////////////////
 void CDownConvert::DeleteFilters()
+{
+	for(int i=0; i<DECCHAIN_CACHE_SIZE; i++)
+		DeleteChain(&m_ChainCache[i]);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Delete all Filters in one decimation chain
+//////////////////////////////////////////////////////////////////////
+void CDownConvert::DeleteChain(tDecChain* pChain)
 {
 	for(int i=0; i<MAX_DECSTAGES; i++)
 	{
-		if(m_pDecimatorPtrs[i])
+		if(pChain->pStages[i])
 		{
-			delete m_pDecimatorPtrs[i];
-			m_pDecimatorPtrs[i] = NULL;
+			delete pChain->pStages[i];
+			pChain->pStages[i] = NULL;
 		}
 	}
+	pChain->LastUse = 0;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -103,6 +153,13 @@ TYPEREAL tmpf = NcoFreq + m_CW_Offset;
 	m_NcoInc = K_2PI*m_NcoFreq/m_InRate;
 	m_OscCos = cos(m_NcoInc);
 	m_OscSin = sin(m_NcoInc);
+	//integer NCO phase step, 2^64 is one cycle.  Split in two 32 bit
+	//halves since a double only holds 53 bits.
+	TYPEREAL cycles = m_NcoFreq/m_InRate;
+	cycles -= floor(cycles);
+	TYPEREAL hi = floor(4294967296.0*cycles);
+	TYPEREAL lo = floor(4294967296.0*(4294967296.0*cycles - hi) + 0.5);
+	m_IntNcoInc = ((quint64)hi<<32) + (quint64)lo;
 //qDebug()<<"NCO "<<m_NcoFreq;
 }
 
@@ -110,68 +167,168 @@ TYPEREAL tmpf = NcoFreq + m_CW_Offset;
 // Calculates sequence and number of decimation stages based on
 // input sample rate and desired output bandwidth.  Returns final output rate
 //from divide by 2 stages.
+// The last DECCHAIN_CACHE_SIZE chains are kept so switching back to a
+//recent rate/bandwidth does not delete and rebuild the stages.  A chain
+//that becomes active is primed with the tail of the previous input block
+//on the next ProcessData() call so its filter histories hold current data.
+//The prime buffer is grown here so the DSP thread never allocates.
 //////////////////////////////////////////////////////////////////////
 TYPEREAL CDownConvert::SetDataRate(TYPEREAL InRate, TYPEREAL MaxBW)
 {
-int n = 0;
-TYPEREAL f = InRate;
 	if( (m_InRate!=InRate) ||
 		(m_MaxBW!=MaxBW) )
 	{
 		m_InRate = InRate;
 		m_MaxBW = MaxBW;
 qDebug()<<"Inrate="<<m_InRate<<" BW="<<m_MaxBW;
+		//look for chain in cache, else rebuild the least recently used one
+		tDecChain* pChain = NULL;
+		int lru = -1;
+		for(int i=0; i<DECCHAIN_CACHE_SIZE; i++)
+		{
+			tDecChain* pC = &m_ChainCache[i];
+			if( pC->LastUse && (pC->InRate==InRate) && (pC->MaxBW==MaxBW) )
+			{
+				pChain = pC;
+				break;
+			}
+			if( (pC->pStages != m_pDecimatorPtrs) &&
+				((lru < 0) || (pC->LastUse < m_ChainCache[lru].LastUse)) )
+				lru = i;
+		}
+		if(!pChain)
+		{	//not the active chain so can be rebuilt without the lock
+			pChain = &m_ChainCache[lru];
+			DeleteChain(pChain);
+			BuildChain(pChain, InRate, MaxBW);
+		}
+		TYPECPX* pOldBuf = NULL;
+		TYPECPX* pNewBuf = NULL;
+		if(pChain->PrimeLength > m_PrimeBufSize)
+			pNewBuf = new TYPECPX[pChain->PrimeLength];
 		m_Mutex.lock();
-		DeleteFilters();
-		//loop until closest output rate is found and list of pointers to decimate by 2 stages is generated
-		while( (f > (m_MaxBW / HB51TAP_MAX) ) && (f > MIN_OUTPUT_RATE) )
+		if(pNewBuf)
+		{	//keep the samples already saved so this switch is still primed
+			for(int i=0; i<m_PrimeLength; i++)
+				pNewBuf[i] = m_pPrimeBuf[i];
+			pOldBuf = m_pPrimeBuf;
+			m_pPrimeBuf = pNewBuf;
+			m_PrimeBufSize = pChain->PrimeLength;
+		}
+		pChain->LastUse = ++m_ChainUseCount;
+		if(m_pDecimatorPtrs != pChain->pStages)
 		{
-			if(f >= (m_MaxBW / CIC3_MAX) )		//See if can use CIC order 3
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CCicN3DecimateBy2;
-			else if(f >= (m_MaxBW / HB11TAP_MAX) )	//See if can use fixed 11 Tap Halfband
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBand11TapDecimateBy2();
-			else if(f >= (m_MaxBW / HB15TAP_MAX) )	//See if can use Halfband 15 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB15TAP_LENGTH, HB15TAP_H);
-			else if(f >= (m_MaxBW / HB19TAP_MAX) )	//See if can use Halfband 19 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB19TAP_LENGTH, HB19TAP_H);
-			else if(f >= (m_MaxBW / HB23TAP_MAX) )	//See if can use Halfband 23 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB23TAP_LENGTH, HB23TAP_H);
-			else if(f >= (m_MaxBW / HB27TAP_MAX) )	//See if can use Halfband 27 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB27TAP_LENGTH, HB27TAP_H);
-			else if(f >= (m_MaxBW / HB31TAP_MAX) )	//See if can use Halfband 31 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB31TAP_LENGTH, HB31TAP_H);
-			else if(f >= (m_MaxBW / HB35TAP_MAX) )	//See if can use Halfband 35 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB35TAP_LENGTH, HB35TAP_H);
-			else if(f >= (m_MaxBW / HB39TAP_MAX) )	//See if can use Halfband 39 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB39TAP_LENGTH, HB39TAP_H);
-			else if(f >= (m_MaxBW / HB43TAP_MAX) )	//See if can use Halfband 43 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB43TAP_LENGTH, HB43TAP_H);
-			else if(f >= (m_MaxBW / HB47TAP_MAX) )	//See if can use Halfband 47 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB47TAP_LENGTH, HB47TAP_H);
-			else if(f >= (m_MaxBW / HB51TAP_MAX) )	//See if can use Halfband 51 Tap
-				m_pDecimatorPtrs[n++] =
-						new CDownConvert::CHalfBandDecimateBy2(HB51TAP_LENGTH, HB51TAP_H);
-			f /= 2.0;
+			m_pDecimatorPtrs = pChain->pStages;
+			m_PrimeChain = true;
 		}
+		m_PrimeNeed = pChain->PrimeLength;
+		m_IntStages = pChain->IntStages;
+		m_IntSkip = pChain->IntSkip;
 		m_Mutex.unlock();
-		m_OutputRate = f;
+		if(pOldBuf)
+			delete[] pOldBuf;
+		m_OutputRate = pChain->OutputRate;
 		SetFrequency(m_NcoFreq);
-//qDebug()<<"Filters "<<n<<" fout= "<<m_OutputRate;
 	}
 	return m_OutputRate;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Creates the decimate by 2 stages of one chain
+//////////////////////////////////////////////////////////////////////
+void CDownConvert::BuildChain(tDecChain* pChain, TYPEREAL InRate, TYPEREAL MaxBW)
+{
+int n = 0;
+TYPEREAL f = InRate;
+	//the integer front end does the leading run of CIC stages
+	pChain->IntStages = 0;
+	while( (pChain->IntStages < INTFE_MAX_STAGES) && (f > MIN_OUTPUT_RATE) &&
+		   (f >= (MaxBW / CIC3_MAX)) )
+	{
+		pChain->IntStages++;
+		f /= 2.0;
+	}
+	//every stage decimates by 2 so the CIC stages it does are skipped
+	pChain->IntSkip = pChain->IntStages;
+	f = InRate;
+	//loop until closest output rate is found and list of pointers to decimate by 2 stages is generated
+	while( (f > (MaxBW / HB51TAP_MAX) ) && (f > MIN_OUTPUT_RATE) )
+	{
+		if(f >= (MaxBW / CIC3_MAX) )		//See if can use CIC order 3
+			pChain->pStages[n++] =
+					new CDownConvert::CCicN3DecimateBy2;
+		else if(f >= (MaxBW / HB11TAP_MAX) )	//See if can use fixed 11 Tap Halfband
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB11TAP_LENGTH>(HB11TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB15TAP_MAX) )	//See if can use Halfband 15 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB15TAP_LENGTH>(HB15TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB19TAP_MAX) )	//See if can use Halfband 19 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB19TAP_LENGTH>(HB19TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB23TAP_MAX) )	//See if can use Halfband 23 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB23TAP_LENGTH>(HB23TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB27TAP_MAX) )	//See if can use Halfband 27 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB27TAP_LENGTH>(HB27TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB31TAP_MAX) )	//See if can use Halfband 31 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB31TAP_LENGTH>(HB31TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB35TAP_MAX) )	//See if can use Halfband 35 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB35TAP_LENGTH>(HB35TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB39TAP_MAX) )	//See if can use Halfband 39 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB39TAP_LENGTH>(HB39TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB43TAP_MAX) )	//See if can use Halfband 43 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB43TAP_LENGTH>(HB43TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB47TAP_MAX) )	//See if can use Halfband 47 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB47TAP_LENGTH>(HB47TAP_H, m_pScratch);
+		else if(f >= (MaxBW / HB51TAP_MAX) )	//See if can use Halfband 51 Tap
+			pChain->pStages[n++] =
+					new CDownConvert::CHalfBandDecimateBy2<HB51TAP_LENGTH>(HB51TAP_H, m_pScratch);
+		f /= 2.0;
+	}
+	pChain->InRate = InRate;
+	pChain->MaxBW = MaxBW;
+	pChain->OutputRate = f;
+	//each stage's history counted in chain input samples, rounded up to
+	//a whole number of output samples so every stage sees an even length
+	int len = 0;
+	int ratio = 1;
+	for(int i=0; i<n; i++)
+	{
+		len += pChain->pStages[i]->GetHistory()*ratio;
+		ratio *= 2;
+	}
+	pChain->PrimeLength = ((len + ratio - 1)/ratio)*ratio;
+//qDebug()<<"Filters "<<n<<" fout= "<<f;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Returns the scratch arena bytes the decimation stages need to
+//process InLength input samples.  Stages run one after the other and
+//give back their buffer so only the largest one counts.
+//////////////////////////////////////////////////////////////////////
+int CDownConvert::GetScratchBytes(int InLength)
+{
+int bytes = 0;
+int j = 0;
+	m_Mutex.lock();
+	while(m_pDecimatorPtrs[j])
+	{
+		int n = m_pDecimatorPtrs[j++]->GetScratchBytes(InLength);
+		if(n > bytes)
+			bytes = n;
+		InLength /= 2;
+	}
+	m_Mutex.unlock();
+	return bytes;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Processes 'InLength' I/Q samples of 'pInData' buffer
 // and places in 'pOutData' buffer.
@@ -249,6 +406,21 @@ double*	pdSinAns  = &dASMSin;
 	int n = InLength;
 	j = 0;
 	m_Mutex.lock();
+	if(m_PrimeChain)
+	{	//chain was just switched so fill its filters with the previous
+		//block and throw away the output
+		m_PrimeChain = false;
+		int pn = qMin(m_PrimeLength, m_PrimeNeed);
+		TYPECPX* pPrime = &m_pPrimeBuf[m_PrimeLength - pn];
+		while(m_pDecimatorPtrs[j] && (pn > 0))
+			pn = m_pDecimatorPtrs[j++]->DecBy2(pn, pPrime, pPrime);
+		j = 0;
+	}
+	//keep the tail of this block for priming the next chain switch
+	m_PrimeLength = qMin(InLength, m_PrimeBufSize);
+	TYPECPX* pTail = &pInData[InLength - m_PrimeLength];
+	for(i=0; i<m_PrimeLength; i++)
+		m_pPrimeBuf[i] = pTail[i];
 	while(m_pDecimatorPtrs[j])
 	{
 		n = m_pDecimatorPtrs[j++]->DecBy2(n, pInData, pInData);
@@ -265,161 +437,112 @@ double*	pdSinAns  = &dASMSin;
 // *&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*
 
 //////////////////////////////////////////////////////////////////////
-//Decimate by 2 Halfband filter class implementation
+//Decimate by 2 Halfband filter class template implementation
 //////////////////////////////////////////////////////////////////////
-CDownConvert::CHalfBandDecimateBy2::CHalfBandDecimateBy2(int len,const TYPEREAL* pCoef )
-	: m_FirLength(len), m_pCoef(pCoef)
+template <int TAPS>
+CDownConvert::CHalfBandDecimateBy2<TAPS>::CHalfBandDecimateBy2(const TYPEREAL* pCoef,
+															 CScratchArena* pScratch )
+	: m_pScratch(pScratch)
+{
+	//preload only the taps that are used since every other one is zero
+	//except the center tap, and the filter is symmetric
+	m_Hc = pCoef[CENTER];
+	for(int i=0; i<NUM_PAIRS; i++)
+		m_H[i] = pCoef[2*i];
+	Reset();
+}
+
+template <int TAPS>
+void CDownConvert::CHalfBandDecimateBy2<TAPS>::Reset()
 {
-	//create buffer for FIR implementation
-	m_pHBFirBuf = new TYPECPX[MAX_HALF_BAND_BUFSIZE];
 	TYPECPX CPXZERO = {0.0,0.0};
-	for(int i=0; i<MAX_HALF_BAND_BUFSIZE ;i++)
-		m_pHBFirBuf[i] = CPXZERO;
+	for(int i=0; i<TAPS-1; i++)
+		m_History[i] = CPXZERO;
 }
 
 //////////////////////////////////////////////////////////////////////
-// Half band filter and decimate by 2 function.
-// Two restrictions on this routine:
-// InLength must be larger or equal to the Number of Halfband Taps
-// InLength must be an even number  ~37nS
+// Calculates one filter output from TAPS input samples at pIn
 //////////////////////////////////////////////////////////////////////
-int CDownConvert::CHalfBandDecimateBy2::DecBy2(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
+template <int TAPS>
+inline void CDownConvert::CHalfBandDecimateBy2<TAPS>::Filter(const TYPECPX* pIn, TYPECPX& Out)
 {
-int i;
-int j;
-int numoutsamples = 0;
-	if(InLength<m_FirLength)	//safety net to make sure InLength is large enough to process
-		return InLength/2;
-//StartPerformance();
-	//copy input samples into buffer starting at position m_FirLength-1
-	for(i=0,j = m_FirLength - 1; i<InLength; i++)
-		m_pHBFirBuf[j++] = pInData[i];
-	//perform decimation FIR filter on even samples
-	for(i=0; i<InLength; i+=2)
+	TYPEREAL re = m_Hc*pIn[CENTER].re;
+	TYPEREAL im = m_Hc*pIn[CENTER].im;
+	for(int j=0; j<NUM_PAIRS; j++)
 	{
-		TYPECPX acc;
-		acc.re = ( m_pHBFirBuf[i].re * m_pCoef[0] );
-		acc.im = ( m_pHBFirBuf[i].im * m_pCoef[0] );
-		for(j=2; j<m_FirLength; j+=2)	//only use even coefficients since odd are zero(except center point)
-		{
-			acc.re += ( m_pHBFirBuf[i+j].re * m_pCoef[j] );
-			acc.im += ( m_pHBFirBuf[i+j].im * m_pCoef[j] );
-		}
-		//now multiply the center coefficient
-		acc.re += ( m_pHBFirBuf[i+(m_FirLength-1)/2].re * m_pCoef[(m_FirLength-1)/2] );
-		acc.im += ( m_pHBFirBuf[i+(m_FirLength-1)/2].im * m_pCoef[(m_FirLength-1)/2] );
-		pOutData[numoutsamples++] = acc;	//put output buffer
-
+		re += m_H[j]*( pIn[2*j].re + pIn[TAPS-1-2*j].re );
+		im += m_H[j]*( pIn[2*j].im + pIn[TAPS-1-2*j].im );
 	}
-	//need to copy last m_FirLength - 1 input samples in buffer to beginning of buffer
-	// for FIR wrap around management
-	for(i=0,j = InLength-m_FirLength+1; i<m_FirLength - 1; i++)
-		m_pHBFirBuf[i] = pInData[j++];
-//StopPerformance(InLength);
-	return numoutsamples;
+	Out.re = re;
+	Out.im = im;
 }
 
-// *&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*
-
 //////////////////////////////////////////////////////////////////////
-//Decimate by 2 Fixed 11 Tap Halfband filter class implementation
-// Loop unrolled for speed ~9nS /samp
+// Returns scratch arena bytes needed for a block of InLength samples
 //////////////////////////////////////////////////////////////////////
-CDownConvert::CHalfBand11TapDecimateBy2::CHalfBand11TapDecimateBy2()
+template <int TAPS>
+int CDownConvert::CHalfBandDecimateBy2<TAPS>::GetScratchBytes(int InLength)
 {
-	//preload only the taps that are used since evey other one is zero
-	//except center tap 5
-	H0 = HB11TAP_H[0]; H2 = HB11TAP_H[2]; H4 = HB11TAP_H[4];
-	H5 = HB11TAP_H[5];
-	H6 = HB11TAP_H[6]; H8 = HB11TAP_H[8]; H10 = HB11TAP_H[10];
-	TYPECPX CPXZERO = {0.0,0.0};
-	d0 = CPXZERO; d1 = CPXZERO;	d2 = CPXZERO; d3 = CPXZERO;
-	d4 = CPXZERO; d5 = CPXZERO;	d6 = CPXZERO; d7 = CPXZERO;
-	d8 = CPXZERO; d9 = CPXZERO;
+	if(InLength >= 2*TAPS)
+		return 0;
+	return CScratchArena::AlignedSize((InLength+TAPS)*sizeof(TYPECPX));
 }
 
 //////////////////////////////////////////////////////////////////////
-//Decimate by 2 Fixed 11 Tap Halfband filter class implementation
-// Two restrictions on this routine:
-// InLength must be larger or equal to the Number of Halfband Taps(11)
-// InLength must be an even number
-// Loop unrolled for speed ~15nS/samp
+// Half band filter and decimate by 2 function.
+// InLength must be an even number. pOutData can be the same as pInData.
+//	Normal size blocks are filtered directly from pInData. The first
+// TAPS-2 outputs need the history and would overwrite input that
+// is still needed, so they are computed first from a small copy and
+// written last, like the old unrolled 11 tap version.
+// Short blocks are copied after the history into a scratch buffer.
 //////////////////////////////////////////////////////////////////////
-int CDownConvert::CHalfBand11TapDecimateBy2::DecBy2(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
+template <int TAPS>
+int CDownConvert::CHalfBandDecimateBy2<TAPS>::DecBy2(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
 {
+int i;
+int numoutsamples = InLength/2;
 //StartPerformance();
-	//first calculate beginning 10 samples using previous samples in delay buffer
-	TYPECPX tmpout[9];	//use temp buffer so outbuf can be same as inbuf
-	tmpout[0].re = H0*d0.re + H2*d2.re + H4*d4.re + H5*d5.re + H6*d6.re + H8*d8.re
-					 + H10*pInData[0].re;
-	tmpout[0].im = H0*d0.im + H2*d2.im + H4*d4.im + H5*d5.im + H6*d6.im + H8*d8.im
-					 + H10*pInData[0].im;
-
-	tmpout[1].re = H0*d2.re + H2*d4.re + H4*d6.re + H5*d7.re + H6*d8.re
-					 + H8*pInData[0].re + H10*pInData[2].re;
-	tmpout[1].im = H0*d2.im + H2*d4.im + H4*d6.im + H5*d7.im + H6*d8.im
-					 + H8*pInData[0].im + H10*pInData[2].im;
-
-	tmpout[2].re = H0*d4.re + H2*d6.re + H4*d8.re + H5*d9.re
-					 + H6*pInData[0].re + H8*pInData[2].re + H10*pInData[4].re;
-	tmpout[2].im = H0*d4.im + H2*d6.im + H4*d8.im + H5*d9.im
-					 + H6*pInData[0].im + H8*pInData[2].im + H10*pInData[4].im;
-
-	tmpout[3].re = H0*d6.re + H2*d8.re + H4*pInData[0].re + H5*pInData[1].re
-					 + H6*pInData[2].re + H8*pInData[4].re + H10*pInData[6].re;
-	tmpout[3].im = H0*d6.im + H2*d8.im + H4*pInData[0].im + H5*pInData[1].im
-					 + H6*pInData[2].im + H8*pInData[4].im + H10*pInData[6].im;
-
-	tmpout[4].re = H0*d8.re + H2*pInData[0].re + H4*pInData[2].re + H5*pInData[3].re
-					 + H6*pInData[4].re + H8*pInData[6].re + H10*pInData[8].re;
-	tmpout[4].im = H0*d8.im + H2*pInData[0].im + H4*pInData[2].im + H5*pInData[3].im
-					 + H6*pInData[4].im + H8*pInData[6].im + H10*pInData[8].im;
-
-	tmpout[5].re = H0*pInData[0].re + H2*pInData[2].re + H4*pInData[4].re + H5*pInData[5].re
-					 + H6*pInData[6].re + H8*pInData[8].re + H10*pInData[10].re;
-	tmpout[5].im = H0*pInData[0].im + H2*pInData[2].im + H4*pInData[4].im + H5*pInData[5].im
-					 + H6*pInData[6].im + H8*pInData[8].im + H10*pInData[10].im;
-
-	tmpout[6].re = H0*pInData[2].re + H2*pInData[4].re + H4*pInData[6].re + H5*pInData[7].re
-					 + H6*pInData[8].re + H8*pInData[10].re + H10*pInData[12].re;
-	tmpout[6].im = H0*pInData[2].im + H2*pInData[4].im + H4*pInData[6].im + H5*pInData[7].im
-					 + H6*pInData[8].im + H8*pInData[10].im + H10*pInData[12].im;
-
-	tmpout[7].re = H0*pInData[4].re + H2*pInData[6].re + H4*pInData[8].re + H5*pInData[9].re
-					 + H6*pInData[10].re + H8*pInData[12].re + H10*pInData[14].re;
-	tmpout[7].im = H0*pInData[4].im + H2*pInData[6].im + H4*pInData[8].im + H5*pInData[9].im
-					 + H6*pInData[10].im + H8*pInData[12].im + H10*pInData[14].im;
-
-	tmpout[8].re = H0*pInData[6].re + H2*pInData[8].re + H4*pInData[10].re + H5*pInData[11].re
-					 + H6*pInData[12].re + H8*pInData[14].re + H10*pInData[16].re;
-	tmpout[8].im = H0*pInData[6].im + H2*pInData[8].im + H4*pInData[10].im + H5*pInData[11].im
-					 + H6*pInData[12].im + H8*pInData[14].im + H10*pInData[16].im;
-
-	//now loop through remaining input samples
-	TYPECPX* pIn = &pInData[8];
-	TYPECPX* pOut = &pOutData[9];
-	for(int i=0; i<(InLength-11-6 )/2; i++)
+	if(InLength < 2*TAPS)
+	{
+		int mark = m_pScratch->GetMark();
+		TYPECPX* pFirBuf = m_pScratch->Alloc<TYPECPX>(InLength + TAPS - 1);
+		for(i=0; i<TAPS-1; i++)
+			pFirBuf[i] = m_History[i];
+		for(i=0; i<InLength; i++)
+			pFirBuf[TAPS-1+i] = pInData[i];
+		for(i=0; i<numoutsamples; i++)
+			Filter(&pFirBuf[2*i], pOutData[i]);
+		for(i=0; i<TAPS-1; i++)
+			m_History[i] = pFirBuf[InLength+i];
+		m_pScratch->Release(mark);
+		return numoutsamples;
+	}
+	//first outputs use history followed by the start of the input block
+	TYPECPX FirstBuf[3*TAPS-6];
+	TYPECPX FirstOut[TAPS-2];
+	for(i=0; i<TAPS-1; i++)
+		FirstBuf[i] = m_History[i];
+	for(i=0; i<2*TAPS-5; i++)
+		FirstBuf[TAPS-1+i] = pInData[i];
+	for(i=0; i<TAPS-2; i++)
+		Filter(&FirstBuf[2*i], FirstOut[i]);
+	//now loop through remaining outputs directly from the input
+	TYPECPX* pIn = &pInData[TAPS-3];
+	for(i=TAPS-2; i<numoutsamples; i++)
 	{
-		(*pOut).re   = H0*pIn[0].re + H2*pIn[2].re + H4*pIn[4].re + H5*pIn[5].re
-					  + H6*pIn[6].re + H8*pIn[8].re + H10*pIn[10].re;
-		(*pOut++).im = H0*pIn[0].im + H2*pIn[2].im + H4*pIn[4].im + H5*pIn[5].im
-					  + H6*pIn[6].im + H8*pIn[8].im + H10*pIn[10].im;
+		Filter(pIn, pOutData[i]);
 		pIn += 2;
 	}
-	//copy first outputs back into output array so outbuf can be same as inbuf
-	pOutData[0] = tmpout[0]; pOutData[1] = tmpout[1];
-	pOutData[2] = tmpout[2]; pOutData[3] = tmpout[3];
-	pOutData[4] = tmpout[4]; pOutData[5] = tmpout[5];
-	pOutData[6] = tmpout[6]; pOutData[7] = tmpout[7];
-	pOutData[8] = tmpout[8];
-
-	//copy last 10 input samples into delay buffer for next time
-	pIn = &pInData[InLength-1];
-	d9 = *pIn--; d8 = *pIn--; d7 = *pIn--;
-	d6 = *pIn--; d5 = *pIn--; d4 = *pIn--;
-	d3 = *pIn--; d2 = *pIn--; d1 = *pIn--; d0 = *pIn;
+	//copy last TAPS-1 input samples into history for next time
+	pIn = &pInData[InLength-(TAPS-1)];
+	for(i=0; i<TAPS-1; i++)
+		m_History[i] = pIn[i];
+	//copy first outputs into output array so outbuf can be same as inbuf
+	for(i=0; i<TAPS-2; i++)
+		pOutData[i] = FirstOut[i];
 //StopPerformance(InLength);
-	return InLength/2;
+	return numoutsamples;
 }
 
 // *&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*
@@ -429,6 +552,11 @@ int CDownConvert::CHalfBand11TapDecimateBy2::DecBy2(int InLength, TYPECPX* pInDa
 // -80dB alias rejection up to Fs * (.5 - .4985)
 //////////////////////////////////////////////////////////////////////
 CDownConvert::CCicN3DecimateBy2::CCicN3DecimateBy2()
+{
+	Reset();
+}
+
+void CDownConvert::CCicN3DecimateBy2::Reset()
 {
 	m_Xodd.re = 0.0; m_Xodd.im = 0.0;
 	m_Xeven.re = 0.0; m_Xeven.im = 0.0;
@@ -458,3 +586,137 @@ TYPECPX even,odd;
 //StopPerformance(InLength);
 	return j;
 }
+
+// *&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*
+
+//////////////////////////////////////////////////////////////////////
+// Returns true if the active decimation chain starts with CIC stages
+//that the integer front end can do.
+//////////////////////////////////////////////////////////////////////
+bool CDownConvert::HasIntFrontEnd()
+{
+	m_Mutex.lock();
+	bool ret = (m_IntStages > 0);
+	m_Mutex.unlock();
+	return ret;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Clears the history of every stage of the active chain and restarts
+//the integer front end CIC.  Called when the input switches between
+//floating point and integer data since each path leaves the stages the
+//other one skips holding old samples.
+//////////////////////////////////////////////////////////////////////
+void CDownConvert::ResetChain()
+{
+int j = 0;
+	m_Mutex.lock();
+	while(m_pDecimatorPtrs[j])
+		m_pDecimatorPtrs[j++]->Reset();
+	m_IntRatio = 0;
+	m_PrimeChain = false;
+	m_PrimeLength = 0;
+	m_Mutex.unlock();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Processes 'InLength' raw interleaved I/Q integer samples.
+//	The NCO mix and the leading CIC stages run in integer directly on
+// the radio data and the result is only converted to floating point
+// after decimation.  The remaining stages of the chain then run as
+// in the floating point version.  pOutData must hold InLength samples.
+// Returns number of samples available in output buffer.
+//////////////////////////////////////////////////////////////////////
+int CDownConvert::ProcessData(int InLength, const qint32* pInData, TYPEREAL Scale, TYPECPX* pOutData)
+{
+int i,j;
+	m_Mutex.lock();
+	if(!m_IntStages)
+	{	//nothing to do in integer so convert and use the normal path
+		m_Mutex.unlock();
+		for(i=0; i<InLength; i++)
+		{
+			pOutData[i].re = Scale*(TYPEREAL)pInData[2*i];
+			pOutData[i].im = Scale*(TYPEREAL)pInData[2*i+1];
+		}
+		return ProcessData(InLength, pOutData, pOutData);
+	}
+	//the floating point input is not kept so a chain switch is not primed
+	m_PrimeChain = false;
+	m_PrimeLength = 0;
+	int n = IntFrontEnd(InLength, pInData, Scale, pOutData);
+	j = m_IntSkip;
+	while(m_pDecimatorPtrs[j])
+		n = m_pDecimatorPtrs[j++]->DecBy2(n, pOutData, pOutData);
+	m_Mutex.unlock();
+	return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Integer NCO mix followed by a CIC decimate by 2^m_IntStages.
+// The NCO is a phase accumulator addressing a sine table.  Mixer
+// products are 64 bit so the integrators can wrap around without
+// error.
+// Returns number of output samples.
+//////////////////////////////////////////////////////////////////////
+int CDownConvert::IntFrontEnd(int InLength, const qint32* pInData, TYPEREAL Scale, TYPECPX* pOutData)
+{
+int i,k;
+int j = 0;
+quint64 re,im,tmp;
+	int ratio = 1<<m_IntStages;
+	if(ratio != m_IntRatio)
+	{	//restart the CIC when the decimation changes
+		m_IntRatio = ratio;
+		m_IntPhase = 0;
+		for(k=0; k<INTFE_CIC_ORDER; k++)
+		{
+			m_IntInt[k][0] = 0;
+			m_IntInt[k][1] = 0;
+			m_IntComb[k][0] = 0;
+			m_IntComb[k][1] = 0;
+		}
+	}
+	//gain of the NCO table, mixer shift and CIC
+	TYPEREAL gain = INTFE_NCO_GAIN*Scale*(TYPEREAL)(1<<INTFE_MIX_SHIFT)/INTFE_NCO_AMPL;
+	for(k=0; k<INTFE_CIC_ORDER; k++)
+		gain /= (TYPEREAL)ratio;
+	quint64 phase = m_IntNcoPhase;
+	for(i=0; i<InLength; i++)
+	{
+		qint64 x = pInData[2*i];
+		qint64 y = pInData[2*i+1];
+		phase += m_IntNcoInc;
+		//table index is the phase rounded to INTFE_NCO_BITS
+		quint64 index = phase + INTFE_NCO_ROUND;
+		qint64 c = IntNcoTable[(index + INTFE_NCO_QUARTER)>>(64-INTFE_NCO_BITS)];
+		qint64 s = IntNcoTable[index>>(64-INTFE_NCO_BITS)];
+		//Cpx multiply by shift frequency
+		m_IntInt[0][0] += (quint64)( (x*c - y*s)>>INTFE_MIX_SHIFT );
+		m_IntInt[0][1] += (quint64)( (x*s + y*c)>>INTFE_MIX_SHIFT );
+		for(k=1; k<INTFE_CIC_ORDER; k++)
+		{
+			m_IntInt[k][0] += m_IntInt[k-1][0];
+			m_IntInt[k][1] += m_IntInt[k-1][1];
+		}
+		if(++m_IntPhase < ratio)
+			continue;
+		m_IntPhase = 0;
+		re = m_IntInt[INTFE_CIC_ORDER-1][0];
+		im = m_IntInt[INTFE_CIC_ORDER-1][1];
+		for(k=0; k<INTFE_CIC_ORDER; k++)
+		{
+			tmp = re - m_IntComb[k][0];
+			m_IntComb[k][0] = re;
+			re = tmp;
+			tmp = im - m_IntComb[k][1];
+			m_IntComb[k][1] = im;
+			im = tmp;
+		}
+		pOutData[j].re = gain*(TYPEREAL)(qint64)re;
+		pOutData[j].im = gain*(TYPEREAL)(qint64)im;
+		j++;
+	}
+	m_IntNcoPhase = phase;
+	return j;
+}
@@ -12,10 +12,13 @@
 #define DOWNCONVERT_H
 
 #include "dsp/datatypes.h"
+#include "dsp/scratcharena.h"
 #include <QMutex>
 
 
 #define MAX_DECSTAGES 10	//one more than max to make sure is a null at end of list
+#define DECCHAIN_CACHE_SIZE 4	//number of decimation chains kept for fast switching
+#define INTFE_CIC_ORDER 3		//order of the integer front end CIC
 
 //////////////////////////////////////////////////////////////////////////////////
 // Main Downconverter Class
@@ -28,7 +31,15 @@ public:
 	void SetFrequency(TYPEREAL NcoFreq);
 	void SetCwOffset(TYPEREAL offset){m_CW_Offset= offset;}
 	int ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
+	//integer front end version, pInData is interleaved raw I/Q integers
+	//that are multiplied by Scale to get the +-32768 range
+	int ProcessData(int InLength, const qint32* pInData, TYPEREAL Scale, TYPECPX* pOutData);
+	bool HasIntFrontEnd();	//true if the active chain starts with CIC stages
+	void ResetChain();		//clears the history of the active chain
 	TYPEREAL SetDataRate(TYPEREAL InRate, TYPEREAL MaxBW);
+	//arena used for the half band filter working buffers
+	void SetScratchArena(CScratchArena* pScratch){m_pScratch = pScratch;}
+	int GetScratchBytes(int InLength);
 
 private:
 	////////////
@@ -41,49 +52,33 @@ private:
 		CDec2(){}
 		virtual ~CDec2(){}
 		virtual int DecBy2(int InLength, TYPECPX* pInData, TYPECPX* pOutData) = 0;
+		virtual int GetScratchBytes(int){return 0;}
+		virtual int GetHistory(){return 2;}	//input samples held by the filter
+		virtual void Reset() = 0;			//clears the filter history
 	};
 
 	////////////
-	//private class for the Half Band decimate by 2 stages
+	//private class template for the Half Band decimate by 2 stages
+	//The tap count is a template parameter so the inner loops have
+	//fixed lengths the compiler can unroll. Only the even symmetric
+	//coefficient pairs and center tap are used since odd taps are zero.
 	////////////
-	class CHalfBandDecimateBy2 : public CDec2
+	template <int TAPS> class CHalfBandDecimateBy2 : public CDec2
 	{
 	public:
-		CHalfBandDecimateBy2(int len,const TYPEREAL* pCoef);
-		~CHalfBandDecimateBy2(){if(m_pHBFirBuf) delete m_pHBFirBuf;}
+		CHalfBandDecimateBy2(const TYPEREAL* pCoef, CScratchArena* pScratch);
+		~CHalfBandDecimateBy2(){}
 		int DecBy2(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
-		TYPECPX* m_pHBFirBuf;
-		int m_FirLength;
-		const TYPEREAL* m_pCoef;
-	};
-
-
-	////////////
-	//private class for the fixed 11 tap Half Band decimate by 2 stages
-	////////////
-	class CHalfBand11TapDecimateBy2 : public CDec2
-	{
-	public:
-		CHalfBand11TapDecimateBy2();
-		~CHalfBand11TapDecimateBy2(){}
-		int DecBy2(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
-		TYPEREAL H0;	//unwrapped coeeficients
-		TYPEREAL H2;
-		TYPEREAL H4;
-		TYPEREAL H5;
-		TYPEREAL H6;
-		TYPEREAL H8;
-		TYPEREAL H10;
-		TYPECPX d0;		//unwrapped delay buffer
-		TYPECPX d1;
-		TYPECPX d2;
-		TYPECPX d3;
-		TYPECPX d4;
-		TYPECPX d5;
-		TYPECPX d6;
-		TYPECPX d7;
-		TYPECPX d8;
-		TYPECPX d9;
+		int GetScratchBytes(int InLength);
+		int GetHistory(){return TAPS-1;}
+		void Reset();
+	private:
+		enum {NUM_PAIRS = (TAPS+1)/4, CENTER = (TAPS-1)/2};
+		inline void Filter(const TYPECPX* pIn, TYPECPX& Out);
+		CScratchArena* m_pScratch;	//only used for short blocks
+		TYPEREAL m_Hc;				//center coefficient
+		TYPEREAL m_H[NUM_PAIRS];	//even coefficients H[0],H[2]...
+		TYPECPX m_History[TAPS-1];	//last TAPS-1 input samples
 	};
 
 	////////////
@@ -95,13 +90,29 @@ private:
 		CCicN3DecimateBy2();
 		~CCicN3DecimateBy2(){}
 		int DecBy2(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
+		void Reset();
 		TYPECPX m_Xodd;
 		TYPECPX m_Xeven;
 	};
 
 private:
+	typedef struct _decchain
+	{
+		TYPEREAL InRate;
+		TYPEREAL MaxBW;
+		TYPEREAL OutputRate;
+		quint32 LastUse;	//0 if not built yet
+		int IntStages;		//decimate by 2 stages done by the integer front end
+		int IntSkip;		//number of pStages those replace
+		int PrimeLength;	//input samples that fill every stage's history
+		CDec2* pStages[MAX_DECSTAGES];
+	}tDecChain;
+
 	//private helper functions
 	void DeleteFilters();
+	void DeleteChain(tDecChain* pChain);
+	void BuildChain(tDecChain* pChain, TYPEREAL InRate, TYPEREAL MaxBW);
+	int IntFrontEnd(int InLength, const qint32* pInData, TYPEREAL Scale, TYPECPX* pOutData);
 
 	TYPEREAL m_OutputRate;
 	TYPEREAL m_NcoFreq;
@@ -114,8 +125,27 @@ private:
 	TYPEREAL m_OscCos;
 	TYPEREAL m_OscSin;
 	QMutex m_Mutex;		//for keeping threads from stomping on each other
+	CScratchArena* m_pScratch;
+	//cache of decimation chains, the active one is pointed to by m_pDecimatorPtrs
+	quint32 m_ChainUseCount;
+	tDecChain m_ChainCache[DECCHAIN_CACHE_SIZE];
 	//array of pointers for performing decimate by 2 stages
-	CDec2* m_pDecimatorPtrs[MAX_DECSTAGES];
+	CDec2** m_pDecimatorPtrs;
+	//previous mixed input block used to fill a newly selected chain's filters
+	bool m_PrimeChain;
+	int m_PrimeNeed;		//PrimeLength of the active chain
+	int m_PrimeLength;		//samples held in m_pPrimeBuf
+	int m_PrimeBufSize;		//grown by SetDataRate() only
+	TYPECPX* m_pPrimeBuf;
+	//integer front end NCO and CIC state
+	int m_IntStages;		//copied from the active chain
+	int m_IntSkip;
+	quint64 m_IntNcoPhase;	//2^64 is one cycle
+	quint64 m_IntNcoInc;
+	int m_IntRatio;
+	int m_IntPhase;
+	quint64 m_IntInt[INTFE_CIC_ORDER][2];	//integrators as [stage][re,im]
+	quint64 m_IntComb[INTFE_CIC_ORDER][2];
 
 };
 
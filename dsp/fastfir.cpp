@@ -9,9 +9,18 @@
 //For best performance use FIR size   4*FIR <= FFT <= 8*FIR
 //If need output to be power of 2 then FIR must = 1/2FFT size
 //
+//The optional noise reduction and auto notch are done by scaling the
+//filter kernel bins by a gain computed from the input spectrum so they
+//cost no extra FFTs.  Any per bin gain, even a constant one, lengthens
+//the kernel impulse response up to the full FFT size so part of it wraps
+//around in the overlap save.  The gains are kept smooth across the bins,
+//with a limited NR gain step between bins and tapered notch edges, so
+//the added response is short and the wrapped part stays small.
+//
 // History:
 //	2010-09-15  Initial creation MSW
 //	2011-03-27  Initial release
+//	2026-10-19  Added spectral noise reduction and auto notch
 //////////////////////////////////////////////////////////////////////
 //==========================================================================================
 // + + +   This Software is released under the "Simplified BSD License"  + + +
@@ -59,6 +68,20 @@
 
 #define CONV_INBUF_SIZE (CONV_FFT_SIZE+CONV_FIR_SIZE-1)
 
+#define NR_PWR_TIMECONST 0.03	//bin power smoothing time in seconds
+#define NR_GAIN_TIMECONST 0.15	//bin gain release time in seconds
+#define NR_NOISE_RISE 3.0		//noise floor rise rate in dB per second
+#define NR_NOISE_BIAS 5.0		//mean noise to tracked minimum power ratio
+#define NR_MIN_FLOOR_DB 6.0		//bin gain floor at NR level 0
+#define NR_MAX_FLOOR_DB 20.0	//bin gain floor at NR level 99
+#define NR_MAX_STEP_DB 3.0		//max NR gain change between adjacent bins
+
+#define NOTCH_TIMECONST 0.5		//carrier detect power smoothing in seconds
+#define NOTCH_RATIO 30.0		//carrier to nearby bins power ratio(~15dB)
+#define NOTCH_WIDTH 12.0		//notch half width in Hz
+#define NOTCH_DC_WIDTH 50.0		//carriers this close to 0 Hz are kept for AM
+#define NOTCH_REF_BINS 6		//bins each side used for the nearby level
+
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -69,15 +92,33 @@ CFastFIR::CFastFIR()
 int i;
 	m_pWindowTbl = NULL;
 	m_pFFTBuf = NULL;
+	m_pFFTRealBuf = NULL;
 	m_pFFTOverlapBuf = NULL;
 	m_pFilterCoef = NULL;
+	m_pBinPwr = NULL;
+	m_pBinLong = NULL;
+	m_pBinNoise = NULL;
+	m_pBinGain = NULL;
+	m_pGainCoef = NULL;
 	//allocate internal buffer space on Heap
 	m_pWindowTbl = new TYPEREAL[CONV_FFT_SIZE];
-	m_pFilterCoef = new TYPECPX[CONV_FFT_SIZE];
+	for( i=0; i<FASTFIR_KERNEL_CACHE; i++)
+	{
+		m_KernelCache[i].pCoef = new TYPECPX[CONV_FFT_SIZE];
+		m_KernelCache[i].LastUse = 0;
+	}
+	m_KernelUseCount = 0;
+	m_pFilterCoef = m_KernelCache[0].pCoef;
 	m_pFFTBuf = new TYPECPX[CONV_FFT_SIZE];
+	m_pFFTRealBuf = new TYPEREAL[CONV_FFT_SIZE];
 	m_pFFTOverlapBuf = new TYPECPX[CONV_FIR_SIZE];
+	m_pBinPwr = new TYPEREAL[CONV_FFT_SIZE];
+	m_pBinLong = new TYPEREAL[CONV_FFT_SIZE];
+	m_pBinNoise = new TYPEREAL[CONV_FFT_SIZE];
+	m_pBinGain = new TYPEREAL[CONV_FFT_SIZE];
+	m_pGainCoef = new TYPECPX[CONV_FFT_SIZE];
 
-	if(!m_pWindowTbl || !m_pFilterCoef || !m_pFFTBuf || !m_pFFTOverlapBuf)
+	if(!m_pWindowTbl || !m_pFilterCoef || !m_pFFTBuf || !m_pFFTRealBuf || !m_pFFTOverlapBuf)
 	{
 		//major poblems if memory fails here
 		return;
@@ -129,6 +170,11 @@ int i;
 	m_FHiCut = 1.0;
 	m_Offset = 1.0;
 	m_SampleRate = 1.0;
+	m_NROn = false;
+	m_NotchOn = false;
+	m_BinGainReset = true;
+	m_NRLevel = 50.0;
+	CalcBinGainParams();
 }
 
 CFastFIR::~CFastFIR()
@@ -152,16 +198,50 @@ void CFastFIR::FreeMemory()
 		delete m_pFFTOverlapBuf;
 		m_pFFTOverlapBuf = NULL;
 	}
-	if(m_pFilterCoef)
+	for(int i=0; i<FASTFIR_KERNEL_CACHE; i++)
 	{
-		delete m_pFilterCoef;
-		m_pFilterCoef = NULL;
+		if(m_KernelCache[i].pCoef)
+		{
+			delete m_KernelCache[i].pCoef;
+			m_KernelCache[i].pCoef = NULL;
+		}
 	}
+	m_pFilterCoef = NULL;
 	if(m_pFFTBuf)
 	{
 		delete m_pFFTBuf;
 		m_pFFTBuf = NULL;
 	}
+	if(m_pFFTRealBuf)
+	{
+		delete m_pFFTRealBuf;
+		m_pFFTRealBuf = NULL;
+	}
+	if(m_pBinPwr)
+	{
+		delete m_pBinPwr;
+		m_pBinPwr = NULL;
+	}
+	if(m_pBinLong)
+	{
+		delete m_pBinLong;
+		m_pBinLong = NULL;
+	}
+	if(m_pBinNoise)
+	{
+		delete m_pBinNoise;
+		m_pBinNoise = NULL;
+	}
+	if(m_pBinGain)
+	{
+		delete m_pBinGain;
+		m_pBinGain = NULL;
+	}
+	if(m_pGainCoef)
+	{
+		delete m_pGainCoef;
+		m_pGainCoef = NULL;
+	}
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -174,6 +254,8 @@ void CFastFIR::FreeMemory()
 //  HiCut must be greater than LowCut
 //		example to make 2700Hz USB filter:
 //	SetupParameters( 100, 2800, 0, 48000);
+// The last FASTFIR_KERNEL_CACHE kernels are kept so switching back
+//to a recent filter setting is just a pointer change.
 //////////////////////////////////////////////////////////////////////
 void CFastFIR::SetupParameters( TYPEREAL FLoCut, TYPEREAL FHiCut,
 								TYPEREAL Offset, TYPEREAL SampleRate)
@@ -187,7 +269,14 @@ int i;
 	m_FLoCut = FLoCut;
 	m_FHiCut = FHiCut;
 	m_Offset = Offset;
-	m_SampleRate = SampleRate;
+	if(SampleRate != m_SampleRate)
+	{	//bins now have different frequencies so restart the estimates
+		m_Mutex.lock();
+		m_SampleRate = SampleRate;
+		CalcBinGainParams();
+		m_BinGainReset = true;
+		m_Mutex.unlock();
+	}
 
 	FLoCut += Offset;
 	FHiCut += Offset;
@@ -202,7 +291,47 @@ int i;
 		return;
 	}
 //qDebug()<<"FLowCut="<<FLoCut<<"FHiCut="<<FHiCut<<"SampleRate="<<SampleRate;
+	//look for kernel in cache, else use the least recently used entry
+	int lru = -1;
+	for(i=0; i<FASTFIR_KERNEL_CACHE; i++)
+	{
+		tKernel* pK = &m_KernelCache[i];
+		if( pK->LastUse && (pK->FLoCut==m_FLoCut) && (pK->FHiCut==m_FHiCut) &&
+			(pK->Offset==m_Offset) && (pK->SampleRate==m_SampleRate) )
+		{
+			m_Mutex.lock();
+			pK->LastUse = ++m_KernelUseCount;
+			m_pFilterCoef = pK->pCoef;
+			m_Mutex.unlock();
+			return;
+		}
+		if( (pK->pCoef != m_pFilterCoef) &&
+			((lru < 0) || (pK->LastUse < m_KernelCache[lru].LastUse)) )
+			lru = i;
+	}
+	//the lru entry is never the active kernel so design it unlocked
+	tKernel* pK = &m_KernelCache[lru];
+	pK->LastUse = 0;
+	DesignKernel(FLoCut, FHiCut, SampleRate, pK->pCoef);
 	m_Mutex.lock();
+	//convert FIR coefficients to frequency domain by taking forward FFT
+	m_Fft.FwdFFT(pK->pCoef);
+	pK->FLoCut = m_FLoCut;
+	pK->FHiCut = m_FHiCut;
+	pK->Offset = m_Offset;
+	pK->SampleRate = m_SampleRate;
+	pK->LastUse = ++m_KernelUseCount;
+	m_pFilterCoef = pK->pCoef;
+	m_Mutex.unlock();
+}
+
+//////////////////////////////////////////////////////////////////////
+//  Designs time domain complex bandpass kernel in pCoef zero padded
+// to the FFT size.  Cutoffs include the CW offset.
+//////////////////////////////////////////////////////////////////////
+void CFastFIR::DesignKernel(TYPEREAL FLoCut, TYPEREAL FHiCut, TYPEREAL SampleRate, TYPECPX* pCoef)
+{
+int i;
 	//calculate some normalized filter parameters
 	TYPEREAL nFL = FLoCut/SampleRate;
 	TYPEREAL nFH = FHiCut/SampleRate;
@@ -212,8 +341,8 @@ int i;
 
 	for(i=0; i<CONV_FFT_SIZE; i++)		//zero pad entire coefficient buffer to FFT size
 	{
-		m_pFilterCoef[i].re = 0.0;
-		m_pFilterCoef[i].im = 0.0;
+		pCoef[i].re = 0.0;
+		pCoef[i].im = 0.0;
 	}
 
 	//create LP FIR windowed sinc, sin(x)/x complex LP filter coefficients
@@ -228,11 +357,11 @@ int i;
 
 		//shift lowpass filter coefficients in frequency by (hicut+lowcut)/2 to form bandpass filter anywhere in range
 		// (also scales by 1/FFTsize since inverse FFT routine scales by FFTsize)
-		m_pFilterCoef[i].re  =  z * cos(nFs * x)/(TYPEREAL)CONV_FFT_SIZE;
-		m_pFilterCoef[i].im = z * sin(nFs * x)/(TYPEREAL)CONV_FFT_SIZE;
+		pCoef[i].re  =  z * cos(nFs * x)/(TYPEREAL)CONV_FFT_SIZE;
+		pCoef[i].im = z * sin(nFs * x)/(TYPEREAL)CONV_FFT_SIZE;
 	}
 
-#if 0		//debug hack to write m_pFilterCoef to a file for analysis
+#if 0		//debug hack to write pCoef to a file for analysis
 	QDir::setCurrent("d:/");
 	QFile File;
 	File.setFileName("lpcoef.txt");
@@ -242,7 +371,7 @@ int i;
 		char Buf[256];
 		for( i=0; i<CONV_FIR_SIZE; i++)
 		{
-			sprintf( Buf, "%19.12g %19.12g\r\n", (double)CONV_FFT_SIZE*m_pFilterCoef[i].re, (double)CONV_FFT_SIZE*m_pFilterCoef[i].im);
+			sprintf( Buf, "%19.12g %19.12g\r\n", (double)CONV_FFT_SIZE*pCoef[i].re, (double)CONV_FFT_SIZE*pCoef[i].im);
 			File.write(Buf);
 		}
 	}
@@ -250,12 +379,55 @@ int i;
 		qDebug()<<"file Failed to Open";
 
 #endif
-	//convert FIR coefficients to frequency domain by taking forward FFT
-	m_Fft.FwdFFT(m_pFilterCoef);
-	m_Mutex.unlock();
+}
 
+//////////////////////////////////////////////////////////////////////
+//  Call to setup the per bin gain stage
+// NROn turns on the noise reduction, NRLevel 0 to 99 sets its strength
+// NotchOn turns on automatic notching of steady carriers
+//////////////////////////////////////////////////////////////////////
+void CFastFIR::SetupBinGain(bool NROn, TYPEREAL NRLevel, bool NotchOn)
+{
+	m_Mutex.lock();
+	if( !m_NROn && !m_NotchOn )
+		m_BinGainReset = true;
+	m_NROn = NROn;
+	m_NotchOn = NotchOn;
+	m_NRLevel = NRLevel;
+	CalcBinGainParams();
+	m_Mutex.unlock();
+}
 
+//////////////////////////////////////////////////////////////////////
+//  Calculates the per block bin gain constants from the sample rate
+// and noise reduction level.  Called with m_Mutex locked.
+//////////////////////////////////////////////////////////////////////
+void CFastFIR::CalcBinGainParams()
+{
+	TYPEREAL BlockTime = (TYPEREAL)(CONV_FFT_SIZE - CONV_FIR_SIZE + 1)/m_SampleRate;
+	TYPEREAL BinWidth = m_SampleRate/(TYPEREAL)CONV_FFT_SIZE;
+	m_PwrAlpha = 1.0 - exp(-BlockTime/NR_PWR_TIMECONST);
+	m_GainAlpha = 1.0 - exp(-BlockTime/NR_GAIN_TIMECONST);
+	m_LongAlpha = 1.0 - exp(-BlockTime/NOTCH_TIMECONST);
+	m_NoiseRise = pow(10.0, NR_NOISE_RISE*BlockTime/10.0);
+	m_NRBeta = NR_NOISE_BIAS*(1.0 + 2.0*m_NRLevel/99.0);
+	m_NRFloor = pow(10.0, -(NR_MIN_FLOOR_DB +
+						(NR_MAX_FLOOR_DB-NR_MIN_FLOOR_DB)*m_NRLevel/99.0)/20.0);
+	m_NRStep = pow(10.0, -NR_MAX_STEP_DB/20.0);
+	m_NotchBins = (int)(NOTCH_WIDTH/BinWidth + 0.5);
+	if(m_NotchBins < 1)
+		m_NotchBins = 1;
+	m_NotchDcBins = (int)(NOTCH_DC_WIDTH/BinWidth + 0.5) + m_NotchBins + 1;
+}
 
+///////////////////////////////////////////////////////////////////////////////
+//   Returns the most samples ProcessData() can place in OutBuf for
+//'InLength' input samples.  Output comes in whole FFT blocks so up to
+//one block of earlier input can come out with it.
+///////////////////////////////////////////////////////////////////////////////
+int CFastFIR::GetMaxOutputLength(int InLength)
+{
+	return InLength + (CONV_FFT_SIZE - CONV_FIR_SIZE + 1);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -266,6 +438,27 @@ int i;
 //600ns/samp
 ///////////////////////////////////////////////////////////////////////////////
 int CFastFIR::ProcessData(int InLength, TYPECPX* InBuf, TYPECPX* OutBuf)
+{
+	return BufferData(InLength, InBuf, OutBuf);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   Process 'InLength' complex samples in 'InBuf'.
+//  returns number of samples of the real part of the filter output
+//placed in OutBuf.
+///////////////////////////////////////////////////////////////////////////////
+int CFastFIR::ProcessData(int InLength, TYPECPX* InBuf, TYPEREAL* OutBuf)
+{
+	return BufferData(InLength, InBuf, OutBuf);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   Collects input samples into the FFT buffer and filters a block each
+//time it is full.  Both output types share the overlap save input state
+//so the output type can change between calls.
+///////////////////////////////////////////////////////////////////////////////
+template <class T>
+int CFastFIR::BufferData(int InLength, TYPECPX* InBuf, T* OutBuf)
 {
 int i = 0;
 int j;
@@ -284,14 +477,8 @@ int outpos = 0;
 		}
 		m_pFFTBuf[m_InBufInPos++] = InBuf[i++];
 		if(m_InBufInPos >= CONV_FFT_SIZE)
-		{	//perform FFT -> complexMultiply by FIR coefficients -> inverse FFT on filled FFT input buffer
-			m_Fft.FwdFFT(m_pFFTBuf);
-			CpxMpy(CONV_FFT_SIZE, m_pFilterCoef, m_pFFTBuf, m_pFFTBuf);
-			m_Fft.RevFFT(m_pFFTBuf);
-			for(j=(CONV_FIR_SIZE-1); j<CONV_FFT_SIZE; j++)
-			{	//copy FFT output into OutBuf minus CONV_FIR_SIZE-1 samples at beginning
-				OutBuf[outpos++] = m_pFFTBuf[j];
-			}
+		{
+			outpos += FilterBlock(&OutBuf[outpos]);
 			for(j=0; j<(CONV_FIR_SIZE - 1);j++)
 			{	//copy overlap buffer into start of fft input buffer
 				m_pFFTBuf[j] = m_pFFTOverlapBuf[j];
@@ -305,6 +492,161 @@ int outpos = 0;
 	return outpos;	//return number of output samples processed and placed in OutBuf
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//   Filters the full FFT input buffer and places the
+//CONV_FFT_SIZE-CONV_FIR_SIZE+1 new output samples in OutBuf.
+//COMPLEX version
+///////////////////////////////////////////////////////////////////////////////
+int CFastFIR::FilterBlock(TYPECPX* OutBuf)
+{
+int j;
+int outpos = 0;
+	//perform FFT -> complexMultiply by FIR coefficients -> inverse FFT on filled FFT input buffer
+	m_Fft.FwdFFT(m_pFFTBuf);
+	TYPECPX* pCoef = m_pFilterCoef;
+	if(m_NROn || m_NotchOn)
+		pCoef = CalcBinGains(m_pFFTBuf);
+	CpxMpy(CONV_FFT_SIZE, pCoef, m_pFFTBuf, m_pFFTBuf);
+	m_Fft.RevFFT(m_pFFTBuf);
+	for(j=(CONV_FIR_SIZE-1); j<CONV_FFT_SIZE; j++)
+	{	//copy FFT output into OutBuf minus CONV_FIR_SIZE-1 samples at beginning
+		OutBuf[outpos++] = m_pFFTBuf[j];
+	}
+	return outpos;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   Filters the full FFT input buffer and places the real part of the
+//new output samples in OutBuf.
+//REAL version
+///////////////////////////////////////////////////////////////////////////////
+int CFastFIR::FilterBlock(TYPEREAL* OutBuf)
+{
+int j;
+int outpos = 0;
+	//perform FFT -> complexMultiply by FIR coefficients -> inverse real FFT
+	m_Fft.FwdFFT(m_pFFTBuf);
+	TYPECPX* pCoef = m_pFilterCoef;
+	if(m_NROn || m_NotchOn)
+		pCoef = CalcBinGains(m_pFFTBuf);
+	CpxMpyReal(CONV_FFT_SIZE, pCoef, m_pFFTBuf, m_pFFTRealBuf);
+	m_Fft.RevRealFFT(m_pFFTRealBuf);
+	for(j=(CONV_FIR_SIZE-1); j<CONV_FFT_SIZE; j++)
+		OutBuf[outpos++] = m_pFFTRealBuf[j];
+	return outpos;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   Updates the per bin power and noise floor estimates from the input
+//spectrum and returns the active kernel scaled by the new bin gains.
+//The noise floor follows the minimum of the smoothed bin power and
+//rises slowly so speech and signals do not pull it up.  The noise
+//reduction gain is a Wiener style 1 - Noise/Power with a floor.
+///////////////////////////////////////////////////////////////////////////////
+TYPECPX* CFastFIR::CalcBinGains(TYPECPX* pSpectrum)
+{
+int i;
+	if(m_BinGainReset)
+	{
+		for(i=0; i<CONV_FFT_SIZE; i++)
+		{
+			TYPEREAL p = pSpectrum[i].re*pSpectrum[i].re + pSpectrum[i].im*pSpectrum[i].im;
+			m_pBinPwr[i] = p;
+			m_pBinLong[i] = p;
+			m_pBinNoise[i] = p;
+			m_pBinGain[i] = 1.0;
+		}
+		m_BinGainReset = false;
+	}
+	for(i=0; i<CONV_FFT_SIZE; i++)
+	{
+		TYPEREAL p = pSpectrum[i].re*pSpectrum[i].re + pSpectrum[i].im*pSpectrum[i].im;
+		m_pBinPwr[i] += m_PwrAlpha*(p - m_pBinPwr[i]);
+		m_pBinLong[i] += m_LongAlpha*(p - m_pBinLong[i]);
+		if(m_pBinPwr[i] < m_pBinNoise[i])
+			m_pBinNoise[i] = m_pBinPwr[i];
+		else
+			m_pBinNoise[i] *= m_NoiseRise;
+		TYPEREAL g = 1.0;
+		if(m_NROn)
+		{
+			g = 1.0 - m_NRBeta*m_pBinNoise[i]/(m_pBinPwr[i] + 1e-30);
+			if(g < m_NRFloor)
+				g = m_NRFloor;
+		}
+		//gain rises at once and falls slowly to limit musical noise
+		if(g > m_pBinGain[i])
+			m_pBinGain[i] = g;
+		else
+			m_pBinGain[i] += m_GainAlpha*(g - m_pBinGain[i]);
+	}
+	if(m_NROn)
+	{	//raise bins that drop more than m_NRStep below either neighbor
+		for(i=1; i<CONV_FFT_SIZE; i++)
+		{
+			if(m_pBinGain[i] < m_NRStep*m_pBinGain[i-1])
+				m_pBinGain[i] = m_NRStep*m_pBinGain[i-1];
+		}
+		for(i=CONV_FFT_SIZE-2; i>=0; i--)
+		{
+			if(m_pBinGain[i] < m_NRStep*m_pBinGain[i+1])
+				m_pBinGain[i] = m_NRStep*m_pBinGain[i+1];
+		}
+	}
+	if(m_NotchOn)
+		NotchCarriers();
+	for(i=0; i<CONV_FFT_SIZE; i++)
+	{
+		m_pGainCoef[i].re = m_pFilterCoef[i].re * m_pBinGain[i];
+		m_pGainCoef[i].im = m_pFilterCoef[i].im * m_pBinGain[i];
+	}
+	return m_pGainCoef;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   Zeros the gain of bins around any steady carrier whose long term
+//power is NOTCH_RATIO above the bins near it.  The gain then rises back
+//with a raised cosine over m_NotchBins more bins each side.  Bins close
+//to 0 Hz are skipped so an AM carrier is not removed.
+///////////////////////////////////////////////////////////////////////////////
+void CFastFIR::NotchCarriers()
+{
+int i,j;
+	for(i=m_NotchDcBins; i<=(CONV_FFT_SIZE-m_NotchDcBins); i++)
+	{
+		TYPEREAL p = m_pBinLong[i];
+		//must be the peak of the bins that would be notched
+		for(j=1; j<=m_NotchBins; j++)
+		{
+			if( (m_pBinLong[i-j] > p) || (m_pBinLong[i+j] >= p) )
+				break;
+		}
+		if(j <= m_NotchBins)
+			continue;
+		TYPEREAL ref = 0.0;
+		for(j=m_NotchBins+1; j<=(m_NotchBins+NOTCH_REF_BINS); j++)
+		{
+			ref += m_pBinLong[(i-j) & (CONV_FFT_SIZE-1)];
+			ref += m_pBinLong[(i+j) & (CONV_FFT_SIZE-1)];
+		}
+		if( p*(2*NOTCH_REF_BINS) > ref*NOTCH_RATIO )
+		{
+			for(j=-m_NotchBins; j<=m_NotchBins; j++)
+				m_pBinGain[i+j] = 0.0;
+			for(j=1; j<=m_NotchBins; j++)
+			{	//taper caps the gain so repeated notches do not compound
+				TYPEREAL w = 0.5 - 0.5*cos(K_PI*(TYPEREAL)j/(TYPEREAL)(m_NotchBins+1));
+				int lo = (i-m_NotchBins-j) & (CONV_FFT_SIZE-1);
+				int hi = (i+m_NotchBins+j) & (CONV_FFT_SIZE-1);
+				if(m_pBinGain[lo] > w)
+					m_pBinGain[lo] = w;
+				if(m_pBinGain[hi] > w)
+					m_pBinGain[hi] = w;
+			}
+		}
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //   Complex multiply N point array m with src and place in dest.  
 // src and dest can be the same buffer.
@@ -320,3 +662,24 @@ void CFastFIR::CpxMpy(int N, TYPECPX* m, TYPECPX* src, TYPECPX* dest)
 	}
 }
 
+
+///////////////////////////////////////////////////////////////////////////////
+//   Complex multiply N point array m with src and pack twice the Hermitian
+// part of the product into dest for CFft::RevRealFFT() which then gives
+// the real part of the complex filter output.
+///////////////////////////////////////////////////////////////////////////////
+void CFastFIR::CpxMpyReal(int N, TYPECPX* m, TYPECPX* src, TYPEREAL* dest)
+{
+int h = N/2;
+	dest[0] = 2.0*(m[0].re * src[0].re - m[0].im * src[0].im);
+	dest[1] = 2.0*(m[h].re * src[h].re - m[h].im * src[h].im);
+	for(int i=1; i<h; i++)
+	{
+		TYPEREAL ar = src[i].re;
+		TYPEREAL ai = src[i].im;
+		TYPEREAL br = src[N-i].re;
+		TYPEREAL bi = src[N-i].im;
+		dest[2*i] = (m[i].re * ar - m[i].im * ai) + (m[N-i].re * br - m[N-i].im * bi);
+		dest[2*i+1] = (m[i].re * ai + m[i].im * ar) - (m[N-i].re * bi + m[N-i].im * br);
+	}
+}
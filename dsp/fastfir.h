@@ -4,10 +4,15 @@
 //  This class implements a FIR Bandpass filter using a FFT convolution algorithm
 //The filter is complex and is specified with 3 parameters:
 // sample frequency, Hicut and Lowcut frequency
+//The output can be complex or just its real part for SSB and CW which
+//halves the reverse FFT work.
+//An optional per bin gain can be applied in the spectral multiply for
+//noise reduction and automatic notching of steady carriers.
 //
 // History:
 //	2010-09-15  Initial creation MSW
 //	2011-03-27  Initial release
+//	2026-10-19  Added spectral noise reduction and auto notch
 //////////////////////////////////////////////////////////////////////
 #ifndef FASTFIR_H
 #define FASTFIR_H
@@ -16,6 +21,8 @@
 #include "dsp/fft.h"
 #include <QMutex>
 
+#define FASTFIR_KERNEL_CACHE 8	//number of frequency domain kernels kept
+
 class CFastFIR  
 {
 public:
@@ -24,10 +31,32 @@ public:
 
 	void SetupParameters( TYPEREAL FLoCut,TYPEREAL FHiCut,TYPEREAL Offset, TYPEREAL SampleRate);
 	int ProcessData(int InLength, TYPECPX* InBuf, TYPECPX* OutBuf);
+	int ProcessData(int InLength, TYPECPX* InBuf, TYPEREAL* OutBuf);
+	int GetMaxOutputLength(int InLength);
+	//NRLevel is 0 to 99
+	void SetupBinGain(bool NROn, TYPEREAL NRLevel, bool NotchOn);
 
 private:
+	typedef struct _kernel
+	{
+		TYPEREAL FLoCut;
+		TYPEREAL FHiCut;
+		TYPEREAL Offset;
+		TYPEREAL SampleRate;
+		quint32 LastUse;	//0 if not used yet
+		TYPECPX* pCoef;		//frequency domain coefficients
+	}tKernel;
+
+	template <class T> int BufferData(int InLength, TYPECPX* InBuf, T* OutBuf);
+	int FilterBlock(TYPECPX* OutBuf);
+	int FilterBlock(TYPEREAL* OutBuf);
 	void CpxMpy(int N, TYPECPX* m, TYPECPX* src, TYPECPX* dest);
+	void CpxMpyReal(int N, TYPECPX* m, TYPECPX* src, TYPEREAL* dest);
 	void FreeMemory();
+	void DesignKernel(TYPEREAL FLoCut, TYPEREAL FHiCut, TYPEREAL SampleRate, TYPECPX* pCoef);
+	void CalcBinGainParams();
+	TYPECPX* CalcBinGains(TYPECPX* pSpectrum);
+	void NotchCarriers();
 
 	TYPEREAL m_FLoCut;
 	TYPEREAL m_FHiCut;
@@ -37,8 +66,30 @@ private:
 	int m_InBufInPos;
 	TYPEREAL* m_pWindowTbl;
 	TYPECPX* m_pFFTOverlapBuf;
-	TYPECPX* m_pFilterCoef;
+	TYPECPX* m_pFilterCoef;		//points to active kernel in m_KernelCache
+	quint32 m_KernelUseCount;
+	tKernel m_KernelCache[FASTFIR_KERNEL_CACHE];
 	TYPECPX* m_pFFTBuf;
+	TYPEREAL* m_pFFTRealBuf;	//packed half spectrum for real output
+
+	bool m_NROn;
+	bool m_NotchOn;
+	bool m_BinGainReset;	//restart the bin estimates at the next block
+	int m_NotchBins;		//bins each side of a carrier that are notched
+	int m_NotchDcBins;		//bins each side of 0 Hz never notched
+	TYPEREAL m_NRLevel;
+	TYPEREAL m_NRBeta;		//noise over subtraction factor
+	TYPEREAL m_NRFloor;		//minimum bin gain
+	TYPEREAL m_NRStep;		//minimum gain ratio between adjacent bins
+	TYPEREAL m_PwrAlpha;
+	TYPEREAL m_LongAlpha;
+	TYPEREAL m_GainAlpha;
+	TYPEREAL m_NoiseRise;	//per block noise floor rise factor
+	TYPEREAL* m_pBinPwr;	//smoothed power in each bin
+	TYPEREAL* m_pBinLong;	//long term power for carrier detection
+	TYPEREAL* m_pBinNoise;	//noise floor estimate in each bin
+	TYPEREAL* m_pBinGain;
+	TYPECPX* m_pGainCoef;	//active kernel times the bin gains
 	QMutex m_Mutex;		//for keeping threads from stomping on each other
 	CFft m_Fft;
 };
@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////
+// fastmath.h: inline math approximations for per sample DSP loops.
+//
+// History:
+//	2026-10-19  Initial creation
+//////////////////////////////////////////////////////////////////////
+#ifndef FASTMATH_H
+#define FASTMATH_H
+#include "dsp/datatypes.h"
+
+//fast atan2() polynomial coefficients(max error 1.7e-6 radians)
+#define ATAN_C1 0.99997726
+#define ATAN_C3 -0.33262347
+#define ATAN_C5 0.19354346
+#define ATAN_C7 -0.11643287
+#define ATAN_C9 0.05265332
+#define ATAN_C11 -0.01172120
+
+/////////////////////////////////////////////////////////////////////////////////
+// Fast atan2() approximation using a polynomial over 0 to 45 degrees.
+// Written without branches so loops calling it can be vectorized.
+/////////////////////////////////////////////////////////////////////////////////
+inline TYPEREAL FastAtan2(TYPEREAL y, TYPEREAL x)
+{
+	TYPEREAL ax = fabs(x);
+	TYPEREAL ay = fabs(y);
+	TYPEREAL mx = (ay>ax) ? ay : ax;
+	TYPEREAL mn = (ay>ax) ? ax : ay;
+	TYPEREAL a = mn/(mx + 1e-30);
+	TYPEREAL s = a*a;
+	TYPEREAL r = ((((( ATAN_C11*s + ATAN_C9)*s + ATAN_C7)*s + ATAN_C5)*s + ATAN_C3)*s + ATAN_C1)*a;
+	r = (ay>ax) ? (K_PI/2.0 - r) : r;
+	r = (x<0.0) ? (K_PI - r) : r;
+	return (y<0.0) ? -r : r;
+}
+
+#endif // FASTMATH_H
@@ -37,12 +37,23 @@ CFft::CFft()
 	m_FFTSize = 1024;
 	m_pWorkArea = NULL;
 	m_pSinCosTbl = NULL;
+	m_pRealWorkArea = NULL;
+	m_pRealSinCosTbl = NULL;
 	m_pWindowTbl = NULL;
 	m_pFFTPwrAveBuf = NULL;
 	m_pFFTAveBuf = NULL;
 	m_pFFTInBuf = NULL;
 	m_pFFTSumBuf = NULL;
 	m_pTranslateTbl = NULL;
+	m_pFFTPkHoldBuf = NULL;
+	m_pFFTMinHoldBuf = NULL;
+	m_pFFTRmsBuf = NULL;
+	m_pFFTPyramidBuf = NULL;
+	m_PyramidLevels = 0;
+	m_DetectorMask = 0;
+	m_PkDecayK = 1.0;
+	m_MinRiseK = 1.0;
+	m_RmsAlpha = 1.0;
 	m_dBCompensation = K_MAXDB;
 	SetFFTParams( 2048, FALSE ,0.0, 1000);
 	SetFFTAve( 1);
@@ -65,6 +76,16 @@ void CFft::FreeMemory()
 		delete m_pSinCosTbl;
 		m_pSinCosTbl = NULL;
 	}
+	if(m_pRealWorkArea)
+	{
+		delete m_pRealWorkArea;
+		m_pRealWorkArea = NULL;
+	}
+	if(m_pRealSinCosTbl)
+	{
+		delete m_pRealSinCosTbl;
+		m_pRealSinCosTbl = NULL;
+	}
 	if(m_pWindowTbl)
 	{
 		delete m_pWindowTbl;
@@ -95,6 +116,26 @@ void CFft::FreeMemory()
 		delete m_pTranslateTbl;
 		m_pTranslateTbl = NULL;
 	}
+	if(m_pFFTPkHoldBuf)
+	{
+		delete m_pFFTPkHoldBuf;
+		m_pFFTPkHoldBuf = NULL;
+	}
+	if(m_pFFTMinHoldBuf)
+	{
+		delete m_pFFTMinHoldBuf;
+		m_pFFTMinHoldBuf = NULL;
+	}
+	if(m_pFFTRmsBuf)
+	{
+		delete m_pFFTRmsBuf;
+		m_pFFTRmsBuf = NULL;
+	}
+	if(m_pFFTPyramidBuf)
+	{
+		delete m_pFFTPyramidBuf;
+		m_pFFTPyramidBuf = NULL;
+	}
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -112,6 +153,26 @@ void CFft::SetFFTAve( qint32 ave)
 	ResetFFT();
 }
 
+///////////////////////////////////////////////////////////////////
+//Enables the extra display detectors(peak hold, min hold, and RMS)
+// DetectorMask = OR of FFT_DETECT_xxx bits(0 disables all extra detectors)
+// PeakDecay = dB per FFT frame the peak hold trace falls back toward the signal
+// MinDecay = dB per FFT frame the min hold trace rises back toward the signal
+// RmsAve = number of FFT frames in the exponential RMS power average
+///////////////////////////////////////////////////////////////////
+void CFft::SetFFTDetectors( qint32 DetectorMask, double PeakDecay, double MinDecay, qint32 RmsAve)
+{
+	m_Mutex.lock();
+	m_DetectorMask = DetectorMask & (FFT_DETECT_PEAK | FFT_DETECT_MIN | FFT_DETECT_RMS);
+	m_PkDecayK = pow(10.0, -PeakDecay/10.0);	//convert dB/frame to power multipliers
+	m_MinRiseK = pow(10.0, MinDecay/10.0);
+	if(RmsAve < 1)
+		RmsAve = 1;
+	m_RmsAlpha = 1.0/(double)RmsAve;
+	ResetDetectors();
+	m_Mutex.unlock();
+}
+
 ///////////////////////////////////////////////////////////////////
 //FFT initialization and parameter setup function
 ///////////////////////////////////////////////////////////////////
@@ -151,21 +212,34 @@ qint32 i;
 		m_pWindowTbl = new double[m_FFTSize];
 		m_pSinCosTbl = new double[m_FFTSize/2];
 		m_pWorkArea = new qint32[ (qint32)sqrt((double)m_FFTSize)+2];
+		m_pRealSinCosTbl = new double[m_FFTSize/2];
+		m_pRealWorkArea = new qint32[ (qint32)sqrt((double)m_FFTSize)+2];
 		m_pFFTPwrAveBuf = new double[m_FFTSize];
 		m_pFFTAveBuf = new double[m_FFTSize];
 		m_pFFTSumBuf = new double[m_FFTSize];
+		m_pFFTPkHoldBuf = new double[m_FFTSize];
+		m_pFFTMinHoldBuf = new double[m_FFTSize];
+		m_pFFTRmsBuf = new double[m_FFTSize];
+		m_pFFTPyramidBuf = new double[m_FFTSize];
 		for(i=0; i<m_FFTSize; i++)
 		{
 			m_pFFTPwrAveBuf[i] = 0.0;
 			m_pFFTAveBuf[i] = 0.0;
 			m_pFFTSumBuf[i] = 0.0;
+			m_pFFTPyramidBuf[i] = 0.0;
 		}
+		m_PyramidLevels = 0;	//number of reduced levels below the full spectrum
+		while( (m_FFTSize>>(m_PyramidLevels+1)) >= FFT_PYRAMID_MINBINS )
+			m_PyramidLevels++;
 		m_pWorkArea[0] = 0;
 		m_pFFTInBuf = new double[m_FFTSize*2];
 		m_pTranslateTbl = new qint32[m_FFTSize];
 		for(i=0; i<m_FFTSize*2; i++)
 			m_pFFTInBuf[i] = 0.0;
 		makewt(m_FFTSize/2, m_pWorkArea, m_pSinCosTbl);
+		//real FFT of m_FFTSize points uses a m_FFTSize/2 complex FFT
+		makewt(m_FFTSize/4, m_pRealWorkArea, m_pRealSinCosTbl);
+		makect(m_FFTSize/4, m_pRealWorkArea, m_pRealSinCosTbl + m_FFTSize/4);
 
 //////////////////////////////////////////////////////////////////////
 // A pure input sin wave ... Asin(wt)... will produce an fft output 
@@ -253,11 +327,55 @@ void CFft::ResetFFT()
 		m_pFFTAveBuf[i] = 0.0;
 		m_pFFTSumBuf[i] = 0.0;
 	}
+	ResetDetectors();
 	m_AveCount = 0;
 	m_TotalCount = 0;
 	m_Mutex.unlock();
 }
 
+///////////////////////////////////////////////////////////////////
+//  Marks the detector buffers empty so the next FFT frame seeds them.
+// (must be called with m_Mutex locked)
+///////////////////////////////////////////////////////////////////
+void CFft::ResetDetectors()
+{
+	for(qint32 i=0; i<m_FFTSize;i++)
+	{
+		m_pFFTPkHoldBuf[i] = 0.0;
+		m_pFFTMinHoldBuf[i] = -1.0;
+		m_pFFTRmsBuf[i] = -1.0;
+	}
+}
+
+///////////////////////////////////////////////////////////////////
+//  Updates the enabled detectors for bin j with its new power value.
+// Called from inside the CpxFFT() bin loop so the power is only
+// calculated once and all work stays in the linear power domain.
+// The log conversion is done later only for the bins actually displayed.
+///////////////////////////////////////////////////////////////////
+inline void CFft::UpdateDetectors(qint32 j, double pwr)
+{
+double tmp;
+	if(m_DetectorMask & FFT_DETECT_PEAK)
+	{	//peak decays exponentially until exceeded by new power
+		tmp = m_pFFTPkHoldBuf[j]*m_PkDecayK;
+		m_pFFTPkHoldBuf[j] = (pwr > tmp) ? pwr : tmp;
+	}
+	if(m_DetectorMask & FFT_DETECT_MIN)
+	{	//min rises exponentially until undercut by new power (negative == empty)
+		tmp = m_pFFTMinHoldBuf[j]*m_MinRiseK;
+		m_pFFTMinHoldBuf[j] = ( (tmp < 0.0) || (pwr < tmp) ) ? pwr : tmp;
+	}
+	if(m_DetectorMask & FFT_DETECT_RMS)
+	{	//exponential average of power (negative == empty)
+		tmp = m_pFFTRmsBuf[j];
+		if(tmp < 0.0)
+			m_pFFTRmsBuf[j] = pwr;
+		else
+			m_pFFTRmsBuf[j] = tmp + m_RmsAlpha*(pwr - tmp);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 // "InBuf[]" is first multiplied by a window function, checked for overflow
 //	and then placed in the FFT input buffers and the FFT performed.
@@ -283,10 +401,35 @@ qint32 i;
 	//Calculate the complex FFT
 	bitrv2(m_FFTSize*2, m_pWorkArea + 2, m_pFFTInBuf);
 	CpxFFT(m_FFTSize*2, m_pFFTInBuf, m_pSinCosTbl);
+	UpdatePyramid();
 	m_Mutex.unlock();
 	return m_TotalCount;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Rebuilds the display spectrum pyramid from m_pFFTAveBuf.
+// Each level halves the number of bins by keeping the max of each
+// bin pair so any span can be drawn from a level that has between
+// one and two bins per screen pixel.  Total work is < m_FFTSize
+// compares per FFT and is only done for display FFT's.
+// (must be called with m_Mutex locked)
+//////////////////////////////////////////////////////////////////////
+void CFft::UpdatePyramid()
+{
+qint32 i;
+qint32 n;
+double* pSrc;
+double* pDst;
+	for(qint32 level=1; level<=m_PyramidLevels; level++)
+	{
+		pSrc = PyramidLevel(level-1);
+		pDst = PyramidLevel(level);
+		n = m_FFTSize>>level;
+		for(i=0; i<n; i++)
+			pDst[i] = (pSrc[2*i] > pSrc[2*i+1]) ? pSrc[2*i] : pSrc[2*i+1];
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 // The bin range is "start" to "stop" Hz.
 // The range of start to stop frequencies are mapped to the users
@@ -313,16 +456,168 @@ bool CFft::GetScreenIntegerFFTData(qint32 MaxHeight,
 								qint32 StopFreq,
 								qint32* OutBuf )
 {
+qint32* OutBufs[FFT_NUM_TRACES];
+	OutBufs[FFT_TRACE_AVE] = OutBuf;
+	OutBufs[FFT_TRACE_PEAK] = NULL;
+	OutBufs[FFT_TRACE_MIN] = NULL;
+	OutBufs[FFT_TRACE_RMS] = NULL;
+	return GetScreenIntegerFFTData(MaxHeight, MaxWidth, MaxdB, MindB,
+									StartFreq, StopFreq, OutBufs);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Same as above but fills one screen buffer per trace type.
+//  OutBufs[] is indexed by FFT_TRACE_xxx. A NULL entry(or a detector
+//  that is not enabled) is skipped so only the requested traces are
+//  converted to dB.  When several FFT bins map to one pixel the min
+//  hold trace keeps the lowest level and all others keep the highest.
+//////////////////////////////////////////////////////////////////////
+bool CFft::GetScreenIntegerFFTData(qint32 MaxHeight,
+								qint32 MaxWidth,
+								double MaxdB,
+								double MindB,
+								qint32 StartFreq,
+								qint32 StopFreq,
+								qint32* OutBufs[FFT_NUM_TRACES] )
+{
 qint32 i;
+qint32 t;
 qint32 y;
 qint32 x;
 qint32 m;
-qint32 ymax = 10000;
-qint32 xprev = -1;
-qint32 maxbin;
+qint32 yext;
+qint32 xprev;
+qint32 level;
+qint32 span;
+qint32* OutBuf;
+double* pBuf;
+double val;
+bool IsPwr;
+bool IsMin;
 double dBmaxOffset = MaxdB/10.0;
 double dBGainFactor = -10.0/(MaxdB-MindB);
 	m_Mutex.lock();
+	UpdateTranslateTbl(StartFreq, StopFreq, MaxWidth);
+	m = (m_FFTSize);
+	for(t=0; t<FFT_NUM_TRACES; t++)
+	{
+		OutBuf = OutBufs[t];
+		if(NULL == OutBuf)
+			continue;
+		switch(t)
+		{
+			case FFT_TRACE_PEAK:
+				pBuf = m_pFFTPkHoldBuf;
+				break;
+			case FFT_TRACE_MIN:
+				pBuf = m_pFFTMinHoldBuf;
+				break;
+			case FFT_TRACE_RMS:
+				pBuf = m_pFFTRmsBuf;
+				break;
+			default:
+				pBuf = m_pFFTAveBuf;	//already in log units
+				break;
+		}
+		if( (FFT_TRACE_AVE != t) && !(m_DetectorMask & (1<<t)) )
+			continue;
+		IsPwr = (FFT_TRACE_AVE != t);
+		IsMin = (FFT_TRACE_MIN == t);
+		xprev = -1;
+		yext = 0;
+		span = m_BinMax-m_BinMin;
+		if( span > m_PlotWidth )
+		{
+			//if more FFT points than plot points
+			//the averaged trace is read from the smallest pyramid level that
+			//still has at least one bin per pixel so this is O(plot width)
+			level = 0;
+			if( (FFT_TRACE_AVE == t) && !m_Invert )
+			{
+				while( (level < m_PyramidLevels) && ((span>>(level+1)) >= m_PlotWidth) )
+					level++;
+				pBuf = PyramidLevel(level);
+			}
+			for( i=(m_BinMin>>level); i<=(m_BinMax>>level); i++ )
+			{
+				if(m_Invert)
+					val = pBuf[(m-i)];
+				else
+					val = pBuf[i];
+				if(IsPwr)
+				{
+					if(val < 0.0)	//detector not seeded yet
+						val = 0.0;
+					val = log10(val + m_K_C) + m_K_B;
+				}
+				y = (qint32)((double)MaxHeight*dBGainFactor*(val - dBmaxOffset));
+				if(y<0)
+					y = 0;
+				if(y > MaxHeight)
+					y = MaxHeight;
+				//get fft bin to plot x coordinate transform
+				//(reduced bins are placed at the center of the bins they cover)
+				x = ( ((i<<level) + ((1<<level)>>1) - m_BinMin)*m_PlotWidth )/span;
+				if(x < 0)
+					x = 0;
+				if(x >= m_PlotWidth)
+					x = m_PlotWidth-1;
+				if( x==xprev )	// still mappped to same fft bin coordinate
+				{
+					if( IsMin ? (y > yext) : (y < yext) )	//store only the extreme value
+					{
+						OutBuf[x] = y;
+						yext = y;
+					}
+				}
+				else
+				{
+					OutBuf[x] = y;
+					xprev = x;
+					yext = y;
+				}
+			}
+		}
+		else
+		{
+			//if more plot points than FFT points
+			for( x=0; x<m_PlotWidth; x++ )
+			{
+				i = m_pTranslateTbl[x];	//get plot to fft bin coordinate transform
+				if(m_Invert)
+					val = pBuf[(m-i)];
+				else
+					val = pBuf[i];
+				if(IsPwr)
+				{
+					if(val < 0.0)	//detector not seeded yet
+						val = 0.0;
+					val = log10(val + m_K_C) + m_K_B;
+				}
+				y = (qint32)((double)MaxHeight*dBGainFactor*(val - dBmaxOffset));
+				if(y<0)
+					y = 0;
+				if(y > MaxHeight)
+					y = MaxHeight;
+				OutBuf[x] = y;
+			}
+		}
+	}
+	m_Mutex.unlock();
+	return m_Overload;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Recalculates the displayed bin range and rebuilds the pixel to bin
+// translate table if the frequency span or plot width has changed.
+// When there are more bins than pixels the bin to pixel position is
+// calculated directly so no table over all the bins is needed.
+// (must be called with m_Mutex locked)
+//////////////////////////////////////////////////////////////////////
+void CFft::UpdateTranslateTbl(qint32 StartFreq, qint32 StopFreq, qint32 MaxWidth)
+{
+qint32 i;
+qint32 maxbin;
 	if( (m_StartFreq != StartFreq) ||
 		(m_StopFreq != StopFreq) ||
 		(m_PlotWidth != MaxWidth) )
@@ -343,80 +638,24 @@ double dBGainFactor = -10.0/(MaxdB-MindB);
 			m_BinMax = 0;
 		if(m_BinMax >= maxbin)
 			m_BinMax = maxbin;
-		if( (m_BinMax-m_BinMin) > m_PlotWidth )
-		{
-			//if more FFT points than plot points
-			for( i=m_BinMin; i<=m_BinMax; i++)
-				m_pTranslateTbl[i] = ( (i-m_BinMin)*m_PlotWidth )/(m_BinMax - m_BinMin);
-		}
-		else
+		if( (m_BinMax-m_BinMin) <= m_PlotWidth )
 		{
 			//if more plot points than FFT points
 			for( i=0; i<m_PlotWidth; i++)
 				m_pTranslateTbl[i] = m_BinMin + ( i*(m_BinMax - m_BinMin) )/m_PlotWidth;
 		}
 	}
-
-	m = (m_FFTSize);
-	if( (m_BinMax-m_BinMin) > m_PlotWidth )
-	{
-		//if more FFT points than plot points
-		for( i=m_BinMin; i<=m_BinMax; i++ )
-		{
-			if(m_Invert)
-				y = (qint32)((double)MaxHeight*dBGainFactor*(m_pFFTAveBuf[(m-i)] - dBmaxOffset));
-			else
-				y = (qint32)((double)MaxHeight*dBGainFactor*(m_pFFTAveBuf[i] - dBmaxOffset));
-			if(y<0)
-				y = 0;
-			if(y > MaxHeight)
-				y = MaxHeight;
-			x = m_pTranslateTbl[i];	//get fft bin to plot x coordinate transform
-			if( x==xprev )	// still mappped to same fft bin coordinate
-			{
-				if(y < ymax)		//store only the max value
-				{
-					OutBuf[x] = y;
-					ymax = y;
-				}
-			}
-			else
-			{
-				OutBuf[x] = y;
-				xprev = x;
-				ymax = y;
-			}
-		}
-	}
-	else
-	{
-		//if more plot points than FFT points
-		for( x=0; x<m_PlotWidth; x++ )
-		{
-			i = m_pTranslateTbl[x];	//get plot to fft bin coordinate transform
-			if(m_Invert)
-				y = (qint32)((double)MaxHeight*dBGainFactor*(m_pFFTAveBuf[(m-i)] - dBmaxOffset));
-			else
-				y = (qint32)((double)MaxHeight*dBGainFactor*(m_pFFTAveBuf[i] - dBmaxOffset));
-			if(y<0)
-				y = 0;
-			if(y > MaxHeight)
-				y = MaxHeight;
-			OutBuf[x] = y;
-		}
-	}
-	m_Mutex.unlock();
-	return m_Overload;
 }
 
 ///////////////////////////////////////////////////////////////////
 //Interface for doing fast convolution filters.  Takes complex data
 // in pInOutBuf and does fwd or rev FFT and places back in same buffer.
+// Does not touch the display averaging buffers.
 ///////////////////////////////////////////////////////////////////
 void CFft::FwdFFT( TYPECPX* pInOutBuf)
 {
 	bitrv2(m_FFTSize*2, m_pWorkArea + 2, (TYPEREAL*)pInOutBuf);
-	CpxFFT(m_FFTSize*2, (TYPEREAL*)pInOutBuf, m_pSinCosTbl);
+	cftfsub(m_FFTSize*2, (TYPEREAL*)pInOutBuf, m_pSinCosTbl);
 }
 
 void CFft::RevFFT( TYPECPX* pInOutBuf)
@@ -425,23 +664,57 @@ void CFft::RevFFT( TYPECPX* pInOutBuf)
 	cftbsub(m_FFTSize*2, (TYPEREAL*)pInOutBuf, m_pSinCosTbl);
 }
 
+///////////////////////////////////////////////////////////////////
+//Forward real FFT of m_FFTSize real samples in pInOutBuf using a
+// m_FFTSize/2 point complex FFT.  Bins 0 to N/2 of the spectrum, the same
+// values FwdFFT() gives for the samples with zero imaginary part, are
+// returned packed as
+//  re[0], re[N/2], re[1], im[1], ... re[N/2-1], im[N/2-1]
+// Bins N/2+1 to N-1 are the complex conjugates of bins N/2-1 to 1.
+///////////////////////////////////////////////////////////////////
+void CFft::FwdRealFFT( TYPEREAL* pInOutBuf)
+{
+qint32 n = m_FFTSize;
+TYPEREAL xi;
+	bitrv2(n, m_pRealWorkArea + 2, pInOutBuf);
+	cftfsub(n, pInOutBuf, m_pRealSinCosTbl);
+	rftfsub(n, pInOutBuf, n/4, m_pRealSinCosTbl + n/4);
+	xi = pInOutBuf[0] - pInOutBuf[1];
+	pInOutBuf[0] += pInOutBuf[1];
+	pInOutBuf[1] = xi;
+}
+
+///////////////////////////////////////////////////////////////////
+//Reverse real FFT for fast convolutions with real output.
+// pInOutBuf holds twice bins 0 to N/2 of a Hermitian spectrum packed as
+//  re[0], re[N/2], re[1], im[1], ... re[N/2-1], im[N/2-1]
+// and is replaced with the N real samples RevFFT() would give for the
+// full spectrum, using a N/2 point complex FFT.
+///////////////////////////////////////////////////////////////////
+void CFft::RevRealFFT( TYPEREAL* pInOutBuf)
+{
+qint32 n = m_FFTSize;
+	pInOutBuf[1] = 0.5 * (pInOutBuf[0] - pInOutBuf[1]);
+	pInOutBuf[0] -= pInOutBuf[1];
+	rftbsub(n, pInOutBuf, n/4, m_pRealSinCosTbl + n/4);
+	bitrv2(n, m_pRealWorkArea + 2, pInOutBuf);
+	cftbsub(n, pInOutBuf, m_pRealSinCosTbl);
+}
+
 
 ///////////////////////////////////////////////////////////////////
 // Nitty gritty fft routines by Takuya OOURA(Updated to his new version 4-18-02)
-// Routine calculates real FFT
+// Routine does the complex to real split for the forward real FFT
 ///////////////////////////////////////////////////////////////////
 void CFft::rftfsub(qint32 n, double *a, qint32 nc, double *c)
 {
 qint32 j, k, kk, ks, m;
 double wkr, wki, xr, xi, yr, yi;
 
-	m_TotalCount++;
- 	if(m_AveCount < m_AveSize)
-		m_AveCount++;
-    m = n >> 1;
-    ks = 2 * nc/m;
-    kk = 0;
-	for (j = 2; j < m; j += 2 ) 
+	m = n >> 1;
+	ks = 2 * nc / m;
+	kk = 0;
+	for (j = 2; j < m; j += 2)
 	{
 		k = n - j;
 		kk += ks;
@@ -452,58 +725,42 @@ double wkr, wki, xr, xi, yr, yi;
 		yr = wkr * xr - wki * xi;
 		yi = wkr * xi + wki * xr;
 		a[j] -= yr;
-		xi = a[j]*a[j];
-		a[j+1] -= yi;
-		xi += ( a[j+1]*a[j+1]);
+		a[j + 1] -= yi;
 		a[k] += yr;
-		xr = a[k]*a[k];
-		a[k+1] -= yi;
-		xr += (a[k+1]*a[k+1]);
-
-		//xr is real power  xi is imag power terms
-		//perform moving average on power up to m_AveSize then do exponential averaging after that
-		if(m_TotalCount <= m_AveSize)
-		{
-			m_pFFTSumBuf[j] = m_pFFTSumBuf[j] + xi;
-			m_pFFTSumBuf[k] = m_pFFTSumBuf[k] + xr;
-		}
-		else
-		{
-			m_pFFTSumBuf[j] = m_pFFTSumBuf[j] - m_pFFTPwrAveBuf[j] + xi;
-			m_pFFTSumBuf[k] = m_pFFTSumBuf[k] - m_pFFTPwrAveBuf[k] + xr;
-		}
-		m_pFFTPwrAveBuf[j] = m_pFFTSumBuf[j]/(double)m_AveCount;
-		m_pFFTPwrAveBuf[k] = m_pFFTSumBuf[k]/(double)m_AveCount;
-
-		m_pFFTAveBuf[j] = log10(m_pFFTPwrAveBuf[j] + m_K_C) + m_K_B;
-		m_pFFTAveBuf[k] = log10(m_pFFTPwrAveBuf[k] + m_K_C) + m_K_B;
-
+		a[k + 1] -= yi;
 	}
+}
 
-	a[0] *= a[0];						//calc DC term
-	xr = a[m]*a[m]+a[m+1]*a[m+1];		//calculate N/4(middle) term
+///////////////////////////////////////////////////////////////////
+// Routine does the real to complex split for the reverse real FFT
+///////////////////////////////////////////////////////////////////
+void CFft::rftbsub(qint32 n, double *a, qint32 nc, double *c)
+{
+qint32 j, k, kk, ks, m;
+double wkr, wki, xr, xi, yr, yi;
 
-	//xr is real power  a[0] is imag power terms
-	//perform moving average on power up to m_AveSize then do exponential averaging after that
-	if(m_TotalCount <= m_AveSize)
+	a[1] = -a[1];
+	m = n >> 1;
+	ks = 2 * nc / m;
+	kk = 0;
+	for (j = 2; j < m; j += 2)
 	{
-		m_pFFTSumBuf[0] = m_pFFTSumBuf[0] + a[0];
-		m_pFFTSumBuf[n/2] = m_pFFTSumBuf[n/2] + xr;
-	}
-	else
-	{
-		m_pFFTSumBuf[0] = m_pFFTSumBuf[0] - m_pFFTPwrAveBuf[0] + a[0];
-		m_pFFTSumBuf[n/2] = m_pFFTSumBuf[n/2] - m_pFFTPwrAveBuf[n/2] + xr;
+		k = n - j;
+		kk += ks;
+		wkr = 0.5 - c[nc - kk];
+		wki = c[kk];
+		xr = a[j] - a[k];
+		xi = a[j + 1] + a[k + 1];
+		yr = wkr * xr + wki * xi;
+		yi = wkr * xi - wki * xr;
+		a[j] -= yr;
+		a[j + 1] = yi - a[j + 1];
+		a[k] += yr;
+		a[k + 1] = yi - a[k + 1];
 	}
-	m_pFFTPwrAveBuf[0] = m_pFFTSumBuf[0]/(double)m_AveCount;
-	m_pFFTPwrAveBuf[n/2] = m_pFFTSumBuf[n/2]/(double)m_AveCount;
-
-	m_pFFTAveBuf[0] = log10(m_pFFTPwrAveBuf[0] + m_K_C) + m_K_B;
-	m_pFFTAveBuf[n/2] = log10(m_pFFTPwrAveBuf[n/2] + m_K_C) + m_K_B;
-
+	a[m + 1] = -a[m + 1];
 }
 
-
 ///////////////////////////////////////////////////////////////////
 // Routine calculates complex FFT
 ///////////////////////////////////////////////////////////////////
@@ -573,6 +830,8 @@ double x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
 			m_pFFTSumBuf[j] = m_pFFTSumBuf[j] - m_pFFTPwrAveBuf[j] + x0r;
 		m_pFFTPwrAveBuf[j] = m_pFFTSumBuf[j]/(double)m_AveCount;
 		m_pFFTAveBuf[j] = log10( m_pFFTPwrAveBuf[j] + m_K_C) + m_K_B;
+		if(m_DetectorMask)
+			UpdateDetectors(j, x0r);
 	}
 	// FFT output index N/2 to N-1  (times 2 since complex samples)
 	// is frequency output -Fs/2 to 0  
@@ -586,6 +845,8 @@ double x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
 			m_pFFTSumBuf[j] = m_pFFTSumBuf[j] - m_pFFTPwrAveBuf[j] + x0r;
 		m_pFFTPwrAveBuf[j] = m_pFFTSumBuf[j]/(double)m_AveCount;
 		m_pFFTAveBuf[j] = log10( m_pFFTPwrAveBuf[j] + m_K_C) + m_K_B;
+		if(m_DetectorMask)
+			UpdateDetectors(j, x0r);
 	}
 
 }
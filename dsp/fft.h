@@ -20,6 +20,19 @@
 
 #define MAX_FFT_SIZE 65536
 #define MIN_FFT_SIZE 512
+#define FFT_PYRAMID_MINBINS 64	//smallest reduced spectrum level kept in the display pyramid
+
+//display trace index values for the multi-trace GetScreenIntegerFFTData(...)
+#define FFT_TRACE_AVE 0		//normal averaged trace(always available)
+#define FFT_TRACE_PEAK 1	//peak hold trace
+#define FFT_TRACE_MIN 2		//min hold trace
+#define FFT_TRACE_RMS 3		//exponential RMS power average trace
+#define FFT_NUM_TRACES 4
+
+//detector enable bits for SetFFTDetectors(...)
+#define FFT_DETECT_PEAK (1<<FFT_TRACE_PEAK)
+#define FFT_DETECT_MIN (1<<FFT_TRACE_MIN)
+#define FFT_DETECT_RMS (1<<FFT_TRACE_RMS)
 
 class CFft
 {
@@ -32,24 +45,39 @@ public:
 						double SampleFreq);
 	//Methods to obtain spectrum formated power vs frequency
 	void SetFFTAve( qint32 ave);
+	void SetFFTDetectors( qint32 DetectorMask, double PeakDecay, double MinDecay, qint32 RmsAve);
 	void ResetFFT();
 	bool GetScreenIntegerFFTData(qint32 MaxHeight, qint32 MaxWidth,
 									double MaxdB, double MindB,
 									qint32 StartFreq, qint32 StopFreq,
 									qint32* OutBuf );
+	bool GetScreenIntegerFFTData(qint32 MaxHeight, qint32 MaxWidth,
+									double MaxdB, double MindB,
+									qint32 StartFreq, qint32 StopFreq,
+									qint32* OutBufs[FFT_NUM_TRACES] );
 	qint32 PutInDisplayFFT(qint32 n, TYPECPX* InBuf);
 
 	//Methods for doing Fast convolutions using forward and reverse FFT
 	void FwdFFT( TYPECPX* pInOutBuf);
 	void RevFFT( TYPECPX* pInOutBuf);
+	//real FFT size samples to/from half spectrum in Ooura's packed format
+	void FwdRealFFT( TYPEREAL* pInOutBuf);
+	void RevRealFFT( TYPEREAL* pInOutBuf);
 
 private:
 	void FreeMemory();
+	void ResetDetectors();
+	void UpdateDetectors(qint32 j, double pwr);
+	void UpdateTranslateTbl(qint32 StartFreq, qint32 StopFreq, qint32 MaxWidth);
+	void UpdatePyramid();
+	double* PyramidLevel(qint32 level){return (0==level) ? m_pFFTAveBuf :
+							m_pFFTPyramidBuf + (m_FFTSize - (m_FFTSize>>(level-1)));}
 	void makewt(qint32 nw, qint32 *ip, double *w);
 	void makect(qint32 nc, qint32 *ip, double *c);
 	void bitrv2(qint32 n, qint32 *ip, double *a);
 	void cftfsub(qint32 n, double *a, double *w);
 	void rftfsub(qint32 n, double *a, qint32 nc, double *c);
+	void rftbsub(qint32 n, double *a, qint32 nc, double *c);
 	void CpxFFT(qint32 n, double *a, double *w);
 	void cft1st(qint32 n, double *a, double *w);
 	void cftmdl(qint32 n, qint32 l, double *a, double *w);
@@ -68,19 +96,30 @@ private:
 	qint32 m_BinMin;
 	qint32 m_BinMax;
 	qint32 m_PlotWidth;
+	qint32 m_DetectorMask;
+	qint32 m_PyramidLevels;
 
 	double m_K_C;
 	double m_K_B;
 	double m_dBCompensation;
 	double m_SampleFreq;
+	double m_PkDecayK;
+	double m_MinRiseK;
+	double m_RmsAlpha;
 	qint32* m_pWorkArea;
 	qint32* m_pTranslateTbl;
 	double* m_pSinCosTbl;
+	qint32* m_pRealWorkArea;	//tables for the real FFT(half size complex FFT)
+	double* m_pRealSinCosTbl;
 	double* m_pWindowTbl;
 	double* m_pFFTPwrAveBuf;
 	double* m_pFFTAveBuf;
 	double* m_pFFTSumBuf;
 	double* m_pFFTInBuf;
+	double* m_pFFTPkHoldBuf;	//detector buffers are kept in linear power units
+	double* m_pFFTMinHoldBuf;
+	double* m_pFFTRmsBuf;
+	double* m_pFFTPyramidBuf;	//max reduced copies of m_pFFTAveBuf(N/2,N/4,...bins)
 	QMutex m_Mutex;		//for keeping threads from stomping on each other
 };
 
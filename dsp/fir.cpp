@@ -1,8 +1,8 @@
 //////////////////////////////////////////////////////////////////////
 // fir.cpp: implementation of the CFir class.
 //
-//  This class implements a FIR  filter using a double flat coefficient
-//array to eliminate testing for buffer wrap around.
+//  This class designs FIR filters, the filtering is done by the
+//CFirFilter engine so any number of taps can be used.
 //
 //Filter coefficients can be from a fixed table or this class will create
 // a lowpass or highpass filter from frequency and attenuation specifications
@@ -11,6 +11,7 @@
 // History:
 //	2011-01-29  Initial creation MSW
 //	2011-03-27  Initial release
+//	2026-10-19  Filtering moved to CFirFilter, removed 75 tap limit
 //////////////////////////////////////////////////////////////////////
 
 //==========================================================================================
@@ -56,73 +57,45 @@
 /////////////////////////////////////////////////////////////////////////////////
 CFir::CFir()
 {
+	m_SampleRate = 1.0;
 	m_NumTaps = 1;
-	m_State = 0;
+	m_Coef.fill(1.0, 1);
+	m_ICoef = m_Coef;
+	m_QCoef = m_Coef;
+	LoadFilters();
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+//	Loads the current coefficients into the filter engines and clears
+// their history. Called with m_Mutex locked.
+/////////////////////////////////////////////////////////////////////////////////
+void CFir::LoadFilters()
+{
+	m_RealFir.Init(m_NumTaps, m_Coef.constData());
+	m_CpxFir.InitIQ(m_NumTaps, m_ICoef.constData(), m_QCoef.constData());
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////
 //	Process InLength InBuf[] samples and place in OutBuf[]
-//  Note the Coefficient array is twice the length and has a duplicated set
-// in order to eliminate testing for buffer wrap in the inner loop
-//  ex: if 3 tap FIR with coefficients{21,-43,15} is made into a array of 6 entries
-//   {21, -43, 15, 21, -43, 15 }
 //REAL version
 /////////////////////////////////////////////////////////////////////////////////
 void CFir::ProcessFilter(int InLength, TYPEREAL* InBuf, TYPEREAL* OutBuf)
 {
-TYPEREAL acc;
-TYPEREAL* Zptr;
-const double* Hptr;
 	m_Mutex.lock();
-	for(int i=0; i<InLength; i++)
-	{
-		m_rZBuf[m_State] = InBuf[i];
-		Hptr = &m_Coef[m_NumTaps - m_State];
-		Zptr = m_rZBuf;
-		acc = (*Hptr++ * *Zptr++);	//do the 1st MAC
-		for(int j=1; j<m_NumTaps; j++)
-			acc += (*Hptr++ * *Zptr++);	//do the remaining MACs
-		if(--m_State < 0)
-			m_State += m_NumTaps;
-		OutBuf[i] = acc;
-	}
+	m_RealFir.ProcessData(InLength, InBuf, OutBuf);
 	m_Mutex.unlock();
 }
 
 /////////////////////////////////////////////////////////////////////////////////
 //	Process InLength InBuf[] samples and place in OutBuf[]
-//  Note the Coefficient array is twice the length and has a duplicated set
-// in order to eliminate testing for buffer wrap in the inner loop
-//  ex: if 3 tap FIR with coefficients{21,-43,15} is mae into a array of 6 entries
-//   {21, -43, 15, 21, -43, 15 }
+//  The I and Q parts are filtered with the I and Q coefficients.
 //COMPLEX version
 /////////////////////////////////////////////////////////////////////////////////
 void CFir::ProcessFilter(int InLength, TYPECPX* InBuf, TYPECPX* OutBuf)
 {
-TYPECPX acc;
-TYPECPX* Zptr;
-TYPEREAL* HIptr;
-TYPEREAL* HQptr;
-
 	m_Mutex.lock();
-	for(int i=0; i<InLength; i++)
-	{
-		m_cZBuf[m_State] = InBuf[i];
-		HIptr = m_ICoef + m_NumTaps - m_State;
-		HQptr = m_QCoef + m_NumTaps - m_State;
-		Zptr = m_cZBuf;
-		acc.re = (*HIptr++ * (*Zptr).re);		//do the first MAC
-		acc.im = (*HQptr++ * (*Zptr++).im);
-		for(int j=1; j<m_NumTaps; j++)
-		{
-			acc.re += (*HIptr++ * (*Zptr).re);		//do the remaining MACs
-			acc.im += (*HQptr++ * (*Zptr++).im);
-		}
-		if(--m_State < 0)
-			m_State += m_NumTaps;
-		OutBuf[i] = acc;
-	}
+	m_CpxFir.ProcessData(InLength, InBuf, OutBuf);
 	m_Mutex.unlock();
 }
 
@@ -133,22 +106,13 @@ TYPEREAL* HQptr;
 void CFir::InitConstFir( int NumTaps, const double* pCoef)
 {
 	m_Mutex.lock();
-	if(NumTaps>MAX_NUMCOEF)
-		m_NumTaps = MAX_NUMCOEF;
-	else
-		m_NumTaps = NumTaps;
+	m_NumTaps = NumTaps;
+	m_Coef.resize(m_NumTaps);
 	for(int i=0; i<m_NumTaps; i++)
-	{
 		m_Coef[i] = pCoef[i];
-		m_Coef[m_NumTaps+i] = pCoef[i];	//create duplicate for calculation efficiency
-	}
-	for(int i=0; i<m_NumTaps; i++)
-	{	//zero input buffers
-		m_rZBuf[i] = 0.0;
-		m_cZBuf[i].re = 0.0;
-		m_cZBuf[i].im = 0.0;
-	}
-	m_State = 0;	//zero filter state variable
+	m_ICoef = m_Coef;
+	m_QCoef = m_Coef;
+	LoadFilters();
 	m_Mutex.unlock();
 }
 
@@ -197,6 +161,7 @@ void CFir::InitConstFir( int NumTaps, const double* pCoef)
 		m_NumTaps = MAX_NUMCOEF;
 	if(m_NumTaps < 3)
 		m_NumTaps = 3;
+	m_Coef.resize(m_NumTaps);
 
 	TYPEREAL fCenter = .5*(TYPEREAL)(m_NumTaps-1);
 	TYPEREAL izb = Izero(Beta);		//precalculate denominator since is same for all points
@@ -214,25 +179,10 @@ void CFir::InitConstFir( int NumTaps, const double* pCoef)
 		m_Coef[n] = Scale * c * Izero( Beta * sqrt(1 - (x*x) ) )  / izb;
 	}
 
-	//make a 2x length array for FIR flat calculation efficiency
-	for (n = 0; n < m_NumTaps; n++)
-		m_Coef[n+m_NumTaps] = m_Coef[n];
-
-	//copy into complex coef buffers
-	for (n = 0; n < m_NumTaps*2; n++)
-	{
-		m_ICoef[n] = m_Coef[n];
-		m_QCoef[n] = m_Coef[n];
-	}
-
-	//Initialize the FIR buffers and state
-	for(int i=0; i<m_NumTaps; i++)
-	{
-		m_rZBuf[i] = 0.0;
-		m_cZBuf[i].re = 0.0;
-		m_cZBuf[i].im = 0.0;
-	}
-	m_State = 0;
+	//copy into complex coef buffers and load the filters
+	m_ICoef = m_Coef;
+	m_QCoef = m_Coef;
+	LoadFilters();
 
 	m_Mutex.unlock();
 
@@ -304,6 +254,7 @@ TYPEREAL Beta;
 		m_NumTaps = 3;
 
 	m_NumTaps |= 1;		//force to next odd number
+	m_Coef.resize(m_NumTaps);
 
 	TYPEREAL izb = Izero(Beta);		//precalculate denominator since is same for all points
 	TYPEREAL fCenter = .5*(TYPEREAL)(m_NumTaps-1);
@@ -322,25 +273,10 @@ TYPEREAL Beta;
 		m_Coef[n] = Scale * c * Izero( Beta * sqrt(1 - (x*x) ) )  / izb;
 	}
 
-	//make a 2x length array for FIR flat calculation efficiency
-	for (n = 0; n < m_NumTaps; n++)
-		m_Coef[n+m_NumTaps] = m_Coef[n];
-
-	//copy into complex coef buffers
-	for (n = 0; n < m_NumTaps*2; n++)
-	{
-		m_ICoef[n] = m_Coef[n];
-		m_QCoef[n] = m_Coef[n];
-	}
-
-	//Initialize the FIR buffers and state
-	for(int i=0; i<m_NumTaps; i++)
-	{
-		m_rZBuf[i] = 0.0;
-		m_cZBuf[i].re = 0.0;
-		m_cZBuf[i].im = 0.0;
-	}
-	m_State = 0;
+	//copy into complex coef buffers and load the filters
+	m_ICoef = m_Coef;
+	m_QCoef = m_Coef;
+	LoadFilters();
 
 	m_Mutex.unlock();
 
@@ -374,18 +310,15 @@ TYPEREAL Beta;
 void CFir::GenerateHBFilter( TYPEREAL FreqOffset)
 {
 int n;
+	m_Mutex.lock();
 	for(n=0; n<m_NumTaps; n++)
 	{
 		// apply complex frequency shift transform to low pass filter coefficients
 		m_ICoef[n] = 2.0 * m_Coef[n] * cos( (K_2PI*FreqOffset/m_SampleRate)*((TYPEREAL)n - ( (TYPEREAL)(m_NumTaps-1)/2.0 ) ) );
 		m_QCoef[n] = 2.0 * m_Coef[n] * sin( (K_2PI*FreqOffset/m_SampleRate)*((TYPEREAL)n - ( (TYPEREAL)(m_NumTaps-1)/2.0 ) ) );
 	}
-	//make a 2x length array for FIR flat calculation efficiency
-	for (n = 0; n < m_NumTaps; n++)
-	{
-		m_ICoef[n+m_NumTaps] = m_ICoef[n];
-		m_QCoef[n+m_NumTaps] = m_QCoef[n];
-	}
+	LoadFilters();
+	m_Mutex.unlock();
 #if 0		//debug hack to write m_Coef's to a file for analysis
 	QDir::setCurrent("d:/");
 	QFile File;
@@ -407,7 +340,7 @@ int n;
 }
 
 ///////////////////////////////////////////////////////////////////////////
-// private helper function to Compute Modified Bessel function I0(x)
+// static helper function to Compute Modified Bessel function I0(x)
 //     using a series approximation.
 // I0(x) = 1.0 + { sum from k=1 to infinity ---->  [(x/2)^k / k!]^2 }
 ///////////////////////////////////////////////////////////////////////////
@@ -1,20 +1,23 @@
 //////////////////////////////////////////////////////////////////////
 // fir.h: interface for the CFir class.
 //
-//  This class implements a FIR  filter using a double flat coefficient
-//array to eliminate testing for buffer wrap around.
+//  This class designs FIR filters and runs them on the CFirFilter
+//engine so the number of taps is not limited.
 //
 // History:
 //	2011-01-29  Initial creation MSW
 //	2011-03-27  Initial release
+//	2026-10-19  Filtering moved to CFirFilter, removed 75 tap limit
 //////////////////////////////////////////////////////////////////////
 #ifndef FIR_H
 #define FIR_H
 
 #include "dsp/datatypes.h"
-
-#define MAX_NUMCOEF 75
+#include "dsp/firfilter.h"
 #include <QMutex>
+#include <QVector>
+
+#define MAX_NUMCOEF 4095	//sanity limit on the designed filter length
 
 class CFir
 {
@@ -27,17 +30,17 @@ public:
 	void GenerateHBFilter( TYPEREAL FreqOffset);
 	void ProcessFilter(int InLength, TYPEREAL* InBuf, TYPEREAL* OutBuf);
 	void ProcessFilter(int InLength, TYPECPX* InBuf, TYPECPX* OutBuf);
+	static TYPEREAL Izero(TYPEREAL x);	//Kaiser window Bessel function
 
 private:
-	TYPEREAL Izero(TYPEREAL x);
+	void LoadFilters();
 	TYPEREAL m_SampleRate;
 	int m_NumTaps;
-	int m_State;
-	TYPEREAL m_Coef[MAX_NUMCOEF*2];
-	TYPEREAL m_ICoef[MAX_NUMCOEF*2];
-	TYPEREAL m_QCoef[MAX_NUMCOEF*2];
-	TYPEREAL m_rZBuf[MAX_NUMCOEF];
-	TYPECPX m_cZBuf[MAX_NUMCOEF];
+	QVector<TYPEREAL> m_Coef;
+	QVector<TYPEREAL> m_ICoef;
+	QVector<TYPEREAL> m_QCoef;
+	CFirFilter<TYPEREAL,TYPEREAL> m_RealFir;
+	CFirFilter<TYPECPX,TYPEREAL> m_CpxFir;	//separate I and Q taps
 	QMutex m_Mutex;		//for keeping threads from stomping on each other
 
 };
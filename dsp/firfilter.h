@@ -0,0 +1,314 @@
+//////////////////////////////////////////////////////////////////////
+// firfilter.h: interface and implementation of the CFirFilter template.
+//
+//  General purpose FIR filter engine.
+//	TD is the data type (TYPEREAL or TYPECPX) and TC the tap type.
+//	TYPEREAL taps on TYPECPX data filter I and Q separately(InitIQ() can
+//give I and Q their own taps), TYPECPX taps on TYPECPX data do a true
+//complex convolution. TYPECPX taps on TYPEREAL data are not supported.
+//	Any number of taps can be used. The filter can decimate by M and
+//interpolate by L(polyphase) with the output at L/M times the input rate.
+//When interpolating the taps are designed at L times the input rate and
+//should be scaled by L to keep unity gain.
+//	The taps are stored time reversed and padded to a multiple of
+//FIR_TAP_MULTIPLE in aligned memory so the inner loop is a plain dot
+//product against a linear history buffer. SSE2 kernels are used when
+//the compiler targets it with a plain C fallback.
+//	Not thread safe, the owner must serialize Init() and ProcessData().
+//
+// History:
+//	2026-10-19  Initial creation
+//////////////////////////////////////////////////////////////////////
+#ifndef FIRFILTER_H
+#define FIRFILTER_H
+
+#include "dsp/datatypes.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define FIR_SSE2
+#include <emmintrin.h>
+#endif
+
+#define FIR_BLOCK_SIZE 1024		//input samples copied into the history buffer per pass
+#define FIR_TAP_MULTIPLE 4		//taps per phase are padded to a multiple of this
+#define FIR_ALIGN 16			//byte alignment of the tap array
+
+//////////////////////////////////////////////////////////////////////
+// Tap conversion into the internal tap format which has the data type
+//////////////////////////////////////////////////////////////////////
+inline void FirSetTap(TYPEREAL& Tap, TYPEREAL Coef)
+{
+	Tap = Coef;
+}
+
+inline void FirSetTap(TYPECPX& Tap, TYPEREAL Coef)
+{
+	Tap.re = Coef;
+	Tap.im = Coef;
+}
+
+inline void FirSetTap(TYPECPX& Tap, const TYPECPX& Coef)
+{
+	Tap = Coef;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Dot product kernels, 'n' is a multiple of FIR_TAP_MULTIPLE and pH is
+// FIR_ALIGN aligned. The last parameter selects the kernel from the tap type.
+//////////////////////////////////////////////////////////////////////
+//real data, real taps
+inline void FirDot(const TYPEREAL* pX, const TYPEREAL* pH, int n, TYPEREAL& y, const TYPEREAL*)
+{
+#ifdef FIR_SSE2
+	__m128d a0 = _mm_setzero_pd();
+	__m128d a1 = _mm_setzero_pd();
+	for(int k=0; k<n; k+=4)
+	{
+		a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_loadu_pd(pX+k), _mm_load_pd(pH+k)));
+		a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(pX+k+2), _mm_load_pd(pH+k+2)));
+	}
+	a0 = _mm_add_pd(a0, a1);
+	a0 = _mm_add_sd(a0, _mm_unpackhi_pd(a0, a0));
+	_mm_store_sd(&y, a0);
+#else
+	TYPEREAL acc = 0.0;
+	for(int k=0; k<n; k++)
+		acc += pX[k]*pH[k];
+	y = acc;
+#endif
+}
+
+//complex data, separate real I and Q taps
+inline void FirDot(const TYPECPX* pX, const TYPECPX* pH, int n, TYPECPX& y, const TYPEREAL*)
+{
+#ifdef FIR_SSE2
+	const TYPEREAL* x = &pX[0].re;
+	const TYPEREAL* h = &pH[0].re;
+	__m128d a0 = _mm_setzero_pd();
+	__m128d a1 = _mm_setzero_pd();
+	__m128d a2 = _mm_setzero_pd();
+	__m128d a3 = _mm_setzero_pd();
+	for(int k=0; k<2*n; k+=8)
+	{
+		a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_loadu_pd(x+k), _mm_load_pd(h+k)));
+		a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(x+k+2), _mm_load_pd(h+k+2)));
+		a2 = _mm_add_pd(a2, _mm_mul_pd(_mm_loadu_pd(x+k+4), _mm_load_pd(h+k+4)));
+		a3 = _mm_add_pd(a3, _mm_mul_pd(_mm_loadu_pd(x+k+6), _mm_load_pd(h+k+6)));
+	}
+	_mm_storeu_pd(&y.re, _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)));
+#else
+	TYPECPX acc;
+	acc.re = 0.0;
+	acc.im = 0.0;
+	for(int k=0; k<n; k++)
+	{
+		acc.re += pX[k].re*pH[k].re;
+		acc.im += pX[k].im*pH[k].im;
+	}
+	y = acc;
+#endif
+}
+
+//complex data, complex taps
+inline void FirDot(const TYPECPX* pX, const TYPECPX* pH, int n, TYPECPX& y, const TYPECPX*)
+{
+#ifdef FIR_SSE2
+	const TYPEREAL* x = &pX[0].re;
+	const TYPEREAL* h = &pH[0].re;
+	__m128d a0 = _mm_setzero_pd();	//(xr*hr, xi*hi)
+	__m128d a1 = _mm_setzero_pd();	//(xi*hr, xr*hi)
+	for(int k=0; k<2*n; k+=2)
+	{
+		__m128d xv = _mm_loadu_pd(x+k);
+		__m128d hv = _mm_load_pd(h+k);
+		a0 = _mm_add_pd(a0, _mm_mul_pd(xv, hv));
+		a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_shuffle_pd(xv, xv, 1), hv));
+	}
+	_mm_store_sd(&y.re, _mm_sub_sd(a0, _mm_unpackhi_pd(a0, a0)));
+	_mm_store_sd(&y.im, _mm_add_sd(a1, _mm_unpackhi_pd(a1, a1)));
+#else
+	TYPECPX acc;
+	acc.re = 0.0;
+	acc.im = 0.0;
+	for(int k=0; k<n; k++)
+	{
+		acc.re += pX[k].re*pH[k].re - pX[k].im*pH[k].im;
+		acc.im += pX[k].re*pH[k].im + pX[k].im*pH[k].re;
+	}
+	y = acc;
+#endif
+}
+
+// *&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*&*
+template <class TD, class TC>
+class CFirFilter
+{
+public:
+	CFirFilter();
+	virtual ~CFirFilter();
+
+	void Init(int NumTaps, const TC* pCoef, int Decimation = 1, int Interpolation = 1);
+	//TYPECPX data only, separate I and Q taps
+	void InitIQ(int NumTaps, const TYPEREAL* pICoef, const TYPEREAL* pQCoef,
+				int Decimation = 1, int Interpolation = 1);
+	void Reset();	//clears the filter history
+	int GetNumTaps(){return m_NumTaps;}
+	//max number of output samples for InLength input samples
+	int GetOutLength(int InLength){return (InLength*m_Interp)/m_Decim + 1;}
+	//returns number of output samples. In place is OK if not interpolating
+	int ProcessData(int InLength, const TD* pInData, TD* pOutData);
+
+private:
+	void Setup(int NumTaps, const TD* pTaps, int Decimation, int Interpolation);
+	void FreeMem();
+
+	int m_NumTaps;
+	int m_PhaseTaps;	//padded taps per polyphase branch
+	int m_Decim;
+	int m_Interp;
+	int m_DecPhase;		//output samples to skip before the next kept one
+	char* m_pCoefMem;
+	TD* m_pCoef;		//m_Interp branches of m_PhaseTaps time reversed taps
+	TD* m_pBuf;			//filter history followed by new input samples
+};
+
+template <class TD, class TC>
+CFirFilter<TD,TC>::CFirFilter()
+{
+	m_NumTaps = 0;
+	m_PhaseTaps = 0;
+	m_Decim = 1;
+	m_Interp = 1;
+	m_DecPhase = 0;
+	m_pCoefMem = NULL;
+	m_pCoef = NULL;
+	m_pBuf = NULL;
+}
+
+template <class TD, class TC>
+CFirFilter<TD,TC>::~CFirFilter()
+{
+	FreeMem();
+}
+
+template <class TD, class TC>
+void CFirFilter<TD,TC>::FreeMem()
+{
+	if(m_pCoefMem)
+		delete[] m_pCoefMem;
+	if(m_pBuf)
+		delete[] m_pBuf;
+	m_pCoefMem = NULL;
+	m_pCoef = NULL;
+	m_pBuf = NULL;
+}
+
+template <class TD, class TC>
+void CFirFilter<TD,TC>::Init(int NumTaps, const TC* pCoef, int Decimation, int Interpolation)
+{
+	TD* pTaps = new TD[NumTaps];
+	for(int i=0; i<NumTaps; i++)
+		FirSetTap(pTaps[i], pCoef[i]);
+	Setup(NumTaps, pTaps, Decimation, Interpolation);
+	delete[] pTaps;
+}
+
+template <class TD, class TC>
+void CFirFilter<TD,TC>::InitIQ(int NumTaps, const TYPEREAL* pICoef, const TYPEREAL* pQCoef,
+							int Decimation, int Interpolation)
+{
+	TD* pTaps = new TD[NumTaps];
+	for(int i=0; i<NumTaps; i++)
+	{
+		pTaps[i].re = pICoef[i];
+		pTaps[i].im = pQCoef[i];
+	}
+	Setup(NumTaps, pTaps, Decimation, Interpolation);
+	delete[] pTaps;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Splits the taps into m_Interp polyphase branches.
+// Branch p holds taps p, p+L, p+2L... in reverse order so its last tap
+// multiplies the newest input sample.
+//////////////////////////////////////////////////////////////////////
+template <class TD, class TC>
+void CFirFilter<TD,TC>::Setup(int NumTaps, const TD* pTaps, int Decimation, int Interpolation)
+{
+	FreeMem();
+	m_NumTaps = NumTaps;
+	m_Decim = (Decimation < 1) ? 1 : Decimation;
+	m_Interp = (Interpolation < 1) ? 1 : Interpolation;
+	int ptaps = (NumTaps + m_Interp - 1)/m_Interp;
+	m_PhaseTaps = (ptaps + FIR_TAP_MULTIPLE - 1) & ~(FIR_TAP_MULTIPLE - 1);
+
+	int len = m_Interp*m_PhaseTaps;
+	m_pCoefMem = new char[len*sizeof(TD) + FIR_ALIGN];
+	int offset = (int)( (quintptr)m_pCoefMem & (FIR_ALIGN-1) );
+	m_pCoef = (TD*)(offset ? (m_pCoefMem + FIR_ALIGN - offset) : m_pCoefMem);
+	memset(m_pCoef, 0, len*sizeof(TD));
+	for(int p=0; p<m_Interp; p++)
+	{
+		TD* pBranch = &m_pCoef[p*m_PhaseTaps];
+		for(int k=0; k<ptaps; k++)
+		{
+			int n = k*m_Interp + p;
+			if(n < NumTaps)
+				pBranch[m_PhaseTaps-1-k] = pTaps[n];
+		}
+	}
+	m_pBuf = new TD[m_PhaseTaps - 1 + FIR_BLOCK_SIZE];
+	Reset();
+}
+
+template <class TD, class TC>
+void CFirFilter<TD,TC>::Reset()
+{
+	if(m_pBuf)
+		memset(m_pBuf, 0, (m_PhaseTaps - 1 + FIR_BLOCK_SIZE)*sizeof(TD));
+	m_DecPhase = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Each input sample gives m_Interp filter rate samples of which every
+// m_Decim'th is calculated, starting with the first one after Reset().
+//////////////////////////////////////////////////////////////////////
+template <class TD, class TC>
+int CFirFilter<TD,TC>::ProcessData(int InLength, const TD* pInData, TD* pOutData)
+{
+	if(!m_pBuf)
+		return 0;
+	int hist = m_PhaseTaps - 1;
+	int n = 0;
+	while(InLength > 0)
+	{
+		int len = (InLength < FIR_BLOCK_SIZE) ? InLength : FIR_BLOCK_SIZE;
+		memcpy(&m_pBuf[hist], pInData, len*sizeof(TD));
+		if( (1 == m_Interp) && (1 == m_Decim) )
+		{
+			for(int i=0; i<len; i++)
+				FirDot(&m_pBuf[i], m_pCoef, m_PhaseTaps, pOutData[n++], (const TC*)0);
+		}
+		else
+		{
+			for(int i=0; i<len; i++)
+			{
+				for(int p=0; p<m_Interp; p++)
+				{
+					if(0 == m_DecPhase)
+						FirDot(&m_pBuf[i], &m_pCoef[p*m_PhaseTaps], m_PhaseTaps, pOutData[n++], (const TC*)0);
+					if(++m_DecPhase >= m_Decim)
+						m_DecPhase = 0;
+				}
+			}
+		}
+		//move filter history to the start of the buffer
+		memmove(m_pBuf, &m_pBuf[len], hist*sizeof(TD));
+		pInData += len;
+		InLength -= len;
+	}
+	return n;
+}
+
+#endif // FIRFILTER_H
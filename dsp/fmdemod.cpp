@@ -39,6 +39,7 @@
 #include "fmdemod.h"
 #include "gui/testbench.h"
 #include "dsp/datatypes.h"
+#include "dsp/fastmath.h"
 #include <QDebug>
 
 
@@ -59,11 +60,15 @@
 /////////////////////////////////////////////////////////////////////////////////
 //	Construct FM demod object
 /////////////////////////////////////////////////////////////////////////////////
-CFmDemod::CFmDemod(TYPEREAL samplerate) : m_SampleRate(samplerate)
+CFmDemod::CFmDemod(TYPEREAL samplerate, CScratchArena* pScratch) : m_SampleRate(samplerate)
 {
 	m_FreqErrorDC = 0.0;
 	m_NcoPhase = 0.0;
 	m_NcoFreq = 0.0;
+	m_FastDisc = false;
+	m_DiscLastSample.re = 0.0;
+	m_DiscLastSample.im = 0.0;
+	m_pScratch = pScratch;
 
 	TYPEREAL norm = K_2PI/m_SampleRate;	//to normalize Hz to radians
 
@@ -108,15 +113,15 @@ void CFmDemod::InitNoiseSquelch()
 
 
 /////////////////////////////////////////////////////////////////////////////////
-// Performs noise squelch by reading the noise power above the voice frequencies
+// Updates the squelch state by reading the noise power above the voice
+//frequencies in the demodulated data
 /////////////////////////////////////////////////////////////////////////////////
-void CFmDemod::PerformNoiseSquelch(int InLength, TYPEREAL* pOutData)
+void CFmDemod::MeasureNoise(int InLength, TYPEREAL* pData)
 {
-	if(InLength>MAX_SQBUF_SIZE)
-		return;
-	TYPEREAL sqbuf[MAX_SQBUF_SIZE];
+	int mark = m_pScratch->GetMark();
+	TYPEREAL* sqbuf = m_pScratch->Alloc<TYPEREAL>(InLength);
 	//high pass filter to get the high frequency noise above the voice
-	m_HpFir.ProcessFilter(InLength, pOutData, sqbuf);
+	m_HpFir.ProcessFilter(InLength, pData, sqbuf);
 //g_pTestBench->DisplayData(InLength, sqbuf, m_SampleRate,PROFILE_6);
 	for(int i=0; i<InLength; i++)
 	{
@@ -125,6 +130,7 @@ void CFmDemod::PerformNoiseSquelch(int InLength, TYPEREAL* pOutData)
 		m_SquelchAve = (1.0-m_SquelchAlpha)*m_SquelchAve + m_SquelchAlpha*mag;
 //g_pTestBench->DisplayData(1, &m_SquelchAve, m_SampleRate,PROFILE_6);
 	}
+	m_pScratch->Release(mark);
 	//perform squelch compare to threshold using some Hysteresis
 	if(0==m_SquelchThreshold)
 	{	//force squelch if zero(strong signal threshold)
@@ -140,6 +146,14 @@ void CFmDemod::PerformNoiseSquelch(int InLength, TYPEREAL* pOutData)
 		if(m_SquelchAve >= (m_SquelchThreshold+SQUELCH_HYSTERESIS))
 			m_SquelchState = true;
 	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+// Performs noise squelch on the demodulated audio
+/////////////////////////////////////////////////////////////////////////////////
+void CFmDemod::PerformNoiseSquelch(int InLength, TYPEREAL* pOutData)
+{
+	MeasureNoise(InLength, pOutData);
 	if(m_SquelchState)
 	{	//zero output if squelched
 		for(int i=0; i<InLength; i++)
@@ -152,41 +166,41 @@ void CFmDemod::PerformNoiseSquelch(int InLength, TYPEREAL* pOutData)
 }
 
 /////////////////////////////////////////////////////////////////////////////////
-//	Process FM demod MONO version
+//	Runs only the noise squelch detector on 'InLength' input samples and
+// returns the new squelch state.  Used in place of ProcessData() while
+// squelched so the PLL and audio filter are skipped.  The discriminator
+// is used whichever demodulator is selected since it is the cheapest and
+// has the same output range as the PLL.
 /////////////////////////////////////////////////////////////////////////////////
-int CFmDemod::ProcessData(int InLength, TYPEREAL FmBW, TYPECPX* pInData, TYPEREAL* pOutData)
+bool CFmDemod::UpdateSquelch(int InLength, TYPEREAL FmBW, TYPECPX* pInData)
 {
-TYPECPX tmp;
 	if(m_SquelchHPFreq != FmBW)
 	{	//update squelch HP filter cutoff from main filter BW
 		m_SquelchHPFreq = FmBW;
 		InitNoiseSquelch();
 	}
-	for(int i=0; i<InLength; i++)
-	{
-		TYPEREAL Sin = sin(m_NcoPhase);
-		TYPEREAL Cos = cos(m_NcoPhase);
-		//complex multiply input sample by NCO's  sin and cos
-		tmp.re = Cos * pInData[i].re - Sin * pInData[i].im;
-		tmp.im = Cos * pInData[i].im + Sin * pInData[i].re;
-		//find current sample phase after being shifted by NCO frequency
-		TYPEREAL phzerror = -atan2(tmp.im, tmp.re);
+	int mark = m_pScratch->GetMark();
+	TYPEREAL* pDiscBuf = m_pScratch->Alloc<TYPEREAL>(InLength);
+	DiscriminatorDemod(InLength, pInData, pDiscBuf);
+	MeasureNoise(InLength, pDiscBuf);
+	m_pScratch->Release(mark);
+	return m_SquelchState;
+}
 
-		//create new NCO frequency term
-		m_NcoFreq += (m_PllBeta * phzerror);		//  radians per sampletime
-		//clamp NCO frequency so doesn't get out of lock range
-		if(m_NcoFreq > m_NcoHLimit)
-			m_NcoFreq = m_NcoHLimit;
-		else if(m_NcoFreq < m_NcoLLimit)
-			m_NcoFreq = m_NcoLLimit;
-		//update NCO phase with new value
-		m_NcoPhase += (m_NcoFreq + m_PllAlpha * phzerror);
-		//LP filter the NCO frequency term to get DC offset value
-		m_FreqErrorDC = (1.0-m_DcAlpha)*m_FreqErrorDC + m_DcAlpha*m_NcoFreq;
-		//subtract out DC term to get FM audio
-		pOutData[i] = (m_NcoFreq-m_FreqErrorDC)*m_OutGain;
+/////////////////////////////////////////////////////////////////////////////////
+//	Process FM demod MONO version
+/////////////////////////////////////////////////////////////////////////////////
+int CFmDemod::ProcessData(int InLength, TYPEREAL FmBW, TYPECPX* pInData, TYPEREAL* pOutData)
+{
+	if(m_SquelchHPFreq != FmBW)
+	{	//update squelch HP filter cutoff from main filter BW
+		m_SquelchHPFreq = FmBW;
+		InitNoiseSquelch();
 	}
-	m_NcoPhase = fmod(m_NcoPhase, K_2PI);	//keep radian counter bounded
+	if(m_FastDisc)
+		DiscriminatorDemod(InLength, pInData, pOutData);
+	else
+		PllDemod(InLength, pInData, pOutData);
 	PerformNoiseSquelch(InLength, pOutData);	//calculate squelch
 	return InLength;
 }
@@ -196,12 +210,35 @@ TYPECPX tmp;
 /////////////////////////////////////////////////////////////////////////////////
 int CFmDemod::ProcessData(int InLength, TYPEREAL FmBW, TYPECPX* pInData, TYPECPX* pOutData)
 {
-TYPECPX tmp;
 	if(m_SquelchHPFreq != FmBW)
 	{	//update Squelch HP filter cutoff from main filter BW
 		m_SquelchHPFreq = FmBW;
 		InitNoiseSquelch();
 	}
+	int mark = m_pScratch->GetMark();
+	TYPEREAL* pOutBuf = m_pScratch->Alloc<TYPEREAL>(InLength);
+	if(m_FastDisc)
+		DiscriminatorDemod(InLength, pInData, pOutBuf);
+	else
+		PllDemod(InLength, pInData, pOutBuf);
+	PerformNoiseSquelch(InLength, pOutBuf);
+	for(int i=0; i<InLength; i++)
+	{	//copy audio stream into both output channels for stereo version
+		pOutData[i].re = pOutBuf[i];
+		pOutData[i].im = pOutBuf[i];
+	}
+	m_pScratch->Release(mark);
+	return InLength;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+//	PLL FM demodulator
+// Tracks the input phase with an NCO and uses the NCO frequency term as the
+// demodulated output.
+/////////////////////////////////////////////////////////////////////////////////
+void CFmDemod::PllDemod(int InLength, TYPECPX* pInData, TYPEREAL* pOutData)
+{
+TYPECPX tmp;
 	for(int i=0; i<InLength; i++)
 	{
 		TYPEREAL Sin = sin(m_NcoPhase);
@@ -212,8 +249,9 @@ TYPECPX tmp;
 		//find current sample phase after being shifted by NCO frequency
 		TYPEREAL phzerror = -atan2(tmp.im, tmp.re);
 
+		//create new NCO frequency term
 		m_NcoFreq += (m_PllBeta * phzerror);		//  radians per sampletime
-		//clamp NCO frequency so doesn't drift out of lock range
+		//clamp NCO frequency so doesn't get out of lock range
 		if(m_NcoFreq > m_NcoHLimit)
 			m_NcoFreq = m_NcoHLimit;
 		else if(m_NcoFreq < m_NcoLLimit)
@@ -223,15 +261,44 @@ TYPECPX tmp;
 		//LP filter the NCO frequency term to get DC offset value
 		m_FreqErrorDC = (1.0-m_DcAlpha)*m_FreqErrorDC + m_DcAlpha*m_NcoFreq;
 		//subtract out DC term to get FM audio
-		m_OutBuf[i] = (m_NcoFreq-m_FreqErrorDC)*m_OutGain;
+		pOutData[i] = (m_NcoFreq-m_FreqErrorDC)*m_OutGain;
 	}
 	m_NcoPhase = fmod(m_NcoPhase, K_2PI);	//keep radian counter bounded
-	PerformNoiseSquelch(InLength, m_OutBuf);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+//	Delay line FM discriminator
+// The phase of x[n-1]*conj(x[n]) is the frequency in radians per sample
+// with the same sign as the PLL NCO frequency.
+// The first loop has no sample to sample dependency so can be vectorized.
+// Output is clamped to the same range as the PLL NCO so the noise squelch
+// and output levels behave the same as with the PLL demodulator.
+/////////////////////////////////////////////////////////////////////////////////
+void CFmDemod::DiscriminatorDemod(int InLength, TYPECPX* pInData, TYPEREAL* pOutData)
+{
+	if(InLength <= 0)
+		return;
+	TYPECPX last = m_DiscLastSample;
+	pOutData[0] = FastAtan2( pInData[0].re*last.im - pInData[0].im*last.re,
+							 pInData[0].re*last.re + pInData[0].im*last.im );
+	for(int i=1; i<InLength; i++)
+	{
+		TYPEREAL re = pInData[i].re*pInData[i-1].re + pInData[i].im*pInData[i-1].im;
+		TYPEREAL im = pInData[i].re*pInData[i-1].im - pInData[i].im*pInData[i-1].re;
+		pOutData[i] = FastAtan2(im, re);
+	}
+	m_DiscLastSample = pInData[InLength-1];
 	for(int i=0; i<InLength; i++)
-	{	//copy audio stream into both output channels for stereo version
-		pOutData[i].re = m_OutBuf[i];
-		pOutData[i].im = m_OutBuf[i];
+	{
+		TYPEREAL freq = pOutData[i];
+		//clamp frequency to the PLL lock range
+		if(freq > m_NcoHLimit)
+			freq = m_NcoHLimit;
+		else if(freq < m_NcoLLimit)
+			freq = m_NcoLLimit;
+		//LP filter the frequency term to get DC offset value
+		m_FreqErrorDC = (1.0-m_DcAlpha)*m_FreqErrorDC + m_DcAlpha*freq;
+		//subtract out DC term to get FM audio
+		pOutData[i] = (freq-m_FreqErrorDC)*m_OutGain;
 	}
-	return InLength;
 }
-
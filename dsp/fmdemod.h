@@ -10,25 +10,36 @@
 #include "dsp/datatypes.h"
 #include "dsp/fir.h"
 #include "dsp/iir.h"
-
-#define MAX_SQBUF_SIZE 16384
+#include "dsp/scratcharena.h"
 
 class CFmDemod
 {
 public:
-	CFmDemod(TYPEREAL samplerate);
+	CFmDemod(TYPEREAL samplerate, CScratchArena* pScratch);
 	//overloaded functions for mono and stereo
 	int ProcessData(int InLength, TYPEREAL FmBW, TYPECPX* pInData, TYPECPX* pOutData);
 	int ProcessData(int InLength, TYPEREAL FmBW, TYPECPX* pInData, TYPEREAL* pOutData);
 
 	void SetSquelch(int Value);		//call with range of 0 to 99 to set squelch threshold
+	bool IsSquelched(){return m_SquelchState;}	//true if the last block was muted
+	//runs only the noise squelch detector while the caller skips the demod
+	bool UpdateSquelch(int InLength, TYPEREAL FmBW, TYPECPX* pInData);
+	//selects delay line discriminator(true) or PLL(false) demodulator
+	void SetFastDiscriminator(bool FastDisc){m_FastDisc = FastDisc;}
+	//scratch arena bytes needed to process InLength samples
+	static int GetScratchBytes(int InLength)
+				{return 2*CScratchArena::AlignedSize(InLength*sizeof(TYPEREAL));}
 
 private:
+	void PllDemod(int InLength, TYPECPX* pInData, TYPEREAL* pOutData);
+	void DiscriminatorDemod(int InLength, TYPECPX* pInData, TYPEREAL* pOutData);
 	void PerformNoiseSquelch(int InLength, TYPECPX* pOutData);
 	void PerformNoiseSquelch(int InLength, TYPEREAL* pOutData);
+	void MeasureNoise(int InLength, TYPEREAL* pData);
 	void InitNoiseSquelch();
 
 	bool m_SquelchState;
+	bool m_FastDisc;
 	TYPEREAL m_SampleRate;
 	TYPEREAL m_SquelchHPFreq;
 	TYPEREAL m_OutGain;
@@ -41,13 +52,13 @@ private:
 	TYPEREAL m_NcoHLimit;
 	TYPEREAL m_PllAlpha;
 	TYPEREAL m_PllBeta;
+	TYPECPX m_DiscLastSample;	//previous input sample for the discriminator
 
 	TYPEREAL m_SquelchThreshold;
 	TYPEREAL m_SquelchAve;
 	TYPEREAL m_SquelchAlpha;
 
-	TYPEREAL m_OutBuf[MAX_SQBUF_SIZE];
-
+	CScratchArena* m_pScratch;	//working buffers
 	CFir m_HpFir;
 	CIir m_LpIir;
 
@@ -4,10 +4,15 @@
 //  This class implements a fractional resampler that can be used to
 //convert between different sample rates.  A windowes sinc interpolator
 // is used to create samples "in between" input samples.
+//  The windowed sinc is stored as a polyphase filter bank so each output
+// sample is two contiguous dot products with adjacent phases that are
+// then linearly interpolated.
 //
 // History:
 //	2010-09-15  Initial creation MSW
 //	2011-03-27  Initial release
+//	2026-10-19  Changed sinc table to polyphase filter bank
+//	2026-10-19  Added Skip() for squelched audio
 /////////////////////////////////////////////////////////////////////
 
 //==========================================================================================
@@ -40,21 +45,20 @@
 //==========================================================================================
 
 #include "dsp/fractresampler.h"
-#include <QDir>
-#include <QFile>
 #include <QDebug>
 
 //////////////////////////////////////////////////////////////////////
 // Local defines
 //////////////////////////////////////////////////////////////////////
-#define SINC_PERIOD_PTS 10000	//number of points in sinc table between "zero crossings"
-								//smaller value increases noise floor
+#define SINC_PHASES 128	//number of polyphase filter phases between "zero crossings"
+						//smaller value increases noise floor
 
 #define SINC_PERIODS 28	//number of input sample periods("zero crossings"-1) in
 						//sinc function(should be even)
 						//decreasing reduces alias free bandwidth
 
-#define SINC_LENGTH	( (SINC_PERIODS)*SINC_PERIOD_PTS + 1)//number of total points in sinc table
+//number of phases in table. The extra phase is the interpolation end point for the last one.
+#define SINC_NUMPHASES (SINC_PHASES+2)
 
 #define MAX_SOUNDCARDVAL 32767.0
 
@@ -64,32 +68,37 @@
 //////////////////////////////////////////////////////////////////////
 CFractResampler::CFractResampler()
 {
-	m_pSinc = NULL;
+	m_pCoef = NULL;
 	m_pInputBuf = NULL;
 
 }
 
 CFractResampler::~CFractResampler()
 {
-	if(m_pSinc)
-		delete m_pSinc;
+	if(m_pCoef)
+		delete m_pCoef;
 	if(m_pInputBuf)
 		delete m_pInputBuf;
 }
 //
 
 //////////////////////////////////////////////////////////////////////
-// Initialize resampler memory and create windowed sinc table
+// Initialize resampler memory and create windowed sinc polyphase table
 // MaxInputSize is the largest number of input samples expected to be processed
+//
+// Phase k tap i holds the windowed sinc at position i + k/SINC_PHASES
+// input periods from the start of the sinc which is centered at SINC_PERIODS/2.
+// The table is 130*28 points(~29KB) so it stays in cache.
 //////////////////////////////////////////////////////////////////////
 void CFractResampler::Init(int MaxInputSize)
 {
 int i;
+int k;
 TYPEREAL fi;
 TYPEREAL window;
 	MaxInputSize += SINC_PERIODS;	//expand buffer size  to include wrap around
-	if(NULL == m_pSinc)
-		m_pSinc = new  TYPEREAL[SINC_LENGTH];
+	if(NULL == m_pCoef)
+		m_pCoef = new TYPEREAL[SINC_NUMPHASES*SINC_PERIODS];
 	if(m_pInputBuf)
 		delete m_pInputBuf;
 	m_pInputBuf = new TYPECPX[MaxInputSize];
@@ -98,40 +107,114 @@ TYPEREAL window;
 		m_pInputBuf[i].re = 0.0;
 		m_pInputBuf[i].im = 0.0;
 	}
-	for(i=0; i<SINC_LENGTH; i++)
-	{	//calc Blackman-Harris window points
-		window = (0.35875
-				- 0.48829*cos( (K_2PI*i)/(SINC_LENGTH-1) )
-				+ 0.14128*cos( (2.0*K_2PI*i)/(SINC_LENGTH-1) )
-				- 0.01168*cos( (3.0*K_2PI*i)/(SINC_LENGTH-1) ) );
-		//calculate sin(x)/x    sinc point * window
-		fi = K_PI*(double)(i - SINC_LENGTH/2)/(double)SINC_PERIOD_PTS ;
-		if(i != SINC_LENGTH/2)
-			m_pSinc[i] = window * (TYPEREAL)sin( (double)fi )/(double)fi;
-		else
-			m_pSinc[i] = 1.0;
-
+	for(k=0; k<SINC_NUMPHASES; k++)
+	{
+		for(i=0; i<SINC_PERIODS; i++)
+		{
+			TYPEREAL x = (TYPEREAL)i + (TYPEREAL)k/(TYPEREAL)SINC_PHASES;
+			TYPEREAL* pCoef = &m_pCoef[k*SINC_PERIODS + i];
+			if(x > (TYPEREAL)SINC_PERIODS)
+			{	//past end of window
+				*pCoef = 0.0;
+				continue;
+			}
+			//calc Blackman-Harris window points
+			TYPEREAL w = x/(TYPEREAL)SINC_PERIODS;
+			window = (0.35875
+					- 0.48829*cos( K_2PI*w )
+					+ 0.14128*cos( 2.0*K_2PI*w )
+					- 0.01168*cos( 3.0*K_2PI*w ) );
+			//calculate sin(x)/x    sinc point * window
+			fi = K_PI*(x - (TYPEREAL)(SINC_PERIODS/2));
+			if(fabs(fi) > 1e-12)
+				*pCoef = window * (TYPEREAL)sin( (double)fi )/(double)fi;
+			else
+				*pCoef = 1.0;
+		}
 	}
 	m_FloatTime = 0.0;		//init floating point time accumulator
+}
 
-#if 0		//debug hack to write m_pSinc to a file for analysis
-	QDir::setCurrent("d:/");
-	QFile File;
-	File.setFileName("Sinc.txt");
-	if(File.open(QIODevice::WriteOnly))
+//////////////////////////////////////////////////////////////////////
+// Returns the first of the two polyphase coefficient rows bracketing
+// the current output time and the linear interpolation factor between them.
+// The sinc is convolved with input samples IntegerTime+1 to IntegerTime+SINC_PERIODS
+//////////////////////////////////////////////////////////////////////
+inline TYPEREAL* CFractResampler::GetPhaseCoef(int IntegerTime, TYPEREAL& mu)
+{
+	TYPEREAL pf = ((TYPEREAL)(IntegerTime+1) - m_FloatTime) * (TYPEREAL)SINC_PHASES;
+	int k = (int)pf;
+	mu = pf - (TYPEREAL)k;
+	return &m_pCoef[k*SINC_PERIODS];
+}
+
+//////////////////////////////////////////////////////////////////////
+// Calculates one complex output sample at the current output time
+//////////////////////////////////////////////////////////////////////
+inline TYPECPX CFractResampler::ConvolveCpx(int IntegerTime)
+{
+TYPEREAL mu;
+TYPECPX acc;
+	const TYPEREAL* pC0 = GetPhaseCoef(IntegerTime, mu);
+	const TYPEREAL* pC1 = pC0 + SINC_PERIODS;
+	const TYPECPX* pIn = &m_pInputBuf[IntegerTime+1];
+	TYPEREAL a0re = 0.0;
+	TYPEREAL a0im = 0.0;
+	TYPEREAL a1re = 0.0;
+	TYPEREAL a1im = 0.0;
+	for(int i=0; i<SINC_PERIODS; i++)
 	{
-		qDebug()<<"file Opened OK";
-		char Buf[30000];
-		for( i=0; i<SINC_LENGTH; i++)
-		{
-			sprintf( Buf, "%19.12g\r\n", m_pSinc[i]);
-			File.write(Buf);
-		}
+		a0re += pC0[i]*pIn[i].re;
+		a0im += pC0[i]*pIn[i].im;
+		a1re += pC1[i]*pIn[i].re;
+		a1im += pC1[i]*pIn[i].im;
+	}
+	acc.re = a0re + mu*(a1re - a0re);
+	acc.im = a0im + mu*(a1im - a0im);
+	return acc;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Calculates one real output sample at the current output time
+// Real input samples are stored contiguously in m_pInputBuf as TYPEREAL's
+//////////////////////////////////////////////////////////////////////
+inline TYPEREAL CFractResampler::ConvolveReal(int IntegerTime)
+{
+TYPEREAL mu;
+	const TYPEREAL* pC0 = GetPhaseCoef(IntegerTime, mu);
+	const TYPEREAL* pC1 = pC0 + SINC_PERIODS;
+	const TYPEREAL* pIn = &((TYPEREAL*)m_pInputBuf)[IntegerTime+1];
+	TYPEREAL a0 = 0.0;
+	TYPEREAL a1 = 0.0;
+	for(int i=0; i<SINC_PERIODS; i++)
+	{
+		a0 += pC0[i]*pIn[i];
+		a1 += pC1[i]*pIn[i];
 	}
-	else
-		qDebug()<<"file Failed to Open";
+	return a0 + mu*(a1 - a0);
+}
 
-#endif
+//////////////////////////////////////////////////////////////////////
+// Steps over InLength input samples of silence using
+// Rate = input rate / output rate and returns the number of output
+// samples Resample() would have made.  The input history is cleared so
+// the next Resample() starts from silence.
+//////////////////////////////////////////////////////////////////////
+int CFractResampler::Skip( int InLength, TYPEREAL Rate)
+{
+int outsamples = 0;
+	while( (int)m_FloatTime < InLength )
+	{
+		m_FloatTime += Rate;
+		outsamples++;
+	}
+	m_FloatTime -= (double)InLength;
+	for(int i=0; i<SINC_PERIODS; i++)
+	{
+		m_pInputBuf[i].re = 0.0;
+		m_pInputBuf[i].im = 0.0;
+	}
+	return outsamples;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -148,7 +231,6 @@ int j;
 int IntegerTime = (int)m_FloatTime;	//integer input time accumulator
 double dt = Rate;	//output delta time as function of input sample time (input rate/output rate)
 int outsamples = 0;
-TYPECPX acc;
 
 	//copy input samples into buffer starting at position SINC_PERIODS
 	j = SINC_PERIODS;
@@ -161,15 +243,7 @@ TYPECPX acc;
 	while(IntegerTime < InLength )
 	{	//convolve sinc function with input samples where sinc
 		//function is centered at the output fractional time position
-		acc.re = 0.0; acc.im = 0.0;
-		for(i=1; i<=SINC_PERIODS; i++)
-		{
-			j = IntegerTime + i;	//temp integer time position for convolution loop
-			int sindx =  (int)(( (double)j - m_FloatTime) * (double)SINC_PERIOD_PTS );
-			acc.re += (m_pInputBuf[j].re * m_pSinc[sindx] );
-			acc.im += (m_pInputBuf[j].im * m_pSinc[sindx] );
-		}
-		pOutBuf[outsamples++] = acc;
+		pOutBuf[outsamples++] = ConvolveCpx(IntegerTime);
 		m_FloatTime += dt;		//inc floating pt output time step
 		IntegerTime = (int)m_FloatTime;	//truncate to integer
 	}
@@ -213,14 +287,7 @@ TYPECPX acc;
 	while(IntegerTime < InLength )
 	{	//convolve sinc function with input samples where sinc
 		//function is centered at the output fractional time position
-		acc.re = 0.0; acc.im = 0.0;
-		for(i=1; i<=SINC_PERIODS; i++)
-		{
-			j = IntegerTime + i;	//temp integer time position for convolution loop
-			int sindx =  (int)(( (double)j - m_FloatTime) * (double)SINC_PERIOD_PTS );
-			acc.re += (m_pInputBuf[j].re * m_pSinc[sindx] );
-			acc.im += (m_pInputBuf[j].im * m_pSinc[sindx] );
-		}
+		acc = ConvolveCpx(IntegerTime);
 		TYPECPX tmp;
 		tmp.re = (acc.re * gain);;
 		tmp.im = (acc.im * gain);;
@@ -262,12 +329,12 @@ int j;
 int IntegerTime = (int)m_FloatTime;	//integer input time accumulator
 double dt = Rate;	//output delta time as function of input sample time (input rate/output rate)
 int outsamples = 0;
-TYPEREAL acc;
+TYPEREAL* pRealBuf = (TYPEREAL*)m_pInputBuf;	//real samples are packed contiguously
 
 	//copy input samples into buffer starting at position SINC_PERIODS
 	j = SINC_PERIODS;
 	for(i=0; i<InLength; i++)
-		m_pInputBuf[j++].re = pInBuf[i];
+		pRealBuf[j++] = pInBuf[i];
 	//now calculate output samples by looping until end of input buffer
 	// is reached.  The output position is incremented in fractional time
 	// of input sample time until all the possible input samples are
@@ -275,14 +342,7 @@ TYPEREAL acc;
 	while(IntegerTime < InLength )
 	{	//convolve sinc function with input samples where sinc
 		//function is centered at the output fractional time position
-		acc = 0.0;
-		for(i=1; i<=SINC_PERIODS; i++)
-		{
-			j = IntegerTime + i;	//temp integer time position for convolution loop
-			int sindx =  (int)(( (double)j - m_FloatTime) * (double)SINC_PERIOD_PTS );
-			acc += (m_pInputBuf[j].re * m_pSinc[sindx] );
-		}
-		pOutBuf[outsamples++] = acc;
+		pOutBuf[outsamples++] = ConvolveReal(IntegerTime);
 		m_FloatTime += dt;
 		IntegerTime = (int)m_FloatTime;
 	}
@@ -292,7 +352,7 @@ TYPEREAL acc;
 	// for FIR wrap around management. j points to last input sample processed
 	j = InLength;
 	for(i=0; i<SINC_PERIODS; i++)
-		m_pInputBuf[i].re = m_pInputBuf[j++].re;
+		pRealBuf[i] = pRealBuf[j++];
 	return outsamples;
 }
 
@@ -311,11 +371,12 @@ int IntegerTime = (int)m_FloatTime;	//integer input time accumulator
 double dt = Rate;	//output delta time as function of input sample time (input rate/output rate)
 int outsamples = 0;
 TYPEREAL acc;
+TYPEREAL* pRealBuf = (TYPEREAL*)m_pInputBuf;	//real samples are packed contiguously
 
 	//copy input samples into buffer starting at position SINC_PERIODS
 	j = SINC_PERIODS;
 	for(i=0; i<InLength; i++)
-		m_pInputBuf[j++].re = pInBuf[i];
+		pRealBuf[j++] = pInBuf[i];
 	//now calculate output samples by looping until end of input buffer
 	// is reached.  The output position is incremented in fractional time
 	// of input sample time until all the possible input samples are
@@ -323,13 +384,7 @@ TYPEREAL acc;
 	while(IntegerTime < InLength )
 	{	//convolve sinc function with input samples where sinc
 		//function is centered at the output fractional time position
-		acc = 0.0;
-		for(i=1; i<=SINC_PERIODS; i++)
-		{
-			j = IntegerTime + i;	//temp integer time position for convolution loop
-			int sindx =  (int)(( (double)j - m_FloatTime) * (double)SINC_PERIOD_PTS );
-			acc += (m_pInputBuf[j].re * m_pSinc[sindx] );
-		}
+		acc = ConvolveReal(IntegerTime);
 		TYPEREAL tmp;
 		tmp = (acc * gain);;
 		if(tmp > MAX_SOUNDCARDVAL)
@@ -347,6 +402,6 @@ TYPEREAL acc;
 	// for FIR wrap around management. j points to last input sample processed
 	j = InLength;
 	for(i=0; i<SINC_PERIODS; i++)
-		m_pInputBuf[i].re = m_pInputBuf[j++].re;
+		pRealBuf[i] = pRealBuf[j++];
 	return outsamples;
 }
@@ -25,10 +25,14 @@ public:
 	int Resample( int InLength, TYPEREAL Rate, TYPECPX* pInBuf, TYPECPX* pOutBuf);
 	int Resample( int InLength, TYPEREAL Rate, TYPEREAL* pInBuf, TYPEMONO16* pOutBuf, TYPEREAL gain);
 	int Resample( int InLength, TYPEREAL Rate, TYPECPX* pInBuf, TYPESTEREO16* pOutBuf, TYPEREAL gain);
+	int Skip( int InLength, TYPEREAL Rate);	//silent input
 
 private:
+	inline TYPEREAL* GetPhaseCoef(int IntegerTime, TYPEREAL& mu);
+	inline TYPECPX ConvolveCpx(int IntegerTime);
+	inline TYPEREAL ConvolveReal(int IntegerTime);
 	TYPEREAL m_FloatTime;	//floating pt output time accumulator
-	TYPEREAL* m_pSinc;	//ptr to sinc table
+	TYPEREAL* m_pCoef;	//ptr to polyphase sinc table
 	TYPECPX* m_pInputBuf;	//internal working input sample buffer
 };
 
@@ -18,6 +18,9 @@ typedef struct _snproc
 	bool NBOn;
 	int NBThreshold;
 	int NBWidth;
+	bool NROn;		//spectral noise reduction in the demod filter
+	int NRLevel;
+	bool NotchOn;	//automatic carrier notch in the demod filter
 }tNoiseProcdInfo;
 
 class CNoiseProc
@@ -28,6 +31,7 @@ public:
 
 	void SetupBlanker( bool On, TYPEREAL Threshold, TYPEREAL Width, TYPEREAL SampleRate);
 	void ProcessBlanker(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
+	bool IsBlankerOn(){return m_On;}
 
 private:
 	bool m_On;
@@ -0,0 +1,285 @@
+//////////////////////////////////////////////////////////////////////
+// rationalresampler.cpp: implementation of the CRationalResampler class.
+//
+//  This class implements a L/M polyphase resampler that converts I/Q
+//or real data to an arbitrary output rate such as 48000 or 12000Hz.
+// The lowpass filter is designed at L times the input rate and split
+// into L polyphase branches. Only the branch needed for each output
+// sample is calculated so no zero stuffed samples or discarded outputs
+// are ever computed.
+//
+// History:
+//	2026-10-19  Initial creation
+//////////////////////////////////////////////////////////////////////
+
+//==========================================================================================
+// + + +   This Software is released under the "Simplified BSD License"  + + +
+//Copyright 2010 Moe Wheatley. All rights reserved.
+//
+//Redistribution and use in source and binary forms, with or without modification, are
+//permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice, this list of
+//	  conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright notice, this list
+//	  of conditions and the following disclaimer in the documentation and/or other materials
+//	  provided with the distribution.
+//
+//THIS SOFTWARE IS PROVIDED BY Moe Wheatley ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Moe Wheatley OR
+//CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//The views and conclusions contained in the software and documentation are those of the
+//authors and should not be interpreted as representing official policies, either expressed
+//or implied, of Moe Wheatley.
+//==========================================================================================
+#include "dsp/rationalresampler.h"
+#include "dsp/fir.h"
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////
+// Local defines
+//////////////////////////////////////////////////////////////////////
+#define RRS_MAX_BLOCK 4096	//max input samples processed per pass
+#define RRS_MAX_PASSBAND 0.45	//max passband as fraction of the lower rate
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+CRationalResampler::CRationalResampler()
+{
+	m_L = 1;
+	m_M = 1;
+	m_NumTaps = 1;
+	m_Phase = 0;
+	m_InPos = 0;
+	m_InRate = 1.0;
+	m_OutRate = 1.0;
+	m_pCoef = NULL;
+	m_pCpxBuf = new TYPECPX[RRS_MAX_BLOCK + RRS_MAX_PHASE_TAPS];
+	m_pRealBuf = new TYPEREAL[RRS_MAX_BLOCK + RRS_MAX_PHASE_TAPS];
+}
+
+CRationalResampler::~CRationalResampler()
+{
+	if(m_pCoef)
+		delete[] m_pCoef;
+	if(m_pCpxBuf)
+		delete[] m_pCpxBuf;
+	if(m_pRealBuf)
+		delete[] m_pRealBuf;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Sets up the resampler to convert from InRate to OutRate.
+// Passband is the one sided bandwidth in Hz that must be kept alias free.
+// The stopband starts where aliases would fold back into the passband
+// Astop is the stopband attenuation in dB.
+// returns the actual output rate.
+//////////////////////////////////////////////////////////////////////
+TYPEREAL CRationalResampler::Init(TYPEREAL InRate, TYPEREAL OutRate, TYPEREAL Passband, TYPEREAL Astop)
+{
+	m_InRate = InRate;
+	FindRatio(OutRate/InRate);
+	m_OutRate = m_InRate*(TYPEREAL)m_L/(TYPEREAL)m_M;
+	TYPEREAL MinRate = (m_OutRate < m_InRate) ? m_OutRate : m_InRate;
+	if(Passband > RRS_MAX_PASSBAND*MinRate)
+		Passband = RRS_MAX_PASSBAND*MinRate;
+	DesignFilter(Passband, MinRate - Passband, Astop);
+
+	m_Phase = 0;
+	m_InPos = 0;
+	for(int i=0; i<RRS_MAX_BLOCK + RRS_MAX_PHASE_TAPS; i++)
+	{
+		m_pCpxBuf[i].re = 0.0;
+		m_pCpxBuf[i].im = 0.0;
+		m_pRealBuf[i] = 0.0;
+	}
+	return m_OutRate;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Finds L/M closest to Ratio with L <= RRS_MAX_PHASES using continued
+// fractions. Integer rates like 62500 to 48000(96/125) are exact.
+//////////////////////////////////////////////////////////////////////
+void CRationalResampler::FindRatio(TYPEREAL Ratio)
+{
+	//convergents h/k of the continued fraction
+	double h0 = 0.0;
+	double h1 = 1.0;
+	double k0 = 1.0;
+	double k1 = 0.0;
+	double x = Ratio;
+	m_L = 1;
+	m_M = (int)(1.0/Ratio + 0.5);
+	if(m_M < 1)
+		m_M = 1;
+	for(int i=0; i<32; i++)
+	{
+		double a = floor(x);
+		double h2 = a*h1 + h0;
+		double k2 = a*k1 + k0;
+		if(h2 > RRS_MAX_PHASES)
+			break;
+		if(h2 >= 1.0)
+		{
+			m_L = (int)h2;
+			m_M = (int)k2;
+		}
+		h0 = h1; h1 = h2;
+		k0 = k1; k1 = k2;
+		if( fabs(h2/k2 - Ratio) <= 1e-12*Ratio )
+			break;
+		x = 1.0/(x - a);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Designs the Kaiser windowed lowpass filter at L times the input rate
+// and stores it as m_L polyphase branches with time reversed taps so
+// each output sample is one contiguous dot product.
+//////////////////////////////////////////////////////////////////////
+void CRationalResampler::DesignFilter(TYPEREAL Fpass, TYPEREAL Fstop, TYPEREAL Astop)
+{
+TYPEREAL Beta;
+	TYPEREAL FilterRate = m_InRate*(TYPEREAL)m_L;
+	TYPEREAL normFpass = Fpass/FilterRate;
+	TYPEREAL normFstop = Fstop/FilterRate;
+	TYPEREAL normFcut = (normFstop + normFpass)/2.0;	//low pass filter 6dB cutoff
+
+	//calculate Kaiser-Bessel window shape factor, Beta, from stopband attenuation
+	if(Astop < 20.96)
+		Beta = 0;
+	else if(Astop >= 50.0)
+		Beta = .1102 * (Astop - 8.71);
+	else
+		Beta = .5842 * pow( (Astop-20.96), 0.4) + .07886 * (Astop - 20.96);
+
+	//Estimate number of filter taps required and round up to whole branches
+	int TotalTaps = (int)((Astop - 8.0) / (2.285*K_2PI*(normFstop - normFpass) ) + 1);
+	m_NumTaps = TotalTaps/m_L + 1;
+	if(m_NumTaps > RRS_MAX_PHASE_TAPS)
+		m_NumTaps = RRS_MAX_PHASE_TAPS;
+	TotalTaps = m_NumTaps*m_L;
+
+	if(m_pCoef)
+		delete[] m_pCoef;
+	m_pCoef = new TYPEREAL[TotalTaps];
+	TYPEREAL fCenter = .5*(TYPEREAL)(TotalTaps-1);
+	TYPEREAL izb = CFir::Izero(Beta);
+	for(int n=0; n<TotalTaps; n++)
+	{
+		TYPEREAL x = (TYPEREAL)n - fCenter;
+		TYPEREAL c;
+		if( (TYPEREAL)n == fCenter )
+			c = 2.0 * normFcut;
+		else
+			c = (TYPEREAL)sin(K_2PI*x*normFcut)/(K_PI*x);
+		x = x/fCenter;
+		c *= (TYPEREAL)m_L * CFir::Izero( Beta * sqrt(1 - (x*x) ) ) / izb;
+		//tap n is branch n%L, delay n/L. Store delays reversed.
+		int Phase = n % m_L;
+		int Delay = n / m_L;
+		m_pCoef[Phase*m_NumTaps + (m_NumTaps-1-Delay)] = c;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Resample InLength samples in pInData and place into pOutData
+//   !!!! Make sure pOutData from caller is large enough to hold
+// InLength*L/M + 1 samples  !!!!!
+// COMPLEX version
+//////////////////////////////////////////////////////////////////////
+int CRationalResampler::ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
+{
+	int n = 0;
+	for(int i=0; i<InLength; i += RRS_MAX_BLOCK)
+	{
+		int len = InLength - i;
+		if(len > RRS_MAX_BLOCK)
+			len = RRS_MAX_BLOCK;
+		n += ProcessBlock(len, &pInData[i], &pOutData[n]);
+	}
+	return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// REAL version
+//////////////////////////////////////////////////////////////////////
+int CRationalResampler::ProcessData(int InLength, TYPEREAL* pInData, TYPEREAL* pOutData)
+{
+	int n = 0;
+	for(int i=0; i<InLength; i += RRS_MAX_BLOCK)
+	{
+		int len = InLength - i;
+		if(len > RRS_MAX_BLOCK)
+			len = RRS_MAX_BLOCK;
+		n += ProcessBlock(len, &pInData[i], &pOutData[n]);
+	}
+	return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Processes up to RRS_MAX_BLOCK complex input samples
+//////////////////////////////////////////////////////////////////////
+int CRationalResampler::ProcessBlock(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
+{
+	int n = 0;
+	memcpy(&m_pCpxBuf[m_NumTaps-1], pInData, InLength*sizeof(TYPECPX));
+	while(m_InPos < InLength)
+	{
+		const TYPEREAL* pC = &m_pCoef[m_Phase*m_NumTaps];
+		const TYPECPX* pX = &m_pCpxBuf[m_InPos];
+		TYPEREAL accre = 0.0;
+		TYPEREAL accim = 0.0;
+		for(int k=0; k<m_NumTaps; k++)
+		{
+			accre += pC[k]*pX[k].re;
+			accim += pC[k]*pX[k].im;
+		}
+		pOutData[n].re = accre;
+		pOutData[n].im = accim;
+		n++;
+		//step to next output time on the L times input rate grid
+		m_Phase += m_M;
+		m_InPos += m_Phase/m_L;
+		m_Phase %= m_L;
+	}
+	m_InPos -= InLength;
+	//move filter history to start of buffer
+	memmove(m_pCpxBuf, &m_pCpxBuf[InLength], (m_NumTaps-1)*sizeof(TYPECPX));
+	return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Processes up to RRS_MAX_BLOCK real input samples
+//////////////////////////////////////////////////////////////////////
+int CRationalResampler::ProcessBlock(int InLength, TYPEREAL* pInData, TYPEREAL* pOutData)
+{
+	int n = 0;
+	memcpy(&m_pRealBuf[m_NumTaps-1], pInData, InLength*sizeof(TYPEREAL));
+	while(m_InPos < InLength)
+	{
+		const TYPEREAL* pC = &m_pCoef[m_Phase*m_NumTaps];
+		const TYPEREAL* pX = &m_pRealBuf[m_InPos];
+		TYPEREAL acc = 0.0;
+		for(int k=0; k<m_NumTaps; k++)
+			acc += pC[k]*pX[k];
+		pOutData[n++] = acc;
+		//step to next output time on the L times input rate grid
+		m_Phase += m_M;
+		m_InPos += m_Phase/m_L;
+		m_Phase %= m_L;
+	}
+	m_InPos -= InLength;
+	//move filter history to start of buffer
+	memmove(m_pRealBuf, &m_pRealBuf[InLength], (m_NumTaps-1)*sizeof(TYPEREAL));
+	return n;
+}
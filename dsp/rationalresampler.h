@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////
+// rationalresampler.h: interface for the CRationalResampler class.
+//
+//  This class implements a L/M polyphase resampler that converts I/Q
+//or real data to an arbitrary output rate.
+//
+// History:
+//	2026-10-19  Initial creation
+//////////////////////////////////////////////////////////////////////
+#ifndef RATIONALRESAMPLER_H
+#define RATIONALRESAMPLER_H
+
+#include "dsp/datatypes.h"
+
+#define RRS_MAX_PHASES 512		//max interpolation factor L
+#define RRS_MAX_PHASE_TAPS 512	//max filter taps per polyphase branch
+
+class CRationalResampler
+{
+public:
+	CRationalResampler();
+	virtual ~CRationalResampler();
+
+	//returns actual output rate which can differ slightly from OutRate
+	//if the rate ratio can not be represented with L <= RRS_MAX_PHASES
+	TYPEREAL Init(TYPEREAL InRate, TYPEREAL OutRate, TYPEREAL Passband, TYPEREAL Astop);
+	int GetInterpolation(){return m_L;}
+	int GetDecimation(){return m_M;}
+	int GetNumTaps(){return m_NumTaps;}
+	//overloaded functions for processing different data types
+	int ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
+	int ProcessData(int InLength, TYPEREAL* pInData, TYPEREAL* pOutData);
+
+private:
+	void FindRatio(TYPEREAL Ratio);
+	void DesignFilter(TYPEREAL Fpass, TYPEREAL Fstop, TYPEREAL Astop);
+	int ProcessBlock(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
+	int ProcessBlock(int InLength, TYPEREAL* pInData, TYPEREAL* pOutData);
+	int m_L;			//interpolation factor(number of phases)
+	int m_M;			//decimation factor
+	int m_NumTaps;		//taps per polyphase branch
+	int m_Phase;		//phase of next output sample
+	int m_InPos;		//input position of next output sample
+	TYPEREAL m_InRate;
+	TYPEREAL m_OutRate;
+	TYPEREAL* m_pCoef;	//m_L branches of m_NumTaps time reversed coefficients
+	TYPECPX* m_pCpxBuf;	//filter history followed by new input samples
+	TYPEREAL* m_pRealBuf;
+};
+
+#endif // RATIONALRESAMPLER_H
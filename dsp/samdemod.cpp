@@ -47,6 +47,7 @@
 #define PLL_BW 100.0		//natural frequency ~ loop bandwidth
 #define PLL_ZETA .707		//PLL Loop damping factor
 #define PLL_LIMIT 1000.0	//+- frequency limit in Hz
+#define PLL_MIN_LEVEL 1e-6	//minimum carrier level used for phase detector gain
 
 /////////////////////////////////////////////////////////////////////////////////
 //	Construct SAM demod object
@@ -56,8 +57,10 @@ CSamDemod::CSamDemod(TYPEREAL samplerate) : m_SampleRate(samplerate)
 	m_y1 = 0.0;
 	m_z1 = 0.0;
 
-	m_NcoPhase = 0.0;
+	m_Nco.re = 1.0;		//initialize unit vector that will get rotated
+	m_Nco.im = 0.0;
 	m_NcoFreq = 0.0;
+	m_PllGain = 1.0;
 	TYPEREAL norm = K_2PI/m_SampleRate;
 	m_NcoLLimit = -PLL_LIMIT * norm;		//clamp SAM NCO to +-1KHz
 	m_NcoHLimit = PLL_LIMIT * norm;
@@ -73,39 +76,83 @@ CSamDemod::CSamDemod(TYPEREAL samplerate) : m_SampleRate(samplerate)
 }
 
 /////////////////////////////////////////////////////////////////////////////////
-//	Process SAM demod MONO version
+//	Sets the phase detector gain from the average input magnitude of the block.
+// For AM the average magnitude is the carrier level so Im/level is
+// sin(phase error), which avoids an atan2() in the serial PLL loop.
 /////////////////////////////////////////////////////////////////////////////////
-int CSamDemod::ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData)
+void CSamDemod::CalcPllGain(int InLength, TYPECPX* pInData)
 {
-TYPECPX tmp;
+	if(InLength <= 0)
+		return;
+	TYPEREAL sum = 0.0;
 	for(int i=0; i<InLength; i++)
-	{
-		TYPEREAL Sin = -sin(m_NcoPhase);
-		TYPEREAL Cos = cos(m_NcoPhase);
-		//complex multiply input sample by NCO's  -sin and cos
-		tmp.re = Cos * pInData[i].re - Sin * pInData[i].im;
-		tmp.im = Cos * pInData[i].im + Sin * pInData[i].re;
-		//find current sample phase after being shifted by NCO frequency
-		TYPEREAL phzerror = atan2(tmp.im, tmp.re);
+		sum += sqrt(pInData[i].re*pInData[i].re + pInData[i].im*pInData[i].im);
+	sum /= (TYPEREAL)InLength;
+	if(sum < PLL_MIN_LEVEL)
+		sum = PLL_MIN_LEVEL;
+	m_PllGain = 1.0/sum;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+//	Mixes one sample to baseband with the PLL NCO and advances the PLL.
+// The NCO is a unit phasor rotated each sample by the loop phase step
+// using a short sin/cos series(the step is limited to abt +-0.5 radians
+// so the series error is small and is inside the loop anyway).
+// Its amplitude is renormalized each sample like the CDownConvert NCO.
+/////////////////////////////////////////////////////////////////////////////////
+inline TYPECPX CSamDemod::PllMix(TYPECPX x)
+{
+TYPECPX tmp;
+	//complex multiply input sample by NCO phasor
+	tmp.re = m_Nco.re * x.re - m_Nco.im * x.im;
+	tmp.im = m_Nco.re * x.im + m_Nco.im * x.re;
+	//find current sample phase error after being shifted by NCO frequency
+	TYPEREAL phzerror = tmp.im * m_PllGain;
+	if(phzerror > 1.0)
+		phzerror = 1.0;
+	else if(phzerror < -1.0)
+		phzerror = -1.0;
+
+	m_NcoFreq += (m_PllBeta * phzerror);		//  radians per sampletime
+	//clamp NCO frequency so doesn't drift out of lock range
+	if(m_NcoFreq > m_NcoHLimit)
+		m_NcoFreq = m_NcoHLimit;
+	else if(m_NcoFreq < m_NcoLLimit)
+		m_NcoFreq = m_NcoLLimit;
+	//rotate NCO phasor by the new phase step
+	TYPEREAL d = m_NcoFreq + m_PllAlpha * phzerror;
+	TYPEREAL d2 = d*d;
+	TYPEREAL Cos = 1.0 - d2*(1.0/2.0);
+	TYPEREAL Sin = d*(1.0 - d2*(1.0/6.0));
+	TYPECPX Osc;
+	Osc.re = m_Nco.re * Cos + m_Nco.im * Sin;
+	Osc.im = m_Nco.im * Cos - m_Nco.re * Sin;
+	TYPEREAL OscGn = 1.5 - 0.5*(Osc.re*Osc.re + Osc.im*Osc.im);
+	m_Nco.re = OscGn * Osc.re;
+	m_Nco.im = OscGn * Osc.im;
+	return tmp;
+}
 
-//TYPEREAL test = phzerror*100.0;
-//g_pTestBench->DisplayData(1, &test, m_SampleRate,PROFILE_6);
+/////////////////////////////////////////////////////////////////////////////////
+//	Process SAM demod MONO version
+/////////////////////////////////////////////////////////////////////////////////
+int CSamDemod::ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData)
+{
+int i;
+	CalcPllGain(InLength, pInData);
+	for(i=0; i<InLength; i++)
+		pOutData[i] = PllMix(pInData[i]).re;	//just use real output for mono
 
-		m_NcoFreq += (m_PllBeta * phzerror);		//  radians per sampletime
-		//clamp NCO frequency so doesn't drift out of lock range
-		if(m_NcoFreq > m_NcoHLimit)
-			m_NcoFreq = m_NcoHLimit;
-		else if(m_NcoFreq < m_NcoLLimit)
-			m_NcoFreq = m_NcoLLimit;
-		//update NCO phase with new value
-		m_NcoPhase += (m_NcoFreq + m_PllAlpha * phzerror);
-		//High pass filter(DC removal) with IIR filter
-		// H(z) = (1 - z^-1)/(1 - ALPHA*z^-1)
-		TYPEREAL z0 = tmp.re + (m_z1 * DC_ALPHA);	//just use real output for mono
-		pOutData[i] = (z0 - m_z1);
-		m_z1 = z0;
+	//High pass filter(DC removal) with IIR filter
+	// H(z) = (1 - z^-1)/(1 - ALPHA*z^-1)
+	TYPEREAL z1 = m_z1;
+	for(i=0; i<InLength; i++)
+	{
+		TYPEREAL z0 = pOutData[i] + (z1 * DC_ALPHA);
+		pOutData[i] = (z0 - z1);
+		z1 = z0;
 	}
-	m_NcoPhase = fmod(m_NcoPhase, K_2PI);	//keep radian counter bounded
+	m_z1 = z1;
 	return InLength;
 }
 
@@ -114,43 +161,32 @@ TYPECPX tmp;
 /////////////////////////////////////////////////////////////////////////////////
 int CSamDemod::ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
 {
-TYPECPX tmp;
-	for(int i=0; i<InLength; i++)
-	{
-		TYPEREAL Sin = sin(m_NcoPhase);
-		TYPEREAL Cos = cos(m_NcoPhase);
-		//complex multiply input sample by NCO's  sin and cos
-		tmp.re = Cos * pInData[i].re - Sin * pInData[i].im;
-		tmp.im = Cos * pInData[i].im + Sin * pInData[i].re;
-		//find current sample phase error after being shifted by NCO frequency
-		TYPEREAL phzerror = -atan2(tmp.im, tmp.re);
+int i;
+	CalcPllGain(InLength, pInData);
+	for(i=0; i<InLength; i++)
+		pOutData[i] = PllMix(pInData[i]);
 
-//TYPEREAL test = phzerror*100.0;
-//g_pTestBench->DisplayData(1, &test, m_SampleRate,PROFILE_6);
-
-		m_NcoFreq += (m_PllBeta * phzerror);		//  radians per sampletime
-		//clamp NCO frequency so doesn't drift out of lock range
-		if(m_NcoFreq > m_NcoHLimit)
-			m_NcoFreq = m_NcoHLimit;
-		else if(m_NcoFreq < m_NcoLLimit)
-			m_NcoFreq = m_NcoLLimit;
-		//update NCO phase with new value
-		m_NcoPhase += (m_NcoFreq + m_PllAlpha * phzerror);
-		//High pass filter(DC removal) with IIR filter
-		// H(z) = (1 - z^-1)/(1 - ALPHA*z^-1)
-		TYPEREAL z0 = tmp.re + (m_z1 * DC_ALPHA);
-		TYPEREAL y0 = tmp.im + (m_y1 * DC_ALPHA);
-		pOutData[i].re = (z0 - m_z1);
-		pOutData[i].im = (y0 - m_y1);
-		m_y1 = y0;
-		m_z1 = z0;
+	//High pass filter(DC removal) with IIR filter
+	// H(z) = (1 - z^-1)/(1 - ALPHA*z^-1)
+	//each output depends on the last so this loop stays serial
+	TYPEREAL z1 = m_z1;
+	TYPEREAL y1 = m_y1;
+	for(i=0; i<InLength; i++)
+	{
+		TYPEREAL z0 = pOutData[i].re + (z1 * DC_ALPHA);
+		TYPEREAL y0 = pOutData[i].im + (y1 * DC_ALPHA);
+		pOutData[i].re = (z0 - z1);
+		pOutData[i].im = (y0 - y1);
+		y1 = y0;
+		z1 = z0;
 	}
-	m_NcoPhase = fmod(m_NcoPhase, K_2PI);	//keep radian counter bounded
+	m_y1 = y1;
+	m_z1 = z1;
 	//process I/Q with bandpass filter with 90deg phase shift between the I and Q filters
 	m_Fir.ProcessFilter(InLength, pOutData, pOutData);
-	for(int i=0; i<InLength; i++)
+	for(i=0; i<InLength; i++)
 	{
-		tmp = pOutData[i];
+		TYPECPX tmp = pOutData[i];
 		pOutData[i].im = tmp.re - tmp.im;	//send upper sideband to (right)channel
 		pOutData[i].re = tmp.re + tmp.im;	//send lower sideband to (left)channel
 	}
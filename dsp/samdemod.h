@@ -18,16 +18,19 @@ public:
 	int ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData);
 	int ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
 private:
+	inline TYPECPX PllMix(TYPECPX x);
+	void CalcPllGain(int InLength, TYPECPX* pInData);
 	TYPEREAL m_SampleRate;
 	TYPEREAL m_z1;
 	TYPEREAL m_y1;
-	TYPEREAL m_NcoPhase;
 	TYPEREAL m_NcoFreq;
 	TYPEREAL m_NcoAcc;
 	TYPEREAL m_NcoLLimit;
 	TYPEREAL m_NcoHLimit;
 	TYPEREAL m_PllAlpha;
 	TYPEREAL m_PllBeta;
+	TYPEREAL m_PllGain;	//phase detector gain from block carrier level
+	TYPECPX m_Nco;		//rotating NCO phasor
 	CFir m_Fir;
 };
 
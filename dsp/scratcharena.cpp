@@ -0,0 +1,133 @@
+/////////////////////////////////////////////////////////////////////
+// scratcharena.cpp: implementation of the CScratchArena class.
+//
+//	This class replaces the large stack arrays and fixed size heap
+// buffers that the DSP routines used for temporary data.  The owner
+// calls Reserve() with the worst case number of bytes whenever the
+// pipeline configuration changes and Reset() at the start of each data
+// block. The memory is only reallocated inside Reset() so a
+// configuration change from the GUI thread can not free a buffer the
+// DSP thread is using.
+//	If a request does not fit, a heap buffer is used for that block and
+// the arena grows at the next Reset() so the audio is never dropped.
+//
+// History:
+//	2026-10-19  Initial creation
+/////////////////////////////////////////////////////////////////////
+
+//==========================================================================================
+// + + +   This Software is released under the "Simplified BSD License"  + + +
+//Copyright 2010 Moe Wheatley. All rights reserved.
+//
+//Redistribution and use in source and binary forms, with or without modification, are
+//permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice, this list of
+//	  conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright notice, this list
+//	  of conditions and the following disclaimer in the documentation and/or other materials
+//	  provided with the distribution.
+//
+//THIS SOFTWARE IS PROVIDED BY Moe Wheatley ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Moe Wheatley OR
+//CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//The views and conclusions contained in the software and documentation are those of the
+//authors and should not be interpreted as representing official policies, either expressed
+//or implied, of Moe Wheatley.
+//==========================================================================================
+#include "dsp/scratcharena.h"
+
+/////////////////////////////////////////////////////////////////////
+//   constructor/destructor
+/////////////////////////////////////////////////////////////////////
+CScratchArena::CScratchArena()
+{
+	m_Required = 0;
+	m_LastRequired = 0;
+	m_HighWater = 0;
+	m_Size = 0;
+	m_Used = 0;
+	m_pMem = NULL;
+	m_pBase = NULL;
+}
+
+CScratchArena::~CScratchArena()
+{
+	FreeOverflow();
+	if(m_pMem)
+		delete[] m_pMem;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Sets the number of bytes needed to process one data block.
+// Takes effect at the next Reset().
+/////////////////////////////////////////////////////////////////////
+void CScratchArena::Reserve(int bytes)
+{
+	m_Required = AlignedSize(bytes);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Gives back all buffers and resizes the arena if needed.
+// A new Reserve() size drops the high water mark of the old setup.
+/////////////////////////////////////////////////////////////////////
+void CScratchArena::Reset()
+{
+	m_Used = 0;
+	FreeOverflow();
+	int required = m_Required;
+	if(required != m_LastRequired)
+	{
+		m_LastRequired = required;
+		m_HighWater = 0;
+	}
+	int size = qMax(required, m_HighWater);
+	if(size == m_Size)
+		return;
+	if(m_pMem)
+		delete[] m_pMem;
+	m_pMem = new char[size + SCRATCH_ALIGN];
+	int offset = (int)( (quintptr)m_pMem & (SCRATCH_ALIGN-1) );
+	m_pBase = offset ? (m_pMem + SCRATCH_ALIGN - offset) : m_pMem;
+	m_Size = size;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Returns an aligned buffer of 'bytes' that is valid until Release()
+// of an earlier mark or the next Reset().
+/////////////////////////////////////////////////////////////////////
+void* CScratchArena::AllocBytes(int bytes)
+{
+	bytes = AlignedSize(bytes);
+	if( (m_Used + bytes) <= m_Size )
+	{
+		void* p = m_pBase + m_Used;
+		m_Used += bytes;
+		return p;
+	}
+	//does not fit so use the heap for this block and grow next Reset()
+	if( (m_Used + bytes) > m_HighWater )
+		m_HighWater = m_Used + bytes;
+	char* p = new char[bytes + SCRATCH_ALIGN];
+	m_Overflow.append(p);
+	int offset = (int)( (quintptr)p & (SCRATCH_ALIGN-1) );
+	return offset ? (p + SCRATCH_ALIGN - offset) : p;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Frees any heap buffers handed out because the arena was too small
+/////////////////////////////////////////////////////////////////////
+void CScratchArena::FreeOverflow()
+{
+	for(int i=0; i<m_Overflow.size(); i++)
+		delete[] m_Overflow[i];
+	m_Overflow.clear();
+}
@@ -0,0 +1,50 @@
+//////////////////////////////////////////////////////////////////////
+// scratcharena.h: interface for the CScratchArena class.
+//
+//  This class provides temporary working buffers for one DSP pipeline.
+//Buffers are taken from one preallocated block by moving a pointer
+//and are all given back at once at the start of each data block.
+//
+// History:
+//	2026-10-19  Initial creation
+//////////////////////////////////////////////////////////////////////
+#ifndef SCRATCHARENA_H
+#define SCRATCHARENA_H
+
+#include <QVector>
+
+#define SCRATCH_ALIGN 16	//byte alignment of every scratch buffer
+
+class CScratchArena
+{
+public:
+	CScratchArena();
+	virtual ~CScratchArena();
+
+	//byte size of a buffer including its alignment padding
+	static int AlignedSize(int bytes){return (bytes + SCRATCH_ALIGN-1) & ~(SCRATCH_ALIGN-1);}
+
+	void Reserve(int bytes);	//can be called from any thread
+	void Reset();				//DSP thread only, at start of each block
+	void* AllocBytes(int bytes);
+	int GetMark(){return m_Used;}
+	void Release(int mark){m_Used = mark;}
+	int GetSize(){return m_Size;}
+
+	//typed buffer of 'n' elements
+	template <class T> T* Alloc(int n){return (T*)AllocBytes(n*(int)sizeof(T));}
+
+private:
+	void FreeOverflow();
+
+	volatile int m_Required;	//size requested by Reserve(), written by any thread
+	int m_LastRequired;		//m_Required seen by the last Reset(), DSP thread only
+	int m_HighWater;		//largest use seen by AllocBytes(), DSP thread only
+	int m_Size;
+	int m_Used;
+	char* m_pMem;			//allocated memory
+	char* m_pBase;			//m_pMem rounded up to SCRATCH_ALIGN
+	QVector<char*> m_Overflow;	//heap buffers used when arena was too small
+};
+
+#endif // SCRATCHARENA_H
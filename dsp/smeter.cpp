@@ -41,6 +41,7 @@
 
 #define  ATTACK_TIMECONST .01	//attack time in seconds
 #define  DECAY_TIMECONST .5		//decay time in seconds
+#define  REAL_TIMECONST .005	//real data power smoothing time in seconds
 
 #define SMETER_CALIBRATION 5.0	//S-Meter calibration offset added to make reading absolute dBm
 
@@ -52,6 +53,8 @@ CSMeter::CSMeter()
 	m_SampleRate = 1.0;
 	m_AttackAlpha = 1.0;
 	m_DecayAlpha = 1.0;
+	m_RealAlpha = 1.0;
+	m_RealPwr = 0.0;
 	m_AttackAve = -120.0;
 	m_DecayAve = -120.0;
 }
@@ -62,34 +65,65 @@ CSMeter::CSMeter()
 void CSMeter::ProcessData(int length, TYPECPX* pInData, TYPEREAL SampleRate)
 {
 	if(SampleRate != m_SampleRate)
-	{	//need to recalculate any values dependent on sample rate
-		m_SampleRate = SampleRate;
-		m_AttackAlpha = (1.0-exp(-1.0/(m_SampleRate*ATTACK_TIMECONST)) );
-		m_DecayAlpha = (1.0-exp(-1.0/(m_SampleRate*DECAY_TIMECONST)) );
-//qDebug()<<"SMeter vals "<<m_AttackAlpha << m_DecayAlpha << SampleRate;
-	}
+		SetSampleRate(SampleRate);
 	for(int i=0; i<length; i++)
 	{
 		//calculate instantaeous power magnitude of pInData which is I*I + Q*Q
 		TYPECPX in = pInData[i];
 		//convert I/Q magnitude to dB power
-		TYPEREAL mag = 10.0*log10((in.re*in.re+in.im*in.im)/ MAX_PWR + 1e-50);
-		//calculate attack and decay average
-		m_AttackAve = (1.0-m_AttackAlpha)*m_AttackAve + m_AttackAlpha*mag;
-		m_DecayAve = (1.0-m_DecayAlpha)*m_DecayAve + m_DecayAlpha*mag;
-		if(m_AttackAve>m_DecayAve)
-		{	//if attack average is greater then must be increasing signal
-			m_AverageMag = m_AttackAve;	//use attack average value
-			m_DecayAve = m_AttackAve;	//force decay average to attack average
-		}
-		else
-		{	//is decreasing strength so use decay average
-			m_AverageMag = m_DecayAve;	//use decay average value
-		}
-		if(mag > m_PeakMag)
-			m_PeakMag = mag;		//save new peak (reset when read )
+		UpdateAverages( 10.0*log10((in.re*in.re+in.im*in.im)/ MAX_PWR + 1e-50) );
+	}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// Real data version used when only the real part of the filtered signal
+// is calculated(SSB and CW).  Twice the real power is the I/Q power on
+// average so it is smoothed over REAL_TIMECONST before converting to dB.
+////////////////////////////////////////////////////////////////////////////////////
+void CSMeter::ProcessData(int length, TYPEREAL* pInData, TYPEREAL SampleRate)
+{
+	if(SampleRate != m_SampleRate)
+		SetSampleRate(SampleRate);
+	for(int i=0; i<length; i++)
+	{
+		TYPEREAL in = pInData[i];
+		m_RealPwr += m_RealAlpha*(2.0*in*in - m_RealPwr);
+		UpdateAverages( 10.0*log10(m_RealPwr/ MAX_PWR + 1e-50) );
 	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// recalculates any values dependent on sample rate
+////////////////////////////////////////////////////////////////////////////////////
+void CSMeter::SetSampleRate(TYPEREAL SampleRate)
+{
+	m_SampleRate = SampleRate;
+	m_AttackAlpha = (1.0-exp(-1.0/(m_SampleRate*ATTACK_TIMECONST)) );
+	m_DecayAlpha = (1.0-exp(-1.0/(m_SampleRate*DECAY_TIMECONST)) );
+	m_RealAlpha = (1.0-exp(-1.0/(m_SampleRate*REAL_TIMECONST)) );
+//qDebug()<<"SMeter vals "<<m_AttackAlpha << m_DecayAlpha << SampleRate;
+}
 
+////////////////////////////////////////////////////////////////////////////////////
+// updates the attack/decay averages and peak with a new dB power value
+////////////////////////////////////////////////////////////////////////////////////
+inline void CSMeter::UpdateAverages(TYPEREAL mag)
+{
+	//calculate attack and decay average
+	m_AttackAve = (1.0-m_AttackAlpha)*m_AttackAve + m_AttackAlpha*mag;
+	m_DecayAve = (1.0-m_DecayAlpha)*m_DecayAve + m_DecayAlpha*mag;
+	if(m_AttackAve>m_DecayAve)
+	{	//if attack average is greater then must be increasing signal
+		m_AverageMag = m_AttackAve;	//use attack average value
+		m_DecayAve = m_AttackAve;	//force decay average to attack average
+	}
+	else
+	{	//is decreasing strength so use decay average
+		m_AverageMag = m_DecayAve;	//use decay average value
+	}
+	if(mag > m_PeakMag)
+		m_PeakMag = mag;		//save new peak (reset when read )
 }
 
 
@@ -14,10 +14,13 @@ class CSMeter
 public:
     CSMeter();
 	void ProcessData(int length, TYPECPX* pInData, TYPEREAL SampleRate);
+	void ProcessData(int length, TYPEREAL* pInData, TYPEREAL SampleRate);
 	TYPEREAL GetPeak();
 	TYPEREAL GetAve();
 
 private:
+	void SetSampleRate(TYPEREAL SampleRate);
+	void UpdateAverages(TYPEREAL mag);
 	TYPEREAL m_AverageMag;
 	TYPEREAL m_PeakMag;
 	TYPEREAL m_SampleRate;
@@ -25,6 +28,8 @@ private:
 	TYPEREAL m_DecayAve;
 	TYPEREAL m_AttackAlpha;
 	TYPEREAL m_DecayAlpha;
+	TYPEREAL m_RealAlpha;
+	TYPEREAL m_RealPwr;		//smoothed power of real input data
 
 };
 
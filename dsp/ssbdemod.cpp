@@ -58,3 +58,14 @@ int CSsbDemod::ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
 		pOutData[i] = pInData[i];
 	return InLength;
 }
+
+//real part of the signal is already all that was filtered
+int CSsbDemod::ProcessData(int InLength, TYPEREAL* pInData, TYPEREAL* pOutData)
+{
+	if(pInData != pOutData)
+	{
+		for(int i=0; i<InLength ; i++)
+			pOutData[i] = pInData[i];
+	}
+	return InLength;
+}
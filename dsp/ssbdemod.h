@@ -15,6 +15,7 @@ public:
 	CSsbDemod();
 	int ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData);
 	int ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
+	int ProcessData(int InLength, TYPEREAL* pInData, TYPEREAL* pOutData);
 private:
 };
 
@@ -0,0 +1,293 @@
+/////////////////////////////////////////////////////////////////////
+// wfmdemod.cpp: implementation of the CWFmDemod class.
+//
+//	This class takes I/Q baseband data at about 250kHz and performs
+// wideband broadcast FM demodulation with stereo decoding.
+// The composite MPX signal from the discriminator is mixed down by
+// a 38kHz subcarrier derived from a PLL locked to the 19kHz pilot.
+// Both the L+R and L-R signals are then decimated to the audio rate
+// by a single decimating FIR that only calculates the output samples
+// that are kept. The stereo matrix and de-emphasis run at the audio rate.
+//
+// History:
+//	2026-10-19  Initial creation
+/////////////////////////////////////////////////////////////////////
+
+//==========================================================================================
+// + + +   This Software is released under the "Simplified BSD License"  + + +
+//Copyright 2010 Moe Wheatley. All rights reserved.
+//
+//Redistribution and use in source and binary forms, with or without modification, are
+//permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice, this list of
+//	  conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright notice, this list
+//	  of conditions and the following disclaimer in the documentation and/or other materials
+//	  provided with the distribution.
+//
+//THIS SOFTWARE IS PROVIDED BY Moe Wheatley ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Moe Wheatley OR
+//CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//The views and conclusions contained in the software and documentation are those of the
+//authors and should not be interpreted as representing official policies, either expressed
+//or implied, of Moe Wheatley.
+//==========================================================================================
+#include "dsp/wfmdemod.h"
+#include "dsp/fastmath.h"
+#include "dsp/fir.h"
+
+//////////////////////////////////////////////////////////////////////
+// Local Defines
+//////////////////////////////////////////////////////////////////////
+#define WFM_MAX_DEVIATION 75000.0	//broadcast FM peak deviation
+#define WFM_MIN_AUDIO_RATE 40000.0	//audio rate is the highest integer decimation above this
+#define WFM_AUDIO_PASS 15000.0		//audio decimation filter passband
+#define WFM_AUDIO_STOP 19000.0		//audio decimation filter stopband(removes pilot)
+#define WFM_AUDIO_ASTOP 60.0		//audio decimation filter stopband attenuation in dB
+#define WFM_PILOT_FREQ 19000.0
+#define WFM_PILOT_LEVEL 0.1			//nominal pilot level relative to max deviation
+#define WFM_PILOT_RANGE 50.0		//max pilot PLL frequency correction in Hz
+#define WFM_PLL_BLOCK 32			//number of samples between pilot PLL updates
+#define WFM_PLL_BW 20.0				//pilot PLL natural frequency in Hz
+#define WFM_PLL_ZETA 0.707			//pilot PLL damping factor
+#define WFM_LOCK_TIMECONST 0.05		//pilot level detector time constant in Sec
+#define WFM_LOCK_ON 0.6				//pilot level relative to nominal to declare stereo lock
+#define WFM_LOCK_OFF 0.4			//pilot level relative to nominal to drop stereo lock
+#define WFM_DEEMPHASIS_TIME 75e-6	//de-emphasis time constant(use 50e-6 for Europe)
+#define WFM_MAX_OUT 25000.0			//max audio output level
+
+/////////////////////////////////////////////////////////////////////
+//   constructor/destructor
+/////////////////////////////////////////////////////////////////////
+CWFmDemod::CWFmDemod(TYPEREAL samplerate)
+{
+	m_SampleRate = samplerate;
+	m_Decimation = (int)(m_SampleRate/WFM_MIN_AUDIO_RATE);
+	if(m_Decimation < 1)
+		m_Decimation = 1;
+	m_OutRate = m_SampleRate/(TYPEREAL)m_Decimation;
+	m_MpxGain = m_SampleRate/(K_2PI*WFM_MAX_DEVIATION);
+
+	//pilot PLL is updated once every WFM_PLL_BLOCK samples
+	m_PilotInc = K_2PI*WFM_PILOT_FREQ/m_SampleRate;
+	m_PilotRange = K_2PI*WFM_PILOT_RANGE/m_SampleRate;
+	TYPEREAL wnT = K_2PI*WFM_PLL_BW*(TYPEREAL)WFM_PLL_BLOCK/m_SampleRate;
+	m_PllAlpha = 2.0*WFM_PLL_ZETA*wnT;
+	m_PllBeta = (wnT*wnT)/(TYPEREAL)WFM_PLL_BLOCK;
+	m_LockAlpha = 1.0 - exp(-(TYPEREAL)WFM_PLL_BLOCK/(m_SampleRate*WFM_LOCK_TIMECONST));
+	m_DeemphAlpha = 1.0 - exp(-1.0/(m_OutRate*WFM_DEEMPHASIS_TIME));
+
+	m_PilotLocked = false;
+	m_PilotFreq = 0.0;
+	m_PllCount = 0;
+	m_PllErrAcc = 0.0;
+	m_PllLockAcc = 0.0;
+	m_PilotLevel = 0.0;
+	m_PilotNco.re = 1.0;
+	m_PilotNco.im = 0.0;
+	m_PilotRot.re = cos(m_PilotInc);
+	m_PilotRot.im = sin(m_PilotInc);
+	m_LastSample.re = 0.0;
+	m_LastSample.im = 0.0;
+	m_DeemphL = 0.0;
+	m_DeemphR = 0.0;
+
+	m_pSumBuf = new TYPEREAL[WFM_MAX_BLOCK];
+	m_pDiffBuf = new TYPEREAL[WFM_MAX_BLOCK];
+	m_pSumOut = new TYPEREAL[WFM_MAX_BLOCK];
+	m_pDiffOut = new TYPEREAL[WFM_MAX_BLOCK];
+	InitAudioFilter();
+}
+
+CWFmDemod::~CWFmDemod()
+{
+	if(m_pSumBuf)
+		delete m_pSumBuf;
+	if(m_pDiffBuf)
+		delete m_pDiffBuf;
+	if(m_pSumOut)
+		delete m_pSumOut;
+	if(m_pDiffOut)
+		delete m_pDiffOut;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Designs the Kaiser windowed lowpass filter used to decimate the
+// L+R and L-R signals to the audio rate.
+/////////////////////////////////////////////////////////////////////
+void CWFmDemod::InitAudioFilter()
+{
+	int NumTaps;
+	TYPEREAL normFpass = WFM_AUDIO_PASS/m_SampleRate;
+	TYPEREAL normFstop = WFM_AUDIO_STOP/m_SampleRate;
+	TYPEREAL normFcut = (normFstop + normFpass)/2.0;
+	TYPEREAL Beta = .1102 * (WFM_AUDIO_ASTOP - 8.71);
+	NumTaps = (int)((WFM_AUDIO_ASTOP - 8.0) / (2.285*K_2PI*(normFstop - normFpass) ) + 1);
+	NumTaps |= 1;		//make odd so has integer delay
+	TYPEREAL* pCoef = new TYPEREAL[NumTaps];
+	TYPEREAL fCenter = .5*(TYPEREAL)(NumTaps-1);
+	TYPEREAL izb = CFir::Izero(Beta);
+	for(int n=0; n<NumTaps; n++)
+	{
+		TYPEREAL x = (TYPEREAL)n - fCenter;
+		TYPEREAL c;
+		if( (TYPEREAL)n == fCenter )
+			c = 2.0 * normFcut;
+		else
+			c = (TYPEREAL)sin(K_2PI*x*normFcut)/(K_PI*x);
+		x = x/fCenter;
+		pCoef[n] = c * CFir::Izero( Beta * sqrt(1 - (x*x) ) ) / izb;
+	}
+	m_SumFir.Init(NumTaps, pCoef, m_Decimation);
+	m_DiffFir.Init(NumTaps, pCoef, m_Decimation);
+	delete[] pCoef;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Pilot PLL loop filter called every WFM_PLL_BLOCK samples with the
+// phase error and pilot level accumulated over the block.
+// The NCO phase is corrected by rotating its phasor so no per sample
+// sin/cos is required, and the phasor is renormalized here to remove
+// rounding drift from the per sample rotations.
+/////////////////////////////////////////////////////////////////////
+void CWFmDemod::UpdatePilotPll()
+{
+	TYPEREAL norm = 2.0/((TYPEREAL)WFM_PLL_BLOCK*WFM_PILOT_LEVEL);
+	TYPEREAL err = m_PllErrAcc*norm;		//~sin(phase error) when locked
+	TYPEREAL level = m_PllLockAcc*norm;		//~1.0 when locked to nominal pilot
+	m_PllErrAcc = 0.0;
+	m_PllLockAcc = 0.0;
+	m_PllCount = 0;
+
+	m_PilotLevel += m_LockAlpha*(level - m_PilotLevel);
+	if(m_PilotLocked)
+	{
+		if(m_PilotLevel < WFM_LOCK_OFF)
+			m_PilotLocked = false;
+	}
+	else if(m_PilotLevel > WFM_LOCK_ON)
+	{
+		m_PilotLocked = true;
+	}
+
+	if(err > 1.0)
+		err = 1.0;
+	else if(err < -1.0)
+		err = -1.0;
+
+	//update NCO frequency
+	m_PilotFreq += m_PllBeta*err;
+	if(m_PilotFreq > m_PilotRange)
+		m_PilotFreq = m_PilotRange;
+	else if(m_PilotFreq < -m_PilotRange)
+		m_PilotFreq = -m_PilotRange;
+	m_PilotRot.re = cos(m_PilotInc + m_PilotFreq);
+	m_PilotRot.im = sin(m_PilotInc + m_PilotFreq);
+
+	//update NCO phase and normalize its amplitude
+	TYPEREAL ph = m_PllAlpha*err;
+	TYPEREAL c = cos(ph);
+	TYPEREAL s = sin(ph);
+	TYPECPX p = m_PilotNco;
+	TYPEREAL g = 1.0/sqrt(p.re*p.re + p.im*p.im);
+	m_PilotNco.re = g*(p.re*c - p.im*s);
+	m_PilotNco.im = g*(p.re*s + p.im*c);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Demodulates up to WFM_MAX_BLOCK I/Q samples into m_pSumOut and
+// m_pDiffOut at the audio rate.
+// returns number of audio rate samples.
+/////////////////////////////////////////////////////////////////////
+int CWFmDemod::ProcessBlock(int InLength, TYPECPX* pInData)
+{
+	int i;
+	TYPEREAL* pSum = m_pSumBuf;
+	TYPEREAL* pDiff = m_pDiffBuf;
+
+	//delay line discriminator gives the composite MPX signal
+	TYPECPX last = m_LastSample;
+	pSum[0] = m_MpxGain*FastAtan2(pInData[0].im*last.re - pInData[0].re*last.im,
+								pInData[0].re*last.re + pInData[0].im*last.im);
+	for(i=1; i<InLength; i++)
+	{
+		TYPECPX x = pInData[i];
+		TYPECPX y = pInData[i-1];
+		pSum[i] = m_MpxGain*FastAtan2(x.im*y.re - x.re*y.im, x.re*y.re + x.im*y.im);
+	}
+	m_LastSample = pInData[InLength-1];
+
+	//pilot PLL phase detector and 38kHz L-R mixer
+	//sin(2*pilot) = 2*sin*cos, mixing gain of 2 restores the L-R level
+	for(i=0; i<InLength; i++)
+	{
+		TYPEREAL mpx = pSum[i];
+		TYPECPX p = m_PilotNco;
+		m_PllErrAcc -= mpx*p.im;
+		m_PllLockAcc += mpx*p.re;
+		pDiff[i] = -4.0*p.re*p.im*mpx;
+		m_PilotNco.re = p.re*m_PilotRot.re - p.im*m_PilotRot.im;
+		m_PilotNco.im = p.re*m_PilotRot.im + p.im*m_PilotRot.re;
+		if(++m_PllCount >= WFM_PLL_BLOCK)
+			UpdatePilotPll();
+	}
+
+	//decimating lowpass filter only calculates the kept output samples
+	int n = m_SumFir.ProcessData(InLength, m_pSumBuf, m_pSumOut);
+	m_DiffFir.ProcessData(InLength, m_pDiffBuf, m_pDiffOut);
+	return n;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Process WFM I/Q data with mono audio output
+// returns number of audio rate samples.
+/////////////////////////////////////////////////////////////////////
+int CWFmDemod::ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData)
+{
+	int n = 0;
+	for(int i=0; i<InLength; i += WFM_MAX_BLOCK)
+	{
+		int len = ProcessBlock( qMin(InLength-i, WFM_MAX_BLOCK), &pInData[i]);
+		for(int j=0; j<len; j++)
+		{
+			m_DeemphL += m_DeemphAlpha*(m_pSumOut[j] - m_DeemphL);
+			pOutData[n++] = m_DeemphL*WFM_MAX_OUT;
+		}
+	}
+	return n;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Process WFM I/Q data with stereo audio output(re=left, im=right)
+// Falls back to mono if the pilot PLL is not locked.
+// returns number of audio rate samples.
+/////////////////////////////////////////////////////////////////////
+int CWFmDemod::ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData)
+{
+	int n = 0;
+	for(int i=0; i<InLength; i += WFM_MAX_BLOCK)
+	{
+		int len = ProcessBlock( qMin(InLength-i, WFM_MAX_BLOCK), &pInData[i]);
+		bool stereo = m_PilotLocked;
+		for(int j=0; j<len; j++)
+		{
+			TYPEREAL s = m_pSumOut[j];
+			TYPEREAL d = stereo ? m_pDiffOut[j] : 0.0;
+			m_DeemphL += m_DeemphAlpha*(s + d - m_DeemphL);
+			m_DeemphR += m_DeemphAlpha*(s - d - m_DeemphR);
+			pOutData[n].re = m_DeemphL*WFM_MAX_OUT;
+			pOutData[n].im = m_DeemphR*WFM_MAX_OUT;
+			n++;
+		}
+	}
+	return n;
+}
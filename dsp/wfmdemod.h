@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////
+// wfmdemod.h: interface for the CWFmDemod class.
+//
+// History:
+//	2026-10-19  Initial creation
+/////////////////////////////////////////////////////////////////////
+#ifndef WFMDEMOD_H
+#define WFMDEMOD_H
+#include "dsp/datatypes.h"
+#include "dsp/firfilter.h"
+
+#define WFM_DECIMATION_BW 80000.0	//downconverter bandwidth giving ~250kHz input rate
+#define WFM_MAX_BLOCK 4096			//max input samples processed per pass
+#define WFM_MIN_INPUT_RATE 200000.0	//lowest radio sample rate that holds a broadcast FM signal
+
+class CWFmDemod
+{
+public:
+	CWFmDemod(TYPEREAL samplerate);
+	virtual ~CWFmDemod();
+	TYPEREAL GetOutputRate(){return m_OutRate;}	//audio output rate
+	bool GetStereoLock(){return m_PilotLocked;}
+	//overloaded functions for mono and stereo
+	int ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData);
+	int ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
+
+private:
+	int ProcessBlock(int InLength, TYPECPX* pInData);
+	void UpdatePilotPll();
+	void InitAudioFilter();
+
+	bool m_PilotLocked;
+	int m_Decimation;
+	int m_PllCount;
+	TYPEREAL m_SampleRate;
+	TYPEREAL m_OutRate;
+	TYPEREAL m_MpxGain;		//discriminator radians to fraction of max deviation
+	TYPEREAL m_PilotInc;	//nominal pilot NCO radians per sample
+	TYPEREAL m_PilotFreq;	//pilot NCO frequency correction
+	TYPEREAL m_PilotRange;
+	TYPEREAL m_PllAlpha;
+	TYPEREAL m_PllBeta;
+	TYPEREAL m_PllErrAcc;
+	TYPEREAL m_PllLockAcc;
+	TYPEREAL m_PilotLevel;
+	TYPEREAL m_LockAlpha;
+	TYPEREAL m_DeemphAlpha;
+	TYPEREAL m_DeemphL;
+	TYPEREAL m_DeemphR;
+	TYPECPX m_PilotNco;		//rotating pilot NCO phasor
+	TYPECPX m_PilotRot;		//per sample NCO rotation
+	TYPECPX m_LastSample;
+
+	CFirFilter<TYPEREAL,TYPEREAL> m_SumFir;		//L+R audio decimation filter
+	CFirFilter<TYPEREAL,TYPEREAL> m_DiffFir;	//L-R audio decimation filter
+	TYPEREAL* m_pSumBuf;	//L+R samples at the input rate
+	TYPEREAL* m_pDiffBuf;	//L-R samples at the input rate
+	TYPEREAL* m_pSumOut;
+	TYPEREAL* m_pDiffOut;
+};
+
+#endif // WFMDEMOD_H
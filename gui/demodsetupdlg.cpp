@@ -98,6 +98,15 @@ void CDemodSetupDlg::OnHangOn(bool On)
 	}
 }
 
+void CDemodSetupDlg::OnFastDiscOn(bool On)
+{
+	if(m_pDemodInfo)
+	{
+		m_pDemodInfo->FmFastDisc = On;
+		((MainWindow*)this->parent())->SetupDemod(m_DemodMode);
+	}
+}
+
 //Fill in initial data
 void CDemodSetupDlg::InitDlg()
 {
@@ -124,7 +133,12 @@ void CDemodSetupDlg::InitDlg()
 	case DEMOD_CWL:
 		ui->CWLradioButton->setChecked(TRUE);
 		break;
+	case DEMOD_WFM:
+		ui->WFMradioButton->setChecked(TRUE);
+		break;
 	}
+	//WFM needs a radio sample rate wide enough for the broadcast signal
+	ui->WFMradioButton->setEnabled(((MainWindow*)this->parent())->DemodRateOk(DEMOD_WFM));
 	m_pDemodInfo = &(((MainWindow*)this->parent())->m_DemodSettings[m_DemodMode]);
 	UpdateDemodInfo();
 }
@@ -135,6 +149,9 @@ void CDemodSetupDlg::UpdateDemodInfo()
 int tmp;
 	ui->checkBoxAgcOn->setChecked(m_pDemodInfo->AgcOn);
 	ui->checkBoxHang->setChecked(m_pDemodInfo->AgcHangOn);
+	ui->checkBoxFastDisc->setChecked(m_pDemodInfo->FmFastDisc);
+	ui->checkBoxFastDisc->setEnabled(DEMOD_FM == m_DemodMode);
+	ui->horizontalSliderSquelch->setEnabled(DEMOD_WFM != m_DemodMode);	//no WFM squelch
 	if(m_pDemodInfo->AgcOn)
 	{
 		ui->frameThresh->SetName("Knee");
@@ -199,6 +216,8 @@ void CDemodSetupDlg::ModeChanged()
 		m_DemodMode = DEMOD_CWU;
 	else if(ui->CWLradioButton->isChecked())
 		m_DemodMode = DEMOD_CWL;
+	else if(ui->WFMradioButton->isChecked())
+		m_DemodMode = DEMOD_WFM;
 	((MainWindow*)this->parent())->SetupDemod(m_DemodMode);
 	m_pDemodInfo = &(((MainWindow*)this->parent())->m_DemodSettings[m_DemodMode]);
 	UpdateDemodInfo();
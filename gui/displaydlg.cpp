@@ -49,6 +49,8 @@ CDisplayDlg::CDisplayDlg(QWidget *parent) :
 	m_FftSize = 4096;
 	m_MaxDisplayRate = 10;
 	m_Percent2DScreen = 50;
+	m_FftDetectors = 0;
+	m_ZoomFftSize = 0;
 }
 
 CDisplayDlg::~CDisplayDlg()
@@ -72,11 +74,26 @@ void CDisplayDlg::InitDlg()
 		m_FftSize = 4096;
 	}
 	ui->fftSizecomboBox->setCurrentIndex(index);
+
+	ui->zoomFftcomboBox->addItem("Off", 0);
+	ui->zoomFftcomboBox->addItem("4096 pts", 4096);
+	ui->zoomFftcomboBox->addItem("16384 pts", 16384);
+	ui->zoomFftcomboBox->addItem("65536 pts", 65536);
+	index = ui->zoomFftcomboBox->findData(m_ZoomFftSize);
+	if(index<0)
+	{
+		index = 0;
+		m_ZoomFftSize = 0;
+	}
+	ui->zoomFftcomboBox->setCurrentIndex(index);
 	ui->fftAvespinBox->setValue(m_FftAve);
 	ui->ClickResolutionspinBox->setValue(m_ClickResolution);
 	ui->MaxDisplayRatespinBox->setValue(m_MaxDisplayRate);
 	ui->Screen2DSizespinBox->setValue(m_Percent2DScreen);
 	ui->checkBoxTestBench->setChecked(m_UseTestBench);
+	ui->checkBoxPeakHold->setChecked(m_FftDetectors & FFT_DETECT_PEAK);
+	ui->checkBoxMinHold->setChecked(m_FftDetectors & FFT_DETECT_MIN);
+	ui->checkBoxRmsAve->setChecked(m_FftDetectors & FFT_DETECT_RMS);
 	m_NeedToStop = false;
 }
 
@@ -84,6 +101,7 @@ void CDisplayDlg::InitDlg()
 void CDisplayDlg::accept()
 {
 	m_FftSize = ui->fftSizecomboBox->itemData(ui->fftSizecomboBox->currentIndex()).toInt();
+	m_ZoomFftSize = ui->zoomFftcomboBox->itemData(ui->zoomFftcomboBox->currentIndex()).toInt();
 	int tmpsz = ui->Screen2DSizespinBox->value();
 	if( tmpsz!=m_Percent2DScreen)
 	{
@@ -94,6 +112,13 @@ void CDisplayDlg::accept()
 	m_ClickResolution = ui->ClickResolutionspinBox->value();
 	m_MaxDisplayRate = ui->MaxDisplayRatespinBox->value();
 	m_UseTestBench = ui->checkBoxTestBench->isChecked();
+	m_FftDetectors = 0;
+	if(ui->checkBoxPeakHold->isChecked())
+		m_FftDetectors |= FFT_DETECT_PEAK;
+	if(ui->checkBoxMinHold->isChecked())
+		m_FftDetectors |= FFT_DETECT_MIN;
+	if(ui->checkBoxRmsAve->isChecked())
+		m_FftDetectors |= FFT_DETECT_RMS;
 	QDialog::accept();	//need to call base class
 }
 
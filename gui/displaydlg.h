@@ -31,6 +31,8 @@ public:
 	int m_ClickResolution;
 	int m_MaxDisplayRate;
 	int m_Percent2DScreen;
+	int m_FftDetectors;
+	int m_ZoomFftSize;
 	bool m_NeedToStop;
 	bool m_UseTestBench;
 
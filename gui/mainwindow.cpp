@@ -66,6 +66,8 @@ QUdpSocket g_UdpDiscoverSocket;	//global hack to get around bug in UDP sockets
 #define MAX_FFTDB 60
 #define MIN_FFTDB -170
 
+#define DISPLAY_STATS_TIME 1000	//mSec between display frame rate measurements
+
 /////////////////////////////////////////////////////////////////////
 // Constructor/Destructor
 /////////////////////////////////////////////////////////////////////
@@ -94,16 +96,23 @@ MainWindow::MainWindow(QWidget *parent) :
 	m_pDemodSetupDlg = new CDemodSetupDlg(this);
 
 	m_pTimer = new QTimer(this);
+	m_pDisplayTimer = new QTimer(this);
+	m_LastFftFrame = 0;
+	m_DisplayDrawCount = 0;
+	m_DisplayFps = 0.0;
+	m_ActiveDisplayRate = 0;
+	m_ShedLevel = CLoadGovernor::SHED_NONE;
+	m_RecenterRx = false;
 
 	//connect a bunch of signals to the GUI objects
 	connect(m_pTimer, SIGNAL(timeout()), this, SLOT(OnTimer()));
+	connect(m_pDisplayTimer, SIGNAL(timeout()), this, SLOT(OnDisplayTimer()));
 
 	connect(ui->frameFreqCtrl, SIGNAL(NewFrequency(qint64)), this, SLOT(OnNewCenterFrequency(qint64)));
 	connect(ui->frameDemodFreqCtrl, SIGNAL(NewFrequency(qint64)), this, SLOT(OnNewDemodFrequency(qint64)));
 
 	connect(m_pSdrInterface, SIGNAL(NewStatus(int)), this,  SLOT( OnStatus(int) ) );
 	connect(m_pSdrInterface, SIGNAL(NewInfoData()), this,  SLOT( OnNewInfoData() ) );
-	connect(m_pSdrInterface, SIGNAL(NewFftData()), this,  SLOT( OnNewFftData() ) );
 
 	connect(ui->actionExit, SIGNAL(triggered()), this, SLOT(OnExit()));
 	connect(ui->actionNetwork, SIGNAL(triggered()), this, SLOT(OnNetworkDlg()));
@@ -122,6 +131,8 @@ MainWindow::MainWindow(QWidget *parent) :
 	connect(ui->framePlot, SIGNAL(NewHighCutFreq(int)), this,  SLOT( OnNewHighCutFreq(int) ) );
 
 	m_pTimer->start(200);		//start up status timer
+	SetDisplayRate();			//start up display scheduler timer
+	m_DisplayStatsTime.start();
 
 	m_pSdrInterface->SetRadioType(m_RadioType);
 		quint32 maxspan = m_pSdrInterface->GetMaxBWFromIndex(m_BandwidthIndex);
@@ -146,6 +157,11 @@ MainWindow::MainWindow(QWidget *parent) :
 	ui->frameFreqCtrl->SetFrequency(m_CenterFrequency);
 
 	m_DemodFrequency = tmpdemod;
+	//the control shows the tuned frequency so show the saved demod
+	//frequency without moving the radio off the saved center frequency
+	ui->frameFreqCtrl->blockSignals(true);
+	ui->frameFreqCtrl->SetFrequency(m_DemodFrequency);
+	ui->frameFreqCtrl->blockSignals(false);
 	ui->frameDemodFreqCtrl->Setup(9, 100U, 500000000U, 1, UNITS_KHZ );
 	ui->frameDemodFreqCtrl->SetBkColor(Qt::darkBlue);
 	ui->frameDemodFreqCtrl->SetDigitColor(Qt::white);
@@ -182,6 +198,9 @@ MainWindow::MainWindow(QWidget *parent) :
 
 	m_pSdrInterface->SetFftSize( m_FftSize);
 	m_pSdrInterface->SetFftAve( m_FftAve);
+	m_pSdrInterface->SetFftDetectors( m_FftDetectors);
+	m_pSdrInterface->SetZoomFftSize( m_ZoomFftSize);
+	ui->framePlot->SetZoomMode(m_ZoomFftSize>0);
 	m_pSdrInterface->SetMaxDisplayRate(m_MaxDisplayRate);
 	m_pSdrInterface->SetSdrBandwidthIndex(m_BandwidthIndex);
 	m_pSdrInterface->SetSdrRfGain( m_RfGain );
@@ -190,6 +209,8 @@ MainWindow::MainWindow(QWidget *parent) :
 										  &m_NCOSpurOffsetQ);
 
 	m_pSdrInterface->SetSoundCardSelection(m_SoundInIndex, m_SoundOutIndex, m_StereoOut);
+	m_pSdrInterface->SetSoundLatency(m_LowLatency, m_AudioLatency);
+	m_pSdrInterface->SetIntFrontEnd(m_IntFrontEnd);
 
 	InitDemodSettings();
 	ui->framePlot->SetDemodCenterFreq( m_DemodFrequency );
@@ -294,13 +315,18 @@ void MainWindow::writeSettings()
 	settings.setValue("Port",m_Port);
 	settings.setValue("RfGain",m_RfGain);
 	settings.setValue("BandwidthIndex", m_BandwidthIndex );
+	settings.setValue("IntFrontEnd", m_IntFrontEnd );
 	settings.setValue("SoundInIndex",m_SoundInIndex);
 	settings.setValue("SoundOutIndex",m_SoundOutIndex);
+	settings.setValue("LowLatency",m_LowLatency);
+	settings.setValue("AudioLatency",m_AudioLatency);
 	settings.setValue("StereoOut",m_StereoOut);
 	settings.setValue("VertScaleIndex",m_VertScaleIndex);
 	settings.setValue("MaxdB",m_MaxdB);
 	settings.setValue("FftSize",m_FftSize);
 	settings.setValue("FftAve",m_FftAve);
+	settings.setValue("FftDetectors",m_FftDetectors);
+	settings.setValue("ZoomFftSize",m_ZoomFftSize);
 	settings.setValue("MaxDisplayRate",m_MaxDisplayRate);
 	settings.setValue("ClickResolution",m_ClickResolution);
 	settings.setValue("UseTestBench",m_UseTestBench);
@@ -321,6 +347,9 @@ void MainWindow::writeSettings()
 	settings.setValue("NBOn",m_NoiseProcSettings.NBOn);
 	settings.setValue("NBThreshold",m_NoiseProcSettings.NBThreshold);
 	settings.setValue("NBWidth",m_NoiseProcSettings.NBWidth);
+	settings.setValue("NROn",m_NoiseProcSettings.NROn);
+	settings.setValue("NRLevel",m_NoiseProcSettings.NRLevel);
+	settings.setValue("NotchOn",m_NoiseProcSettings.NotchOn);
 
 	settings.endGroup();
 
@@ -361,6 +390,7 @@ void MainWindow::writeSettings()
 		settings.setValue("AgcDecay", m_DemodSettings[i].AgcDecay);
 		settings.setValue("AgcOn", m_DemodSettings[i].AgcOn);
 		settings.setValue("AgcHangOn", m_DemodSettings[i].AgcHangOn);
+		settings.setValue("FmFastDisc", m_DemodSettings[i].FmFastDisc);
 	}
 	settings.endArray();
 }
@@ -384,12 +414,17 @@ void MainWindow::readSettings()
 	m_Port = settings.value("Port", 50000).toUInt();
 	m_RfGain = settings.value("RfGain", 0).toInt();
 	m_BandwidthIndex = settings.value("BandwidthIndex", 0).toInt();
+	m_IntFrontEnd = settings.value("IntFrontEnd", false).toBool();
 	m_SoundInIndex = settings.value("SoundInIndex", 0).toInt();
 	m_SoundOutIndex = settings.value("SoundOutIndex", 0).toInt();
+	m_LowLatency = settings.value("LowLatency", false).toBool();
+	m_AudioLatency = settings.value("AudioLatency", 20).toInt();
 	m_StereoOut = settings.value("StereoOut", false).toBool();
 	m_VertScaleIndex = settings.value("VertScaleIndex", 0).toInt();
 	m_MaxdB = settings.value("MaxdB", 0).toInt();
 	m_FftAve = settings.value("FftAve", 0).toInt();
+	m_FftDetectors = settings.value("FftDetectors", 0).toInt();
+	m_ZoomFftSize = settings.value("ZoomFftSize", 0).toInt();
 	m_FftSize = settings.value("FftSize", 4096).toInt();
 	m_MaxDisplayRate = settings.value("MaxDisplayRate", 10).toInt();
 	m_RadioType = settings.value("RadioType", 0).toInt();
@@ -406,6 +441,9 @@ void MainWindow::readSettings()
 	m_NoiseProcSettings.NBOn = settings.value("NBOn", false).toBool();
 	m_NoiseProcSettings.NBThreshold = settings.value("NBThreshold",0).toInt();
 	m_NoiseProcSettings.NBWidth = settings.value("NBWidth",50).toInt();
+	m_NoiseProcSettings.NROn = settings.value("NROn", false).toBool();
+	m_NoiseProcSettings.NRLevel = settings.value("NRLevel",50).toInt();
+	m_NoiseProcSettings.NotchOn = settings.value("NotchOn", false).toBool();
 
 
 	m_DemodMode = settings.value("DemodMode", DEMOD_AM).toInt();
@@ -450,6 +488,7 @@ void MainWindow::readSettings()
 		m_DemodSettings[i].AgcDecay = settings.value("AgcDecay", 200).toInt();
 		m_DemodSettings[i].AgcOn = settings.value("AgcOn",true).toBool();
 		m_DemodSettings[i].AgcHangOn = settings.value("AgcHangOn",false).toBool();
+		m_DemodSettings[i].FmFastDisc = settings.value("FmFastDisc",false).toBool();
 	}
 	settings.endArray();
 
@@ -471,6 +510,49 @@ void MainWindow::OnTimer()
 			m_pSdrInterface->KeepAlive();
 	}
 	ui->frameMeter->SetdBmLevel( m_pSdrInterface->GetSMeterAve() );
+	UpdateDisplayRateStats();
+	UpdateLoadShedding();
+}
+
+/////////////////////////////////////////////////////////////////////
+// Called by the status timer to apply any change in the DSP load
+// governor shed level to the display work done by the GUI
+/////////////////////////////////////////////////////////////////////
+void MainWindow::UpdateLoadShedding()
+{
+qint32 level = m_pSdrInterface->GetLoadShedLevel();
+	if(level == m_ShedLevel)
+		return;
+	m_ShedLevel = level;
+	m_pSdrInterface->ApplyLoadShedding();
+	SetDisplayRate();
+	ui->framePlot->SetWaterfallDecimation( (level >= CLoadGovernor::SHED_WATERFALL) ? 2 : 1);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Sets the display scheduler timer to the requested display rate
+/////////////////////////////////////////////////////////////////////
+void MainWindow::SetDisplayRate()
+{
+	if(m_MaxDisplayRate < 1)
+		m_MaxDisplayRate = 1;
+	m_ActiveDisplayRate = m_MaxDisplayRate;
+	if(m_ShedLevel >= CLoadGovernor::SHED_DISPLAYRATE)	//halve rate if DSP is overloaded
+		m_ActiveDisplayRate = (m_MaxDisplayRate+1)/2;
+	m_pDisplayTimer->start(1000/m_ActiveDisplayRate);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Called by the status timer to measure the achieved display rate
+/////////////////////////////////////////////////////////////////////
+void MainWindow::UpdateDisplayRateStats()
+{
+int elapsed = m_DisplayStatsTime.elapsed();
+	if(elapsed < DISPLAY_STATS_TIME)
+		return;
+	m_DisplayFps = (1000.0*(double)m_DisplayDrawCount)/(double)elapsed;
+	m_DisplayDrawCount = 0;
+	m_DisplayStatsTime.restart();
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -512,6 +594,8 @@ void MainWindow::OnDisplayDlg()
 CDisplayDlg dlg(this);
 	dlg.m_FftSize = m_FftSize;
 	dlg.m_FftAve = m_FftAve;
+	dlg.m_FftDetectors = m_FftDetectors;
+	dlg.m_ZoomFftSize = m_ZoomFftSize;
 	dlg.m_ClickResolution = m_ClickResolution;
 	dlg.m_MaxDisplayRate = m_MaxDisplayRate;
 	dlg.m_UseTestBench = m_UseTestBench;
@@ -534,12 +618,21 @@ CDisplayDlg dlg(this);
 		}
 		m_FftSize = dlg.m_FftSize;
 		m_FftAve = dlg.m_FftAve;
+		m_FftDetectors = dlg.m_FftDetectors;
+		if(m_ZoomFftSize != dlg.m_ZoomFftSize)
+		{	//switching zoom mode changes the plot frequency scale
+			m_ZoomFftSize = dlg.m_ZoomFftSize;
+			m_pSdrInterface->SetZoomFftSize( m_ZoomFftSize);
+			ui->framePlot->SetZoomMode(m_ZoomFftSize>0);
+		}
 		m_ClickResolution = dlg.m_ClickResolution;
 		m_MaxDisplayRate = dlg.m_MaxDisplayRate;
 		m_UseTestBench = dlg.m_UseTestBench;
 		m_pSdrInterface->SetFftAve( m_FftAve);
+		m_pSdrInterface->SetFftDetectors( m_FftDetectors);
 		m_pSdrInterface->SetFftSize( m_FftSize);
 		m_pSdrInterface->SetMaxDisplayRate(m_MaxDisplayRate);
+		SetDisplayRate();
 		ui->framePlot->SetClickResolution(m_ClickResolution);
 		if(m_UseTestBench)
 		{	//make TestBench visable if not already
@@ -572,6 +665,8 @@ CSoundDlg dlg(this);
 	dlg.SetInputIndex(m_SoundInIndex);
 	dlg.SetOutputIndex(m_SoundOutIndex);
 	dlg.SetStereo(m_StereoOut);
+	dlg.SetLowLatency(m_LowLatency);
+	dlg.SetLatency(m_AudioLatency);
 	if(QDialog::Accepted == dlg.exec() )
 	{
 		if(CSdrInterface::RUNNING == m_Status)
@@ -580,9 +675,12 @@ CSoundDlg dlg(this);
 			ui->framePlot->SetRunningState(false);
 		}
 		m_StereoOut = dlg.GetStereo();
+		m_LowLatency = dlg.GetLowLatency();
+		m_AudioLatency = dlg.GetLatency();
 		m_SoundInIndex = dlg.GetInputIndex();
 		m_SoundOutIndex = dlg.GetOutputIndex();
 		m_pSdrInterface->SetSoundCardSelection(m_SoundInIndex, m_SoundOutIndex, m_StereoOut);
+		m_pSdrInterface->SetSoundLatency(m_LowLatency, m_AudioLatency);
 	}
 }
 
@@ -594,6 +692,7 @@ void MainWindow::OnSdrDlg()
 {
 CSdrSetupDlg dlg(this,m_pSdrInterface);
 	dlg.m_BandwidthIndex = m_BandwidthIndex;
+	dlg.m_IntFrontEnd = m_IntFrontEnd;
 	dlg.InitDlg();
 	if( dlg.exec() )
 	{
@@ -607,6 +706,8 @@ CSdrSetupDlg dlg(this,m_pSdrInterface);
 			}
 		}
 		SetupNoiseProc();
+		m_IntFrontEnd = dlg.m_IntFrontEnd;
+		m_pSdrInterface->SetIntFrontEnd(m_IntFrontEnd);
 		m_RfGain = dlg.m_RfGain;
 		m_pSdrInterface->SetSdrRfGain( dlg.m_RfGain);
 		m_pSdrInterface->SetSdrBandwidthIndex(m_BandwidthIndex);
@@ -623,6 +724,7 @@ CSdrSetupDlg dlg(this,m_pSdrInterface);
 									  UNITS_KHZ );
 		ui->frameDemodFreqCtrl->SetFrequency(m_DemodFrequency);
 		m_pSdrInterface->SetDemod(m_DemodMode, m_DemodSettings[m_DemodMode]);
+		UpdateInfoBox();
 	}
 }
 
@@ -687,6 +789,8 @@ void MainWindow::UpdateInfoBox()
 			.arg(m_DemodSettings[m_DemodMode].txt)
 			.arg("Lo=").arg(m_DemodSettings[m_DemodMode].LowCut)
 			.arg("Hi=").arg(m_DemodSettings[m_DemodMode].HiCut);
+	if(!DemodRateOk(m_DemodMode))
+		m_Str += "  Sample Rate Too Low";
 	ui->InfoText->setText(m_Str);
 }
 
@@ -714,13 +818,22 @@ void MainWindow::OnRun()
 }
 
 /////////////////////////////////////////////////////////////////////
-// Event: New FFT Display Data is available so draw it
-// Called when new spectrum data is available to be displayed
+// Display scheduler timer event handler
+// Draws the latest spectrum if the DSP thread has produced a new one
+// since the last tick.  Only one FFT is ever pending(the DSP thread waits
+// for the plotter paintEvent before doing the next) so if the GUI falls
+// behind the frames are simply coalesced and nothing is queued up.
 /////////////////////////////////////////////////////////////////////
-void MainWindow::OnNewFftData()
+void MainWindow::OnDisplayTimer()
 {
-	if( CSdrInterface::RUNNING == m_Status)
-		ui->framePlot->draw();
+	if( CSdrInterface::RUNNING != m_Status)
+		return;
+	qint32 frame = m_pSdrInterface->GetFftFrameCount();
+	if(frame == m_LastFftFrame)
+		return;		//nothing new to draw this tick
+	m_LastFftFrame = frame;
+	ui->framePlot->draw();
+	m_DisplayDrawCount++;
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -728,6 +841,7 @@ void MainWindow::OnNewFftData()
 /////////////////////////////////////////////////////////////////////
 void MainWindow::OnStatus(int status)
 {
+tSoundStats SoundStats;
 	m_Status = (CSdrInterface::eStatus)status;
 //qDebug()<<"Status"<< status;
 	switch(status)
@@ -755,10 +869,17 @@ void MainWindow::OnStatus(int status)
 			ui->pushButtonRun->setEnabled(true);
 			break;
 		case CSdrInterface::RUNNING:
-			m_Str.setNum(m_pSdrInterface->GetRateError());
-			m_Str.append(" ppm  Missed Pkts=");
+			m_pSdrInterface->GetSoundStats(&SoundStats);
+			m_Str.sprintf("%d ppm  Latency=%dmS Underflows=%d  Missed Pkts=",
+						SoundStats.PpmError, SoundStats.LatencymSec, SoundStats.Underflows);
 			m_Str2.setNum(m_pSdrInterface->m_MissedPackets);
 			m_Str.append(m_Str2);
+			m_Str2.sprintf("  Display=%.1f/%d fps", m_DisplayFps, m_ActiveDisplayRate);
+			m_Str.append(m_Str2);
+			m_Str2.sprintf("  DSP Load=%d%% Shed=%d", m_pSdrInterface->GetDspLoad(), m_ShedLevel);
+			m_Str.append(m_Str2);
+			m_Str2.sprintf("  Sql Saved=%d%%", m_pSdrInterface->GetSquelchGatedPercent());
+			m_Str.append(m_Str2);
 			ui->statusBar->showMessage(m_ActiveDevice + tr(" Running   ") + m_Str, 0);
 			ui->pushButtonRun->setText("Stop");
 			ui->pushButtonRun->setEnabled(TRUE);
@@ -805,19 +926,32 @@ void MainWindow::OnNewInfoData()
 	m_LastSpanKhz = m_SpanFrequency/1000;
 	ui->framePlot->SetSpanFreq( m_SpanFrequency );
 	m_pSdrInterface->SetDemod(m_DemodMode, m_DemodSettings[m_DemodMode]);
+	UpdateInfoBox();
 }
 
 /////////////////////////////////////////////////////////////////////
 // Handle change event for center frequency control
+// If the new frequency is inside the displayed span with room for the
+//demod filter, only the demod NCO is moved and the radio stays where it
+//is.  Otherwise, or if m_RecenterRx is set, the radio is recentered.
 /////////////////////////////////////////////////////////////////////
 void MainWindow::OnNewCenterFrequency(qint64 freq)
 {
 //qDebug()<<"F = "<<freq;
-	m_CenterFrequency = m_pSdrInterface->SetRxFreq(freq);
-	if(m_CenterFrequency!=freq)	//if freq was clamped by sdr range then update control again
-		ui->frameFreqCtrl->SetFrequency(m_CenterFrequency);
-	m_DemodFrequency = m_CenterFrequency;
-	m_pSdrInterface->SetDemodFreq(m_CenterFrequency - m_DemodFrequency);
+	qint32 maxoffset = 0;
+	if(!m_RecenterRx)
+	{
+		maxoffset = (qint32)m_SpanFrequency/2 - qMax(m_DemodSettings[m_DemodMode].HiCut,
+													-m_DemodSettings[m_DemodMode].LowCut);
+		if(maxoffset < 0)
+			maxoffset = 0;
+	}
+	m_RecenterRx = false;
+	qint64 tunedfreq = m_pSdrInterface->TuneFreq(freq, maxoffset);
+	m_CenterFrequency = m_pSdrInterface->GetRxFreq();
+	if(tunedfreq!=freq)	//if freq was clamped by sdr range then update control again
+		ui->frameFreqCtrl->SetFrequency(tunedfreq);
+	m_DemodFrequency = tunedfreq;
 	ui->framePlot->SetCenterFreq( m_CenterFrequency );
 	ui->framePlot->SetDemodCenterFreq( m_DemodFrequency );
 	//limit demod frequency to Center Frequency +/-span frequency
@@ -831,10 +965,14 @@ void MainWindow::OnNewCenterFrequency(qint64 freq)
 
 /////////////////////////////////////////////////////////////////////
 // Handle change event for demod frequency control
+// The tuned frequency control follows without retuning the radio.
 /////////////////////////////////////////////////////////////////////
 void MainWindow::OnNewDemodFrequency(qint64 freq)
 {
 	m_DemodFrequency = freq;
+	ui->frameFreqCtrl->blockSignals(true);
+	ui->frameFreqCtrl->SetFrequency(m_DemodFrequency);
+	ui->frameFreqCtrl->blockSignals(false);
 	ui->framePlot->SetDemodCenterFreq( m_DemodFrequency );
 	ui->framePlot->UpdateOverlay();
 	m_pSdrInterface->SetDemodFreq(m_CenterFrequency - m_DemodFrequency);
@@ -845,8 +983,10 @@ void MainWindow::OnNewDemodFrequency(qint64 freq)
 /////////////////////////////////////////////////////////////////////
 void MainWindow::OnNewScreenCenterFreq(qint64 freq)
 {
-	m_CenterFrequency = freq;
-	ui->frameFreqCtrl->SetFrequency(m_CenterFrequency);
+	m_RecenterRx = true;	//user asked for a new display center
+	ui->frameFreqCtrl->SetFrequency(freq);
+	if(m_RecenterRx)	//control value did not change so recenter here
+		OnNewCenterFrequency(freq);
 }
 
 
@@ -994,6 +1134,17 @@ void MainWindow::SetupDemod(int index)
 }
 
 
+/////////////////////////////////////////////////////////////////////
+// Returns false if the radio sample rate cannot hold the signal
+//the demod expects.  Only WFM needs more than the lowest rate.
+/////////////////////////////////////////////////////////////////////
+bool MainWindow::DemodRateOk(int index)
+{
+	if(DEMOD_WFM == index)
+		return (m_pSdrInterface->GetSdrSampleRate() >= WFM_MIN_INPUT_RATE);
+	return true;
+}
+
 /////////////////////////////////////////////////////////////////////
 // Setup Demod initial parameters/limits
 /////////////////////////////////////////////////////////////////////
@@ -1050,5 +1201,12 @@ void MainWindow::InitDemodSettings()
 	m_DemodSettings[DEMOD_CWL].LowCutmin = -1000;
 	m_DemodSettings[DEMOD_CWL].Symetric = false;
 
+	m_DemodSettings[DEMOD_WFM].txt = "WFM";
+	m_DemodSettings[DEMOD_WFM].HiCutmin = 80000;
+	m_DemodSettings[DEMOD_WFM].HiCutmax = 100000;
+	m_DemodSettings[DEMOD_WFM].LowCutmax = -80000;
+	m_DemodSettings[DEMOD_WFM].LowCutmin = -100000;
+	m_DemodSettings[DEMOD_WFM].Symetric = true;
+
 	m_pSdrInterface->SetDemod(m_DemodMode, m_DemodSettings[m_DemodMode]);
 }
@@ -10,6 +10,7 @@
 
 #include <QMainWindow>
 #include <QTimer>
+#include <QTime>
 #include "interface/sdrinterface.h"
 #include <QHostAddress>
 #include "gui/demodsetupdlg.h"
@@ -30,6 +31,7 @@ public:
 
 	void SetupDemod(int index);
 	void SetupNoiseProc();
+	bool DemodRateOk(int index);	//false if the radio sample rate is too low for the demod
 	tDemodInfo m_DemodSettings[NUM_DEMODS];	//not all fields are saved in Settings
 
 private slots:
@@ -53,7 +55,7 @@ private slots:
 	void OnTimer();
 	void OnStatus(int status);
 	void OnNewInfoData();
-	void OnNewFftData();
+	void OnDisplayTimer();
 	void OnNewScreenDemodFreq(qint64 freq);
 	void OnNewScreenCenterFreq(qint64 freq);
 	void OnNewCenterFrequency(qint64 freq);	//called when center frequency has changed
@@ -69,6 +71,9 @@ private:
 	void writeSettings();
 	void UpdateInfoBox();
 	void InitDemodSettings();
+	void SetDisplayRate();
+	void UpdateLoadShedding();
+	void UpdateDisplayRateStats();
 
 	/////////////////////////
 	//Persistant Settings Variables saved
@@ -86,6 +91,9 @@ private:
 	qint32 m_BandwidthIndex;
 	qint32 m_SoundInIndex;
 	qint32 m_SoundOutIndex;
+	bool m_LowLatency;
+	bool m_IntFrontEnd;
+	qint32 m_AudioLatency;
 	qint32 m_ClickResolution;
 	qint32 m_MaxDisplayRate;
 	qint32 m_VertScaleIndex;
@@ -94,6 +102,8 @@ private:
 	qint32 m_RfGain;
 	qint32 m_LastSpanKhz;
 	qint32 m_FftAve;
+	qint32 m_FftDetectors;
+	qint32 m_ZoomFftSize;
 	qint32 m_FftSize;
 	qint32 m_Volume;
 	qint32 m_Percent2DScreen;
@@ -109,6 +119,14 @@ private:
 	CSdrInterface::eStatus m_Status;
 	CSdrInterface::eStatus m_LastStatus;
 	QTimer *m_pTimer;
+	QTimer *m_pDisplayTimer;	//display scheduler timer
+	QTime m_DisplayStatsTime;
+	qint32 m_LastFftFrame;
+	qint32 m_DisplayDrawCount;
+	double m_DisplayFps;
+	qint32 m_ActiveDisplayRate;	//display rate after any load shedding
+	qint32 m_ShedLevel;
+	bool m_RecenterRx;		//next center frequency change must move the radio
 	CSdrInterface* m_pSdrInterface;
 	CDemodSetupDlg* m_pDemodSetupDlg;
 	qint32 m_KeepAliveTimer;
@@ -49,6 +49,7 @@ CNoiseProcDlg::CNoiseProcDlg(QWidget *parent) :
 	m_pNoiseProcSettings = NULL;
 	connect(ui->frameNBWidth, SIGNAL(sliderValChanged(int)), this, SLOT(OnNBWidth(int)));
 	connect(ui->frameNBThresh, SIGNAL(sliderValChanged(int)), this, SLOT(OnNBThresh(int)));
+	connect(ui->frameNRLevel, SIGNAL(sliderValChanged(int)), this, SLOT(OnNRLevel(int)));
 	ui->frameNBThresh->SetName("Thresh");
 	ui->frameNBThresh->SetSuffix(" ");
 	ui->frameNBThresh->setRange(0, 99);
@@ -63,6 +64,12 @@ CNoiseProcDlg::CNoiseProcDlg(QWidget *parent) :
 	ui->frameNBWidth->setPageStep(10);
 	ui->frameNBWidth->setTickInterval(30);
 
+	ui->frameNRLevel->SetName("Level");
+	ui->frameNRLevel->SetSuffix(" ");
+	ui->frameNRLevel->setRange(0, 99);
+	ui->frameNRLevel->setSingleStep(1);
+	ui->frameNRLevel->setPageStep(1);
+	ui->frameNRLevel->setTickInterval(10);
 }
 
 CNoiseProcDlg::~CNoiseProcDlg()
@@ -82,6 +89,9 @@ void CNoiseProcDlg::InitDlg(tNoiseProcdInfo* pNoiseProcSettings)
 		ui->checkBoxNBOn->setChecked(false);
 	ui->frameNBThresh->SetValue(m_pNoiseProcSettings->NBThreshold);
 	ui->frameNBWidth->SetValue(m_pNoiseProcSettings->NBWidth);
+	ui->checkBoxNROn->setChecked(m_pNoiseProcSettings->NROn);
+	ui->frameNRLevel->SetValue(m_pNoiseProcSettings->NRLevel);
+	ui->checkBoxNotchOn->setChecked(m_pNoiseProcSettings->NotchOn);
 }
 
 void CNoiseProcDlg::OnNBOn(bool On)
@@ -111,4 +121,31 @@ void CNoiseProcDlg::OnNBWidth(int val)
 	}
 }
 
+void CNoiseProcDlg::OnNROn(bool On)
+{
+	if(m_pNoiseProcSettings)
+	{
+		m_pNoiseProcSettings->NROn = On;
+		((MainWindow*)this->parent())->SetupNoiseProc();
+	}
+}
+
+void CNoiseProcDlg::OnNRLevel(int val)
+{
+	if(m_pNoiseProcSettings)
+	{
+		m_pNoiseProcSettings->NRLevel = val;
+		((MainWindow*)this->parent())->SetupNoiseProc();
+	}
+}
+
+void CNoiseProcDlg::OnNotchOn(bool On)
+{
+	if(m_pNoiseProcSettings)
+	{
+		m_pNoiseProcSettings->NotchOn = On;
+		((MainWindow*)this->parent())->SetupNoiseProc();
+	}
+}
+
 
@@ -30,6 +30,9 @@ private slots:
 	void OnNBThresh(int);
 	void OnNBWidth(int);
 	void OnNBOn(bool);
+	void OnNROn(bool);
+	void OnNRLevel(int);
+	void OnNotchOn(bool);
 
 
 private:
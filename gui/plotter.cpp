@@ -98,6 +98,12 @@ CPlotter::CPlotter(QWidget *parent) :
 	m_CursorCaptureDelta = CUR_CUT_DELTA;
 
 	m_Span = 50000;
+	m_ZoomMode = false;
+	m_WaterfallDecimation = 1;
+	m_WaterfallCount = 0;
+	m_ZoomSpan = 0;
+	m_ZoomCenterOffset = 0;
+	m_ZoomFrameCount = 0;
 	m_MaxdB = 0;
 	m_MindB = -130;
 	m_dBStepSize = 10;
@@ -112,6 +118,10 @@ CPlotter::CPlotter(QWidget *parent) :
 	m_Size = QSize(0,0);
 	m_GrabPosition = 0;
 	m_Percent2DScreen = 50;	//percent of screen used for 2D display
+	m_TraceColor[FFT_TRACE_AVE] = Qt::green;	//2D display detector trace colors
+	m_TraceColor[FFT_TRACE_PEAK] = Qt::yellow;
+	m_TraceColor[FFT_TRACE_MIN] = Qt::darkCyan;
+	m_TraceColor[FFT_TRACE_RMS] = Qt::magenta;
 }
 
 CPlotter::~CPlotter()
@@ -242,8 +252,9 @@ void CPlotter::mouseMoveEvent(QMouseEvent* event)
 	}
 	else if(CENTER==m_CursorCaptured)
 	{	//moving inbetween demod lowcut and highcut region
-		if(event->buttons()&Qt::LeftButton)
+		if( (event->buttons()&Qt::LeftButton) && !m_ZoomMode )
 		{//moving inbetween demod lowcut and highcut region with left button held
+		 //(not in zoom mode since the display recenters on the demod frequency)
 			if(m_GrabPosition!=0)
 			{
 				m_DemodCenterFreq = RoundFreq(FreqfromX( pt.x()-m_GrabPosition ),m_ClickResolution );
@@ -408,36 +419,48 @@ void CPlotter::paintEvent(QPaintEvent *)
 void CPlotter::draw()
 {
 int i;
+int t;
 int w;
 int h;
 qint32 fftbuf[MAX_SCREENSIZE];
+qint32 detbuf[FFT_NUM_TRACES][MAX_SCREENSIZE];
+qint32* pOutBufs[FFT_NUM_TRACES];
+qint32 detectors;
 QPoint LineBuf[MAX_SCREENSIZE];
 
 	if(!m_Running)
 		return;
+	if(m_ZoomMode)
+	{
+		DrawZoom();
+		return;
+	}
 
 //StartPerformance();
-	//get/draw the waterfall
-	w = m_WaterfallPixmap.width();
-	h = m_WaterfallPixmap.height();
-
-	//move current data down one line(must do before attaching a QPainter object)
-	m_WaterfallPixmap.scroll(0,1,0,0, w, h);
-
-	QPainter painter1(&m_WaterfallPixmap);
-	//get scaled FFT data
-	bool fftoverload = m_pSdrInterface->GetScreenIntegerFFTData( 255, w,
-							m_MaxdB,
-							m_MindB,
-							-m_Span/2,
-							m_Span/2,
-							fftbuf );
-
-	//draw new line of fft data at top of waterfall bitmap
-	for(i=0; i<w; i++)
+	//get/draw the waterfall(only every m_WaterfallDecimation updates)
+	if(WaterfallLineDue())
 	{
-		painter1.setPen(m_ColorTbl[ 255-fftbuf[i] ]);
-		painter1.drawPoint(i,0);
+		w = m_WaterfallPixmap.width();
+		h = m_WaterfallPixmap.height();
+
+		//move current data down one line(must do before attaching a QPainter object)
+		m_WaterfallPixmap.scroll(0,1,0,0, w, h);
+
+		QPainter painter1(&m_WaterfallPixmap);
+		//get scaled FFT data
+		m_pSdrInterface->GetScreenIntegerFFTData( 255, w,
+								m_MaxdB,
+								m_MindB,
+								-m_Span/2,
+								m_Span/2,
+								fftbuf );
+
+		//draw new line of fft data at top of waterfall bitmap
+		for(i=0; i<w; i++)
+		{
+			painter1.setPen(m_ColorTbl[ 255-fftbuf[i] ]);
+			painter1.drawPoint(i,0);
+		}
 	}
 
 	//get/draw the 2D spectrum
@@ -447,13 +470,30 @@ QPoint LineBuf[MAX_SCREENSIZE];
 	m_2DPixmap = m_OverlayPixmap.copy(0,0,w,h);
 
 	QPainter painter2(&m_2DPixmap);
-	//get new scaled fft data
-	m_pSdrInterface->GetScreenIntegerFFTData( h, w,
+	//get new scaled fft data plus any enabled detector traces
+	detectors = m_pSdrInterface->GetFftDetectors();
+	pOutBufs[FFT_TRACE_AVE] = fftbuf;
+	for(t=FFT_TRACE_AVE+1; t<FFT_NUM_TRACES; t++)
+		pOutBufs[t] = (detectors & (1<<t)) ? detbuf[t] : NULL;
+	bool fftoverload = m_pSdrInterface->GetScreenIntegerFFTData( h, w,
 							m_MaxdB,
 							m_MindB,
 							-m_Span/2,
 							m_Span/2,
-							fftbuf );
+							pOutBufs );
+	//draw the detector traces first so the normal trace stays on top
+	for(t=FFT_TRACE_AVE+1; t<FFT_NUM_TRACES; t++)
+	{
+		if(NULL == pOutBufs[t])
+			continue;
+		painter2.setPen( m_TraceColor[t] );
+		for(i=0; i<w; i++)
+		{
+			LineBuf[i].setX(i);
+			LineBuf[i].setY(pOutBufs[t][i]);
+		}
+		painter2.drawPolyline(LineBuf,w);
+	}
 	//draw the 2D spectrum
 	if(m_ADOverLoad || fftoverload)
 	{
@@ -479,6 +519,90 @@ QPoint LineBuf[MAX_SCREENSIZE];
 
 }
 
+//////////////////////////////////////////////////////////////////////
+// Returns true when a new waterfall line should be drawn.
+// Set above 1 by the load governor to thin out waterfall updates.
+//////////////////////////////////////////////////////////////////////
+bool CPlotter::WaterfallLineDue()
+{
+	if(++m_WaterfallCount < m_WaterfallDecimation)
+		return false;
+	m_WaterfallCount = 0;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Called instead of the normal spectrum update when in zoom mode.
+// Both the waterfall and 2D spectrum show the zoom FFT which is
+// centered on the demod frequency and spans the decimated data rate.
+//////////////////////////////////////////////////////////////////////
+void CPlotter::DrawZoom()
+{
+int i;
+int w;
+int h;
+qint32 fftbuf[MAX_SCREENSIZE];
+QPoint LineBuf[MAX_SCREENSIZE];
+qint32 span = m_pSdrInterface->GetZoomSpan();
+qint32 offset = m_pSdrInterface->GetZoomCenterOffset();
+qint32 framecount = m_pSdrInterface->GetZoomFrameCount();
+
+	if( (span != m_ZoomSpan) || (offset != m_ZoomCenterOffset) )
+	{	//demod rate or CW offset changed so redo the frequency scale
+		m_ZoomSpan = span;
+		m_ZoomCenterOffset = offset;
+		DrawOverlay();
+	}
+	if( (framecount == m_ZoomFrameCount) || (m_ZoomSpan <= 0) )
+	{	//no new zoom FFT yet but still need paintEvent to release the next update
+		update();
+		return;
+	}
+	m_ZoomFrameCount = framecount;
+
+	//get/draw the waterfall
+	if(WaterfallLineDue())
+	{
+		w = m_WaterfallPixmap.width();
+		h = m_WaterfallPixmap.height();
+		m_WaterfallPixmap.scroll(0,1,0,0, w, h);
+		QPainter painter1(&m_WaterfallPixmap);
+		m_pSdrInterface->GetScreenIntegerZoomFFTData( 255, w,
+								m_MaxdB,
+								m_MindB,
+								-m_ZoomSpan/2,
+								m_ZoomSpan/2,
+								fftbuf );
+		for(i=0; i<w; i++)
+		{
+			painter1.setPen(m_ColorTbl[ 255-fftbuf[i] ]);
+			painter1.drawPoint(i,0);
+		}
+	}
+
+	//get/draw the 2D spectrum
+	w = m_2DPixmap.width();
+	h = m_2DPixmap.height();
+	m_2DPixmap = m_OverlayPixmap.copy(0,0,w,h);
+	QPainter painter2(&m_2DPixmap);
+	m_pSdrInterface->GetScreenIntegerZoomFFTData( h, w,
+							m_MaxdB,
+							m_MindB,
+							-m_ZoomSpan/2,
+							m_ZoomSpan/2,
+							fftbuf );
+	painter2.setPen( Qt::green );
+	for(i=0; i<w; i++)
+	{
+		LineBuf[i].setX(i);
+		LineBuf[i].setY(fftbuf[i]);
+	}
+	painter2.drawPolyline(LineBuf,w);
+
+	//trigger a new paintEvent
+	update();
+}
+
 //////////////////////////////////////////////////////////////////////
 // Called to draw an overlay bitmap containing grid and text that
 // does not need to be recreated every fft data update.
@@ -613,8 +737,8 @@ QRect rect;
 //////////////////////////////////////////////////////////////////////
 void CPlotter::MakeFrequencyStrs()
 {
-qint64 FreqPerDiv = m_Span/HORZ_DIVS;
-qint64 StartFreq = m_CenterFreq - m_Span/2;
+qint64 FreqPerDiv = DisplaySpan()/HORZ_DIVS;
+qint64 StartFreq = DisplayCenterFreq() - DisplaySpan()/2;
 float freq;
 int i,j;
 int numfractdigits = (int)log10((double)m_FreqUnits);
@@ -652,7 +776,7 @@ int numfractdigits = (int)log10((double)m_FreqUnits);
 			max = j-dp;
 	}
 	//truncate all strings to maximum fractional length
-	StartFreq = m_CenterFreq - m_Span/2;
+	StartFreq = DisplayCenterFreq() - DisplaySpan()/2;
 	for( i=0; i<=HORZ_DIVS; i++)
 	{
 		freq = (float)StartFreq/(float)m_FreqUnits;
@@ -667,8 +791,12 @@ int numfractdigits = (int)log10((double)m_FreqUnits);
 int CPlotter::XfromFreq(qint64 freq)
 {
 float w = m_OverlayPixmap.width();
-float StartFreq = (float)m_CenterFreq - (float)m_Span/2.;
-int x = (int) w * ((float)freq - StartFreq)/(float)m_Span;
+float Span = (float)DisplaySpan();
+float StartFreq = (float)DisplayCenterFreq() - Span/2.;
+int x;
+	if(Span <= 0.0)
+		return 0;
+	x = (int) w * ((float)freq - StartFreq)/Span;
 	if(x<0 )
 		return 0;
 	if(x>(int)w)
@@ -679,8 +807,9 @@ int x = (int) w * ((float)freq - StartFreq)/(float)m_Span;
 qint64 CPlotter::FreqfromX(int x)
 {
 float w = m_OverlayPixmap.width();
-float StartFreq = (float)m_CenterFreq - (float)m_Span/2.;
-qint64 f = (int)(StartFreq + (float)m_Span * (float)x/(float)w );
+float Span = (float)DisplaySpan();
+float StartFreq = (float)DisplayCenterFreq() - Span/2.;
+qint64 f = (int)(StartFreq + Span * (float)x/(float)w );
 	return f;
 }
 
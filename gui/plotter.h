@@ -42,7 +42,9 @@ public:
 	void SetMaxdB(int max){m_MaxdB=max;}
 	void SetADOverload(bool ADOverLoad){m_ADOverLoad = ADOverLoad;m_ADOverloadOneShotCounter=0;}
 	void SetdBStepSize(int stepsz){m_dBStepSize=stepsz;}
+	void SetZoomMode(bool zoom){m_ZoomMode=zoom; m_ZoomSpan=0; m_Size = QSize(0,0);resizeEvent(NULL);}
 	void UpdateOverlay(){DrawOverlay();}
+	void SetWaterfallDecimation(int dec){m_WaterfallDecimation = (dec<1) ? 1 : dec;}
 
 signals:
 	void NewCenterFreq(qint64 f);
@@ -69,6 +71,10 @@ private:
 	   RIGHT
 	};
 	void DrawOverlay();
+	void DrawZoom();
+	bool WaterfallLineDue();
+	qint64 DisplayCenterFreq(){return m_ZoomMode ? (m_DemodCenterFreq+m_ZoomCenterOffset) : m_CenterFreq;}
+	qint32 DisplaySpan(){return m_ZoomMode ? m_ZoomSpan : m_Span;}
 	void MakeFrequencyStrs();
 	int XfromFreq(qint64 freq);
 	qint64 FreqfromX(int x);
@@ -80,11 +86,13 @@ private:
 	QPixmap m_OverlayPixmap;
 	QPixmap m_WaterfallPixmap;
 	QColor m_ColorTbl[256];
+	QColor m_TraceColor[FFT_NUM_TRACES];
 	QSize m_Size;
 	QString m_Str;
 	QString m_HDivText[HORZ_DIVS+1];
 	bool m_Running;
 	bool m_ADOverLoad;
+	bool m_ZoomMode;
 	qint64 m_CenterFreq;
 	qint64 m_DemodCenterFreq;
 	int m_DemodHiCutFreq;
@@ -104,6 +112,11 @@ private:
 	bool m_symetric;
 
 	qint32 m_Span;
+	qint32 m_ZoomSpan;
+	qint32 m_ZoomCenterOffset;
+	qint32 m_ZoomFrameCount;
+	qint32 m_WaterfallDecimation;
+	qint32 m_WaterfallCount;
 	qint32 m_MaxdB;
 	qint32 m_MindB;
 	qint32 m_dBStepSize;
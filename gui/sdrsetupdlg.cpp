@@ -48,6 +48,7 @@ CSdrSetupDlg::CSdrSetupDlg(QWidget *parent, CSdrInterface* pSdrInterface) :
 {
     ui->setupUi(this);
 	m_BandwidthIndex = 0;
+	m_IntFrontEnd = false;
 	m_RfGain = pSdrInterface->GetSdrRfGain();
 	m_RadioType = pSdrInterface->GetRadioType();
 	m_SampleRate = pSdrInterface->GetSdrSampleRate();
@@ -93,6 +94,8 @@ void CSdrSetupDlg::InitDlg()
 	else if(3 == m_BandwidthIndex)
 		ui->radioButtonRate3->setChecked(TRUE);
 
+	ui->checkBoxIntFrontEnd->setChecked(m_IntFrontEnd);
+
 	ui->labelRadioType->setText(m_pSdrInterface->m_DeviceName);
 }
 
@@ -121,6 +124,7 @@ void CSdrSetupDlg::accept()
 		m_BandwidthIndex = 2;
 	else if(ui->radioButtonRate3->isChecked())
 		m_BandwidthIndex = 3;
+	m_IntFrontEnd = ui->checkBoxIntFrontEnd->isChecked();
 
 	QDialog::accept();
 }
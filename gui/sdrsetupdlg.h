@@ -26,6 +26,7 @@ public:
 	void InitDlg();
 	qint32 m_RfGain;
 	qint32 m_BandwidthIndex;
+	bool m_IntFrontEnd;
 
 
 public slots:
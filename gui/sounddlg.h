@@ -24,6 +24,10 @@ public:
 	int GetOutputIndex(){return ui.comboBoxSndOut->currentIndex(); }
 	void SetStereo(bool Stereo){ui.checkBoxStereo->setChecked(Stereo);}
 	bool GetStereo(){return ui.checkBoxStereo->checkState();}
+	void SetLowLatency(bool LowLatency){ui.checkBoxLowLatency->setChecked(LowLatency);}
+	bool GetLowLatency(){return ui.checkBoxLowLatency->checkState();}
+	void SetLatency(int mSec){ui.spinBoxLatency->setValue(mSec);}
+	int GetLatency(){return ui.spinBoxLatency->value();}
 
 public slots:
 
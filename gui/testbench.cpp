@@ -7,6 +7,8 @@
 // History:
 //	2010-12-18  Initial creation MSW
 //	2011-03-27  Initial release
+//	2026-10-19  Added real FFT check against the complex FFT
+//	2026-10-19  Added FM PLL and discriminator benchmark
 //////////////////////////////////////////////////////////////////////
 
 //==========================================================================================
@@ -39,10 +41,21 @@
 //==========================================================================================
 #include "testbench.h"
 #include "ui_testbench.h"
+#include "dsp/fmdemod.h"
+#include "dsp/iir.h"
+#include "dsp/scratcharena.h"
 #include <QDebug>
+#include <QElapsedTimer>
 
 CTestBench* g_pTestBench = NULL;		//pointer to this class is global so everybody can access
 
+#define FMBENCH_RATE 48000.0	//FM benchmark sample rate
+#define FMBENCH_BLOCK 480		//samples per demod call
+#define FMBENCH_BLOCKS 100		//one second of signal
+#define FMBENCH_TONE 1000.0		//modulating tone Hz
+#define FMBENCH_DEV 3000.0		//peak deviation Hz
+#define FMBENCH_MAXDELAY 3.0	//delay search range in samples
+
 #define USE_FILE 0
 //#define FILE_NAME "SSB-7210000Hz_001.wav"
 #define FILE_NAME "sim5.wav"
@@ -88,6 +101,7 @@ CTestBench::CTestBench(QWidget *parent) :
     ui(new Ui::CTestBench)
 {
 	m_Active = false;
+	m_ProbesEnabled = true;
 	m_2DPixmap = QPixmap(0,0);
 	m_OverlayPixmap = QPixmap(0,0);
 	m_Size = QSize(0,0);
@@ -176,6 +190,16 @@ void CTestBench::showEvent(QShowEvent *event)
 	m_pTimer->start(500);		//start up timer
 }
 
+//////////////////////////////////////////////////////////////////////
+// Self Test button handler runs the DSP benchmarks once on request
+//since they take long enough to stall the GUI.
+//////////////////////////////////////////////////////////////////////
+void CTestBench::OnSelfTest()
+{
+	CheckRealFft();
+	BenchFmDemod();
+}
+
 //////////////////////////////////////////////////////////////////////
 // Called by parent to Initialize testbench controls after persistent
 // variables are initialized
@@ -582,7 +606,7 @@ int i;
 //////////////////////////////////////////////////////////////////////
 void CTestBench::DisplayData(int length, TYPECPX* pBuf, double samplerate, int profile)
 {
-	if(!m_Active || (profile!=m_Profile) )
+	if(!m_Active || !m_ProbesEnabled || (profile!=m_Profile) )
 		return;
 	if(m_DisplaySampleRate != samplerate)
 	{
@@ -642,7 +666,7 @@ void CTestBench::DisplayData(int length, TYPECPX* pBuf, double samplerate, int p
 //////////////////////////////////////////////////////////////////////
 void CTestBench::DisplayData(int length, TYPEREAL* pBuf, double samplerate, int profile)
 {
-	if(!m_Active || (profile!=m_Profile) )
+	if(!m_Active || !m_ProbesEnabled || (profile!=m_Profile) )
 		return;
 	if(m_DisplaySampleRate != samplerate)
 	{
@@ -701,7 +725,7 @@ void CTestBench::DisplayData(int length, TYPEREAL* pBuf, double samplerate, int
 //////////////////////////////////////////////////////////////////////
 void CTestBench::DisplayData(int length, TYPEMONO16* pBuf, double samplerate, int profile)
 {
-	if(!m_Active || (profile!=m_Profile) )
+	if(!m_Active || !m_ProbesEnabled || (profile!=m_Profile) )
 		return;
 	if(m_DisplaySampleRate != samplerate)
 	{
@@ -760,7 +784,7 @@ void CTestBench::DisplayData(int length, TYPEMONO16* pBuf, double samplerate, in
 //////////////////////////////////////////////////////////////////////
 void CTestBench::DisplayData(int length, TYPESTEREO16* pBuf, double samplerate, int profile)
 {
-	if(!m_Active || (profile!=m_Profile) )
+	if(!m_Active || !m_ProbesEnabled || (profile!=m_Profile) )
 		return;
 	if(m_DisplaySampleRate != samplerate)
 	{
@@ -905,6 +929,193 @@ void CTestBench::GotTxt(QString Str)
 	ui->textEdit->append(Str);
 }
 
+//////////////////////////////////////////////////////////////////////
+// Checks CFft::FwdRealFFT() and RevRealFFT() against a direct DFT of a
+// real noise block so the reference does not share any FFT code.  Shows
+// the largest errors relative to the largest bin or sample in the debug
+// text box.
+//////////////////////////////////////////////////////////////////////
+void CTestBench::CheckRealFft()
+{
+int i,k;
+	const int n = TEST_FFTSIZE;
+	CFft Fft;
+	Fft.SetFFTParams(n, FALSE, 0.0, 1.0);
+	TYPEREAL* pReal = new TYPEREAL[n];
+	TYPEREAL* pSig = new TYPEREAL[n];
+	TYPECPX* pExp = new TYPECPX[n];
+	TYPECPX* pDft = new TYPECPX[n/2+1];
+	quint32 seed = 12345;
+	for(i=0; i<n; i++)
+	{
+		seed = seed*1103515245 + 12345;
+		pSig[i] = (TYPEREAL)((seed>>16)&0xFFFF)/32768.0 - 1.0;
+		pReal[i] = pSig[i];
+		pExp[i].re = cos(K_2PI*(TYPEREAL)i/(TYPEREAL)n);
+		pExp[i].im = sin(K_2PI*(TYPEREAL)i/(TYPEREAL)n);
+	}
+	//bins 0 to N/2 with the same exp(+j) sign as CFft::FwdFFT()
+	TYPEREAL maxbin = 0.0;
+	for(k=0; k<=n/2; k++)
+	{
+		TYPEREAL re = 0.0;
+		TYPEREAL im = 0.0;
+		for(i=0; i<n; i++)
+		{
+			int j = (i*k) & (n-1);
+			re += pSig[i]*pExp[j].re;
+			im += pSig[i]*pExp[j].im;
+		}
+		pDft[k].re = re;
+		pDft[k].im = im;
+		maxbin = qMax(maxbin, sqrt(re*re + im*im));
+	}
+	//forward, packed as re[0], re[N/2], re[1], im[1] ...
+	Fft.FwdRealFFT(pReal);
+	TYPEREAL fwderr = qMax( fabs(pReal[0]-pDft[0].re), fabs(pReal[1]-pDft[n/2].re) );
+	for(k=1; k<n/2; k++)
+	{
+		fwderr = qMax(fwderr, fabs(pReal[2*k]-pDft[k].re));
+		fwderr = qMax(fwderr, fabs(pReal[2*k+1]-pDft[k].im));
+	}
+	//reverse of the packed DFT gives N/2 times the input
+	pReal[0] = pDft[0].re;
+	pReal[1] = pDft[n/2].re;
+	for(k=1; k<n/2; k++)
+	{
+		pReal[2*k] = pDft[k].re;
+		pReal[2*k+1] = pDft[k].im;
+	}
+	Fft.RevRealFFT(pReal);
+	TYPEREAL reverr = 0.0;
+	TYPEREAL maxsig = 0.0;
+	for(i=0; i<n; i++)
+	{
+		reverr = qMax(reverr, fabs(pReal[i]-0.5*n*pSig[i]));
+		maxsig = qMax(maxsig, fabs(0.5*n*pSig[i]));
+	}
+	GotTxt( QString("Real FFT check N=%1 Fwd err=%2 dB Rev err=%3 dB")
+				.arg(n)
+				.arg(20.0*log10(fwderr/maxbin + 1e-20), 0, 'f', 1)
+				.arg(20.0*log10(reverr/maxsig + 1e-20), 0, 'f', 1) );
+	delete[] pReal;
+	delete[] pSig;
+	delete[] pExp;
+	delete[] pDft;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Finds the delay and gain that best fit pOut to pRef over n samples.
+// Fractional delays use linear interpolation of pRef, which must have
+// FMBENCH_MAXDELAY+1 valid samples before and after the range.
+// Returns the remaining error power relative to the fitted pRef in dB.
+//////////////////////////////////////////////////////////////////////
+static TYPEREAL FitToSource(int n, const TYPEREAL* pOut, const TYPEREAL* pRef,
+							TYPEREAL& Delay, TYPEREAL& Gain)
+{
+	TYPEREAL best = -1.0;
+	TYPEREAL refpwr = 0.0;
+	for(TYPEREAL d=-FMBENCH_MAXDELAY; d<=FMBENCH_MAXDELAY; d+=0.05)
+	{
+		int k = (int)floor(d);
+		TYPEREAL frac = d - (TYPEREAL)k;
+		TYPEREAL sxy = 0.0;
+		TYPEREAL sxx = 0.0;
+		TYPEREAL syy = 0.0;
+		for(int i=0; i<n; i++)
+		{
+			TYPEREAL r = (1.0-frac)*pRef[i-k] + frac*pRef[i-k-1];
+			sxy += pOut[i]*r;
+			sxx += r*r;
+			syy += pOut[i]*pOut[i];
+		}
+		TYPEREAL g = sxy/sxx;
+		TYPEREAL err = syy - g*sxy;
+		if( (best < 0.0) || (err < best) )
+		{
+			best = err;
+			Delay = d;
+			Gain = g;
+			refpwr = sxx;
+		}
+	}
+	return 10.0*log10(best/(Gain*Gain*refpwr) + 1e-30);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Times the CFmDemod PLL and delay line discriminator on a tone
+// modulated carrier and compares both to the source audio after the
+// same 3 kHz voice low pass the demod uses.  The discriminator measures
+// the phase step of each sample so it lines up with the source, while
+// the PLL output lags through its loop response, so both are compared
+// after fitting delay and gain.
+//////////////////////////////////////////////////////////////////////
+void CTestBench::BenchFmDemod()
+{
+int i,b;
+	const int len = FMBENCH_BLOCK*FMBENCH_BLOCKS;
+	CScratchArena Scratch;
+	Scratch.Reserve(CFmDemod::GetScratchBytes(FMBENCH_BLOCK));
+	CFmDemod Pll(FMBENCH_RATE, &Scratch);
+	CFmDemod Disc(FMBENCH_RATE, &Scratch);
+	Pll.SetSquelch(0);
+	Disc.SetSquelch(0);
+	Disc.SetFastDiscriminator(true);
+	CIir VoiceLp;
+	VoiceLp.InitLP(3000.0, 1.0, FMBENCH_RATE);
+	TYPECPX* pIn = new TYPECPX[len];
+	TYPEREAL* pSrc = new TYPEREAL[len];
+	TYPEREAL* pPllOut = new TYPEREAL[len];
+	TYPEREAL* pDiscOut = new TYPEREAL[len];
+	TYPEREAL phase = 0.0;
+	for(i=0; i<len; i++)
+	{
+		pSrc[i] = FMBENCH_DEV*sin(K_2PI*FMBENCH_TONE*(TYPEREAL)i/FMBENCH_RATE);
+		phase += K_2PI*pSrc[i]/FMBENCH_RATE;
+		pIn[i].re = 10000.0*cos(phase);
+		pIn[i].im = 10000.0*sin(phase);
+	}
+	VoiceLp.ProcessFilter(len, pSrc, pSrc);
+	QElapsedTimer timer;
+	timer.start();
+	qint64 tpll = 0;
+	qint64 tdisc = 0;
+	for(b=0; b<len; b+=FMBENCH_BLOCK)
+	{
+		Scratch.Reset();
+		qint64 t0 = timer.nsecsElapsed();
+		Pll.ProcessData(FMBENCH_BLOCK, FMBENCH_DEV*2.0, &pIn[b], &pPllOut[b]);
+		qint64 t1 = timer.nsecsElapsed();
+		Disc.ProcessData(FMBENCH_BLOCK, FMBENCH_DEV*2.0, &pIn[b], &pDiscOut[b]);
+		tpll += t1 - t0;
+		tdisc += timer.nsecsElapsed() - t1;
+	}
+	//compare the second half once the DC filters and PLL have settled
+	int start = len/2;
+	int n = len - start - (int)FMBENCH_MAXDELAY - 1;
+	TYPEREAL PllDelay, PllGain, DiscDelay, DiscGain;
+	TYPEREAL PllErr = FitToSource(n, &pPllOut[start], &pSrc[start], PllDelay, PllGain);
+	TYPEREAL DiscErr = FitToSource(n, &pDiscOut[start], &pSrc[start], DiscDelay, DiscGain);
+	TYPEREAL diff = 0.0;
+	TYPEREAL pwr = 0.0;
+	for(i=start; i<len; i++)
+	{
+		diff += (pPllOut[i]-pDiscOut[i])*(pPllOut[i]-pDiscOut[i]);
+		pwr += pPllOut[i]*pPllOut[i];
+	}
+	GotTxt( QString("FM PLL %1 nS/sample delay=%2 gain=%3 err=%4 dB")
+				.arg((TYPEREAL)tpll/len, 0, 'f', 1)
+				.arg(PllDelay, 0, 'f', 2).arg(fabs(PllGain), 0, 'f', 4).arg(PllErr, 0, 'f', 1) );
+	GotTxt( QString("FM Disc %1 nS/sample delay=%2 gain=%3 err=%4 dB")
+				.arg((TYPEREAL)tdisc/len, 0, 'f', 1)
+				.arg(DiscDelay, 0, 'f', 2).arg(fabs(DiscGain), 0, 'f', 4).arg(DiscErr, 0, 'f', 1) );
+	GotTxt( QString("FM PLL-Disc difference %1 dB").arg(10.0*log10(diff/pwr + 1e-30), 0, 'f', 1) );
+	delete[] pIn;
+	delete[] pSrc;
+	delete[] pPllOut;
+	delete[] pDiscOut;
+}
+
 /////////////////////////////////////////////////////////////////////
 // Status Timer event handler
 /////////////////////////////////////////////////////////////////////
@@ -74,6 +74,7 @@ public:
 
 	void CreateGeneratorSamples(int length, TYPECPX* pBuf, double samplerate);
 	void CreateGeneratorSamples(int length, TYPEREAL* pBuf, double samplerate);
+	bool IsGeneratorOn(){return m_Active && m_GenOn;}
 	// overloaded data display routines
 	void DisplayData(int n, TYPEREAL* pBuf, double samplerate, int profile);
 	void DisplayData(int n, TYPECPX* pBuf, double samplerate, int profile);
@@ -81,6 +82,8 @@ public:
 	void DisplayData(int n, TYPESTEREO16* pBuf, double samplerate, int profile);
 
 	void SendDebugTxt(QString Str){ if(m_Active) emit SendTxt(Str);}
+	//allows the load governor to drop the display probes
+	void SetProbesEnabled(bool enable){m_ProbesEnabled = enable;}
 
 	//Exposed Dialog Class variables for persistant saving/restoring by parent
 	bool m_TimeDisplay;
@@ -125,6 +128,7 @@ public slots:
 	void OnPulsePeriod(int pperiod);
 	void OnSignalPwr(int pwr);
 	void OnNoisePwr(int pwr);
+	void OnSelfTest();	//called by GUI Self Test button
 
 signals:
 	void ResetSignal();		//internal signals from worker thread called functions
@@ -145,6 +149,8 @@ private:
 	void DrawTimeOverlay();
 	void MakeFrequencyStrs();
 	void ChkForTrigger(qint32 sample);
+	void CheckRealFft();
+	void BenchFmDemod();
 	quint64 rdtsctime();
 	QPixmap m_2DPixmap;
 	QPixmap m_OverlayPixmap;
@@ -152,6 +158,7 @@ private:
 	QRect m_Rect;
 	QTimer *m_pTimer;
 	bool m_Active;
+	volatile bool m_ProbesEnabled;
 	qint32 m_Span;
 	qint32 m_MaxdB;
 	qint32 m_MindB;
@@ -0,0 +1,129 @@
+/////////////////////////////////////////////////////////////////////
+// loadgovernor.cpp: implementation of the CLoadGovernor class.
+//
+//	This class measures the time spent processing each I/Q data block
+// against the real time the block represents. If the DSP thread can
+// not keep up, the shed level is raised one step at a time so the
+// caller can drop non essential display work before audio is affected.
+// The level is only lowered again after the load has stayed low for
+// several measurement windows to keep it from toggling.
+//
+// History:
+//	2026-10-19  Initial creation
+//	2026-10-19  Measure busy time in nSec
+/////////////////////////////////////////////////////////////////////
+
+//==========================================================================================
+// + + +   This Software is released under the "Simplified BSD License"  + + +
+//Copyright 2010 Moe Wheatley. All rights reserved.
+//
+//Redistribution and use in source and binary forms, with or without modification, are
+//permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice, this list of
+//	  conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright notice, this list
+//	  of conditions and the following disclaimer in the documentation and/or other materials
+//	  provided with the distribution.
+//
+//THIS SOFTWARE IS PROVIDED BY Moe Wheatley ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Moe Wheatley OR
+//CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//The views and conclusions contained in the software and documentation are those of the
+//authors and should not be interpreted as representing official policies, either expressed
+//or implied, of Moe Wheatley.
+//==========================================================================================
+#include "interface/loadgovernor.h"
+#include "gui/testbench.h"
+
+//////////////////////////////////////////////////////////////////////
+// Local Defines
+//////////////////////////////////////////////////////////////////////
+#define LOAD_WINDOW_TIME 500.0	//mSec of sample time per load measurement
+#define LOAD_HIGH 0.75			//raise shed level above this load
+#define LOAD_LOW 0.45			//lower shed level below this load
+#define LOAD_LOW_WINDOWS 4		//number of low load windows before lowering
+
+/////////////////////////////////////////////////////////////////////
+//   constructor
+/////////////////////////////////////////////////////////////////////
+CLoadGovernor::CLoadGovernor()
+{
+	m_Timer.start();
+	Reset();
+}
+
+/////////////////////////////////////////////////////////////////////
+// Clears measurements and returns to full processing
+/////////////////////////////////////////////////////////////////////
+void CLoadGovernor::Reset()
+{
+	m_BlockStart = m_Timer.nsecsElapsed();
+	m_BusyTime = 0;
+	m_RealTime = 0.0;
+	m_UnderCount = 0;
+	m_ShedLevel = SHED_NONE;
+	m_LoadPercent = 0;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Call at the start of processing a data block
+/////////////////////////////////////////////////////////////////////
+void CLoadGovernor::StartBlock()
+{
+	m_BlockStart = m_Timer.nsecsElapsed();
+}
+
+/////////////////////////////////////////////////////////////////////
+// Call at the end of processing a data block with the number of
+// complex samples in the block and their sample rate.
+// Blocks are only ~10mSec long so the busy time is measured in nSec.
+/////////////////////////////////////////////////////////////////////
+bool CLoadGovernor::EndBlock(int NumSamples, double SampleRate)
+{
+	if(SampleRate <= 0.0)
+		return false;
+	m_BusyTime += (m_Timer.nsecsElapsed() - m_BlockStart);
+	m_RealTime += 1000.0*(double)NumSamples/SampleRate;
+	if(m_RealTime < LOAD_WINDOW_TIME)
+		return false;
+
+	double load = (double)m_BusyTime/(m_RealTime*1.0e6);
+	m_LoadPercent = (qint32)(load*100.0 + 0.5);
+	m_BusyTime = 0;
+	m_RealTime = 0.0;
+
+	qint32 level = m_ShedLevel;
+	if(load > LOAD_HIGH)
+	{
+		m_UnderCount = 0;
+		if(level < SHED_MAX)
+			level++;
+	}
+	else if(load < LOAD_LOW)
+	{
+		if(++m_UnderCount >= LOAD_LOW_WINDOWS)
+		{
+			m_UnderCount = 0;
+			if(level > SHED_NONE)
+				level--;
+		}
+	}
+	else
+	{
+		m_UnderCount = 0;
+	}
+	if(level == m_ShedLevel)
+		return false;
+	m_ShedLevel = level;
+	g_pTestBench->SendDebugTxt( QString("DSP Load=%1% Shed Level=%2").arg(m_LoadPercent).arg(level) );
+	return true;
+}
@@ -0,0 +1,44 @@
+//////////////////////////////////////////////////////////////////////
+// loadgovernor.h: interface for the CLoadGovernor class.
+//
+// History:
+//	2026-10-19  Initial creation
+/////////////////////////////////////////////////////////////////////
+#ifndef LOADGOVERNOR_H
+#define LOADGOVERNOR_H
+
+#include <QElapsedTimer>
+
+class CLoadGovernor
+{
+public:
+	CLoadGovernor();
+
+	//load shedding levels in the order work is dropped
+	enum eShedLevel
+	{
+		SHED_NONE,			//everything running
+		SHED_DISPLAYRATE,	//display update rate halved
+		SHED_AVERAGING,		//display FFT averaging turned off
+		SHED_WATERFALL,		//waterfall lines decimated
+		SHED_TESTBENCH,		//testbench probes disabled
+		SHED_MAX = SHED_TESTBENCH
+	};
+
+	void Reset();
+	void StartBlock();
+	bool EndBlock(int NumSamples, double SampleRate);	//returns true if shed level changed
+	qint32 GetShedLevel(){return m_ShedLevel;}
+	qint32 GetLoadPercent(){return m_LoadPercent;}
+
+private:
+	QElapsedTimer m_Timer;
+	qint64 m_BlockStart;
+	qint64 m_BusyTime;		//accumulated processing time in nSec
+	double m_RealTime;		//accumulated sample time in mSec
+	qint32 m_UnderCount;
+	volatile qint32 m_ShedLevel;
+	volatile qint32 m_LoadPercent;
+};
+
+#endif // LOADGOVERNOR_H
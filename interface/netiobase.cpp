@@ -61,6 +61,9 @@
 
 #define RXQUEUE_SIZE 256		//queue size(keep power of 2)
 
+#define DATA_SCALE_24 (1.0/256.0)	//scales 24 bit data to +-32768 range same as 16 bit data
+#define DATA_SCALE_16 1.0
+
 
 
 /*---------------------------------------------------------------------------*/
@@ -138,15 +141,15 @@ qDebug()<<"Start I/O";
 
 	if(!m_pUdpRxQueue)
 	{	//create 2D array for FIFO
-		m_pUdpRxQueue = new double* [RXQUEUE_SIZE];		//create array of pointers to each row
+		m_pUdpRxQueue = new qint32* [RXQUEUE_SIZE];		//create array of pointers to each row
 		for(int i=0; i<RXQUEUE_SIZE; i++)
 		{	//now allocate memory for each row
-			m_pUdpRxQueue[i] = new double[PKT_LENGTH_24];	//enough for max packet data length
+			m_pUdpRxQueue[i] = new qint32[PKT_LENGTH_24];	//enough for max packet data length
 		}
 	}
 	for(int i=0; i<RXQUEUE_SIZE; i++)
 		for(int j=0; j<PKT_LENGTH_24; j++)
-			m_pUdpRxQueue[i][j] = 0.0;
+			m_pUdpRxQueue[i][j] = 0;
 
 	m_RxQueueHead = 0;
 	m_RxQueueTail = 0;
@@ -460,7 +463,7 @@ CNetIOBase* pParent = (CNetIOBase*)m_pParent;
 
 
 //////////////////////////////////////////////////////////////////////////
-// Called when UDP Rx data is available then converts to float and puts in FIFO
+// Called when UDP Rx data is available then unpacks to integers and puts in FIFO
 //////////////////////////////////////////////////////////////////////////
 void CUdpThread::OnreadyRead()
 {
@@ -499,7 +502,7 @@ CNetIOBase* pParent = (CNetIOBase*)m_pParent;
 				data.bytes.b1 = Buf[i];		//combine 3 bytes into 32 bit signed int
 				data.bytes.b2 = Buf[i+1];
 				data.bytes.b3 = Buf[i+2];
-				pParent->m_pUdpRxQueue[pParent->m_RxQueueHead][j] = (double)data.all/65536.0;	//scale to be +-32768 range same as 16 bit data
+				pParent->m_pUdpRxQueue[pParent->m_RxQueueHead][j] = data.all>>8;	//sign extended 24 bit value
 			}
 		}
 		else if(PKT_LENGTH_16 == size)
@@ -523,7 +526,7 @@ CNetIOBase* pParent = (CNetIOBase*)m_pParent;
 			{
 				seq.bytes.b0 = Buf[i+0];	//use 'seq' as temp variable to combine bytes into short int
 				seq.bytes.b1 = Buf[i+1];
-				pParent->m_pUdpRxQueue[pParent->m_RxQueueHead][j] = (double)seq.sall;
+				pParent->m_pUdpRxQueue[pParent->m_RxQueueHead][j] = seq.sall;
 			}
 		}
 		pParent->m_RxQueueHead++;
@@ -580,7 +583,7 @@ CNetIOBase* pParent;
 		{
 			while(pParent->m_RxQueueHead != pParent->m_RxQueueTail)
 			{
-				pParent->ProcessIQData( &pParent->m_pUdpRxQueue[pParent->m_RxQueueTail][0], (PKT_LENGTH_24-4)/3 );
+				pParent->ProcessIQData( &pParent->m_pUdpRxQueue[pParent->m_RxQueueTail][0], (PKT_LENGTH_24-4)/3, DATA_SCALE_24 );
 				pParent->m_RxQueueTail++;
 				pParent->m_RxQueueTail &= (RXQUEUE_SIZE-1);
 			}
@@ -590,7 +593,7 @@ CNetIOBase* pParent;
 		{
 			while(pParent->m_RxQueueHead != pParent->m_RxQueueTail)
 			{
-				pParent->ProcessIQData( &pParent->m_pUdpRxQueue[pParent->m_RxQueueTail][0], (PKT_LENGTH_16-4)/2 );
+				pParent->ProcessIQData( &pParent->m_pUdpRxQueue[pParent->m_RxQueueTail][0], (PKT_LENGTH_16-4)/2, DATA_SCALE_16 );
 				pParent->m_RxQueueTail++;
 				pParent->m_RxQueueTail &= (RXQUEUE_SIZE-1);
 			}
@@ -604,7 +607,7 @@ void CIQDataThread::FileTest()
 {
 tBtoL4 tmp;
 char buf[16384];
-double fBuf[1024];
+qint32 iBuf[1024];
 CNetIOBase* pParent;
 	pParent = (CNetIOBase*)m_pParent;
 	while(!m_File.atEnd())
@@ -618,8 +621,8 @@ CNetIOBase* pParent;
 			tmp.bytes.b1 = buf[j++];
 			tmp.bytes.b2 = buf[j++];
 			tmp.bytes.b3 = buf[j++];
-			fBuf[i] = (double)(tmp.all/65536);
+			iBuf[i] = tmp.all>>8;
 		}
-		pParent->ProcessIQData( fBuf, 1024 );
+		pParent->ProcessIQData( iBuf, 1024, DATA_SCALE_24 );
 	}
 }
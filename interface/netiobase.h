@@ -139,7 +139,9 @@ public:
 	//stub virtual function gets implemented by specific device sub class implementation
 	virtual void ParseAscpMsg( CAscpMsg*){}	//implement to decode all the command/status messages
 	virtual void SendIOStatus(int ){}		//implement to process IO status/error changes
-	virtual void ProcessIQData( double* , int ){}//implement to process the IQ data messages from the radio
+	//implement to process the IQ data messages from the radio
+	//data is raw interleaved I/Q integers, multiply by the scale for the +-32768 range
+	virtual void ProcessIQData( qint32* , int , double ){}
 
 	void StartIO();	//starts IO threads
 	void StopIO();	//stops IO threads
@@ -156,7 +158,7 @@ public:
 	int m_RxQueueTail;
 	int m_MissedPackets;
 	quint16 m_Port;
-	double **m_pUdpRxQueue;
+	qint32 **m_pUdpRxQueue;
 	QHostAddress m_IPAdr;
 	QWaitCondition m_QWaitFifoData;
 	QMutex m_TcpMutex;
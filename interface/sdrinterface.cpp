@@ -10,6 +10,7 @@
 //	2010-09-15  Initial creation MSW
 //	2011-03-27  Initial release
 //	2011-04-16  Added Frequency range logic for optional down converter modules
+//	2026-10-19  Added NCO only tuning inside the current span
 /////////////////////////////////////////////////////////////////////
 
 //==========================================================================================
@@ -47,6 +48,14 @@
 #define SPUR_CAL_MAXSAMPLES 300000
 #define MAX_SAMPLERATES 4
 
+#define FFT_PEAKHOLD_DECAY 0.5	//dB per FFT frame the peak hold trace decays
+#define FFT_MINHOLD_DECAY 0.5	//dB per FFT frame the min hold trace rises
+#define FFT_RMS_AVE 20			//number of FFT frames in the RMS power average
+
+#define MAX_IQ_LENGTH 1024		//largest number of values passed to ProcessIQData()
+
+#define TUNE_SPAN_FRACTION 0.8	//part of the sample rate TuneFreq() uses without the radio
+
 //Tables to get various parameters based on the gui sdrsetup samplerate index value
 const quint32 SDRIQ_MAXBW[MAX_SAMPLERATES] =
 {
@@ -120,6 +129,7 @@ const double SDRIP_SAMPLERATE[MAX_SAMPLERATES] =
 CSdrInterface::CSdrInterface()
 {
 	m_Running = false;
+	m_IntFrontEnd = false;
 	m_BootRev = 0.0;
 	m_AppRev = 0.0;
 	m_FftBufPos = 0;
@@ -133,7 +143,8 @@ CSdrInterface::CSdrInterface()
 	m_BandwidthIndex = -1;
 	m_RadioType = SDR14;
 	m_FftSize = 4096;
-	m_DisplaySkipCounter = 0;
+	m_ZoomFftSize = 0;
+	m_FftFrameCount = 0;
 	m_NCOSpurOffsetI = 0.0;
 	m_NCOSpurOffsetQ = 0.0;
 	m_MaxDisplayRate = 10;
@@ -146,7 +157,9 @@ CSdrInterface::CSdrInterface()
 	m_ScreenUpateFinished = TRUE;
 	SetFftSize(4096);
 	SetFftAve(1);
+	SetFftDetectors(0);
 	m_pSoundCardOut = new CSoundOut(this);
+	m_pSoundCardOut->SetScratchArena(m_Demodulator.GetScratchArena());
 	m_Status = NOT_CONNECTED;
 	m_ChannelMode = CI_RX_CHAN_SETUP_SINGLE_1;	//default channel settings for NetSDR
 	m_Channel = CI_RX_CHAN_1;
@@ -588,11 +601,14 @@ void CSdrInterface::StartSdr()
 			break;
 	}
 	SetSdrRfGain(m_RfGain);
+	m_LoadGovernor.Reset();
+	ApplyLoadShedding();
 	m_ScreenUpateFinished = TRUE;
 	m_KeepAliveCounter = 0;
 	//setup and start soundcard output
 	if(!m_pSoundCardOut->Start(m_SoundOutIndex, m_StereoOut, m_Demodulator.GetOutputRate(), false) )
 		SendIOStatus(ERROR);
+	UpdateScratchSize();
 //qDebug()<<"SR="<<m_SampleRate;
 }
 
@@ -644,6 +660,7 @@ void CSdrInterface::SetSdrRfGain(qint32 gain)
 						FALSE,
 						m_GainCalibrationOffset-m_RfGain,
 						m_SampleRate);
+	m_Demodulator.SetZoomFftSize(m_ZoomFftSize, m_GainCalibrationOffset-m_RfGain);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -654,17 +671,8 @@ quint64 CSdrInterface::SetRxFreq(quint64 freq)
 	if(NOT_CONNECTED == m_Status)	//just return if not conencted to sdr
 		return freq;
 
-	//clamp to range of receiver and any options
 //qDebug()<<"F = "<<freq;
-	if(freq > m_OptionFrequencyRangeMax)	//if greater than max range
-		freq = m_OptionFrequencyRangeMax;
-	if(	(freq > m_BaseFrequencyRangeMax) && ( freq < m_OptionFrequencyRangeMin) )	//if in invalid region
-	{
-		if(	freq > m_CurrentFrequency)	//if last freq lower then go to converter range bottom
-			freq = m_OptionFrequencyRangeMin;
-		else
-			freq = m_BaseFrequencyRangeMax; //else last freq higher then go to base range top
-	}
+	freq = ClampRxFreq(freq);
 	m_CurrentFrequency = freq;
 
 	m_TxMsg.InitTxMsg(TYPE_HOST_SET_CITEM);
@@ -686,6 +694,53 @@ quint64 CSdrInterface::SetRxFreq(quint64 freq)
 	return freq;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Clamps freq to range of receiver and any options
+///////////////////////////////////////////////////////////////////////////////
+quint64 CSdrInterface::ClampRxFreq(quint64 freq)
+{
+	if(freq > m_OptionFrequencyRangeMax)	//if greater than max range
+		freq = m_OptionFrequencyRangeMax;
+	if(	(freq > m_BaseFrequencyRangeMax) && ( freq < m_OptionFrequencyRangeMin) )	//if in invalid region
+	{
+		if(	freq > m_CurrentFrequency)	//if last freq lower then go to converter range bottom
+			freq = m_OptionFrequencyRangeMin;
+		else
+			freq = m_BaseFrequencyRangeMax; //else last freq higher then go to base range top
+	}
+	return freq;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Tunes the demodulator to freq.  If freq is within MaxOffset of the
+// radio center frequency only the demod NCO is moved, which takes effect
+// on the next DSP block and keeps its phase.  Otherwise the radio is
+// sent a new center frequency of freq.
+// Returns the tuned frequency after any range clamping.  GetRxFreq()
+// returns the radio center frequency.
+///////////////////////////////////////////////////////////////////////////////
+quint64 CSdrInterface::TuneFreq(quint64 freq, qint32 MaxOffset)
+{
+	if(NOT_CONNECTED == m_Status)
+	{	//radio gets its frequency when started so just keep it
+		m_CurrentFrequency = freq;
+		m_Demodulator.SetDemodFreq(0.0);
+		return freq;
+	}
+	freq = ClampRxFreq(freq);
+	qint32 maxspan = (qint32)(TUNE_SPAN_FRACTION*m_SampleRate/2.0);
+	if(MaxOffset > maxspan)
+		MaxOffset = maxspan;
+	qint64 offset = (qint64)m_CurrentFrequency - (qint64)freq;
+	if( (offset > MaxOffset) || (offset < -MaxOffset) )
+	{
+		SetRxFreq(freq);
+		offset = 0;
+	}
+	m_Demodulator.SetDemodFreq((TYPEREAL)offset);
+	return freq;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Send Keep alive message to SDR
 ///////////////////////////////////////////////////////////////////////////////
@@ -752,6 +807,7 @@ void CSdrInterface::SetSdrBandwidthIndex(qint32 bwindex)
 	SetMaxDisplayRate(m_MaxDisplayRate);
 	m_Demodulator.SetInputSampleRate(m_SampleRate);
 	m_pSoundCardOut->ChangeUserDataRate( m_Demodulator.GetOutputRate());
+	UpdateScratchSize();
 qDebug()<<"UsrDataRate="<< m_Demodulator.GetOutputRate();
 }
 
@@ -762,6 +818,25 @@ void CSdrInterface::SetDemod(int Mode, tDemodInfo CurrentDemodInfo)
 {
 	m_Demodulator.SetDemod(Mode, CurrentDemodInfo );
 	m_pSoundCardOut->ChangeUserDataRate( m_Demodulator.GetOutputRate());
+	UpdateScratchSize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sizes the DSP scratch arena for the largest I/Q block with the current
+// rates and demod mode.  The audio buffer and the converted I/Q block are
+// held while the demodulator and then the soundcard resampler take their
+// buffers.
+///////////////////////////////////////////////////////////////////////////////
+void CSdrInterface::UpdateScratchSize()
+{
+	int n = m_Demodulator.GetMaxOutputLength(MAX_IQ_LENGTH/2);
+	int bytes = m_Demodulator.GetScratchBytes();
+	int sndbytes = m_pSoundCardOut->GetScratchBytes(n);
+	if(sndbytes > bytes)
+		bytes = sndbytes;
+	bytes += CScratchArena::AlignedSize(n*sizeof(TYPECPX));
+	bytes += CScratchArena::AlignedSize(MAX_IQ_LENGTH*sizeof(double));
+	m_Demodulator.GetScratchArena()->Reserve(bytes);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -773,6 +848,9 @@ void CSdrInterface::SetupNoiseProc(tNoiseProcdInfo* pNoiseProcSettings)
 							  pNoiseProcSettings->NBThreshold,
 							  pNoiseProcSettings->NBWidth,
 							  m_SampleRate);
+	m_Demodulator.SetupNoiseReduction( pNoiseProcSettings->NROn,
+									   pNoiseProcSettings->NRLevel,
+									   pNoiseProcSettings->NotchOn);
 }
 
 
@@ -782,7 +860,40 @@ void CSdrInterface::SetupNoiseProc(tNoiseProcdInfo* pNoiseProcSettings)
 void CSdrInterface::SetFftAve(qint32 ave)
 {
 	m_FftAve = ave;
-	m_Fft.SetFFTAve(ave);
+	if(m_LoadGovernor.GetShedLevel() >= CLoadGovernor::SHED_AVERAGING)
+		m_Fft.SetFFTAve(1);
+	else
+		m_Fft.SetFFTAve(ave);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//Apply the load governor shed level to the display FFT averaging and
+//testbench probes.  Called from the GUI thread when it sees the shed
+//level change so SetFftAve() is never called from the DSP thread.
+///////////////////////////////////////////////////////////////////////////////
+void CSdrInterface::ApplyLoadShedding()
+{
+	qint32 level = m_LoadGovernor.GetShedLevel();
+	SetFftAve(m_FftAve);
+	g_pTestBench->SetProbesEnabled(level < CLoadGovernor::SHED_TESTBENCH);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//Set zoom spectrum FFT size(0 turns off the zoom FFT)
+///////////////////////////////////////////////////////////////////////////////
+void CSdrInterface::SetZoomFftSize(qint32 size)
+{
+	m_ZoomFftSize = size;
+	m_Demodulator.SetZoomFftSize(m_ZoomFftSize, m_GainCalibrationOffset-m_RfGain);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//Set Display FFT extra detector traces(OR of FFT_DETECT_xxx bits)
+///////////////////////////////////////////////////////////////////////////////
+void CSdrInterface::SetFftDetectors(qint32 detectormask)
+{
+	m_FftDetectors = detectormask;
+	m_Fft.SetFFTDetectors(detectormask, FFT_PEAKHOLD_DECAY, FFT_MINHOLD_DECAY, FFT_RMS_AVE);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -849,8 +960,8 @@ qDebug()<<"NCO Cal Done";
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Get FFT data formated for the GUI screen display.  Call it after getting
-// the NewFftData() signal.
+// Get FFT data formated for the GUI screen display.  Call it when
+// GetFftFrameCount() has changed.
 ///////////////////////////////////////////////////////////////////////////////
 bool CSdrInterface::GetScreenIntegerFFTData(qint32 MaxHeight, qint32 MaxWidth,
 								double MaxdB, double MindB,
@@ -867,56 +978,119 @@ bool CSdrInterface::GetScreenIntegerFFTData(qint32 MaxHeight, qint32 MaxWidth,
 
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Get FFT data for several display traces at once(see CFft for OutBufs[] usage).
+///////////////////////////////////////////////////////////////////////////////
+bool CSdrInterface::GetScreenIntegerFFTData(qint32 MaxHeight, qint32 MaxWidth,
+								double MaxdB, double MindB,
+								qint32 StartFreq, qint32 StopFreq,
+								qint32* OutBufs[FFT_NUM_TRACES] )
+{
+	return m_Fft.GetScreenIntegerFFTData( MaxHeight,
+								   MaxWidth,
+								  MaxdB,
+								  MindB,
+								  StartFreq,
+								  StopFreq,
+								  OutBufs);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Called by worker thread with new I/Q data fom the SDR.
 //  This thread is what is used to perform all the DSP functions
 // pIQData is ptr to complex I/Q double samples.  (order is I then Q)
 // Length is the number of doubles in pIQData. (2x the number of data samples)
-// emits "NewFftData()" when it accumulates an entire FFT length of samples
-// and the display update time is ready
+// Performs a display FFT when it accumulates an entire FFT length of samples
+// and the GUI has finished drawing the previous one(ScreenUpdateDone()).
+// The GUI display timer polls GetFftFrameCount() so no events are queued.
 ///////////////////////////////////////////////////////////////////////////////
-void CSdrInterface::ProcessIQData( double* pIQData, int Length)
+void CSdrInterface::ProcessIQData( qint32* pIQData, int Length, double Scale)
 {
 	if(!m_Running)	//ignor any incoming data if not running
 		return;
+	m_LoadGovernor.StartBlock();
+	//temporary buffers for this block come from the scratch arena
+	CScratchArena* pScratch = m_Demodulator.GetScratchArena();
+	pScratch->Reset();
+	TYPECPX* SoundBuf = pScratch->Alloc<TYPECPX>(m_Demodulator.GetMaxOutputLength(Length/2));
+	int n;
+	if( m_IntFrontEnd && !m_NcoSpurCalActive && !m_NoiseProc.IsBlankerOn() &&
+		!g_pTestBench->IsGeneratorOn() && m_Demodulator.HasIntFrontEnd() )
+	{	//nothing changes the full rate data so the demodulator can tune and
+		//decimate the integers directly and only the display needs floating point
+		PutInDisplayBuf(pIQData, Length, Scale);
+		if(m_StereoOut)
+		{
+			n = m_Demodulator.ProcessData(Length/2, pIQData, Scale, SoundBuf);
+			PutAudio(n, SoundBuf);
+		}
+		else
+		{
+			n = m_Demodulator.ProcessData(Length/2, pIQData, Scale, (TYPEREAL*)SoundBuf);
+			PutAudio(n, (TYPEREAL*)SoundBuf);
+		}
+	}
+	else
+	{
+		double* pData = pScratch->Alloc<double>(Length);
+		for(int i=0; i<Length; i++)
+			pData[i] = Scale*(double)pIQData[i];
+		g_pTestBench->CreateGeneratorSamples(Length/2, (TYPECPX*)pData, m_SampleRate);
+		m_NoiseProc.ProcessBlanker(Length/2, (TYPECPX*)pData, (TYPECPX*)pData);
+
+		if(m_NcoSpurCalActive)	//if performing NCO spur calibration
+			NcoSpurCalibrate(pData, Length);
+		PutInDisplayBuf(pData, Length, 1.0);
+		if(m_StereoOut)
+		{
+			n = m_Demodulator.ProcessData(Length/2, (TYPECPX*)pData, SoundBuf);
+			PutAudio(n, SoundBuf);
+		}
+		else
+		{
+			n = m_Demodulator.ProcessData(Length/2, (TYPECPX*)pData, (TYPEREAL*)SoundBuf);
+			PutAudio(n, (TYPEREAL*)SoundBuf);
+		}
+	}
+	m_LoadGovernor.EndBlock(Length/2, m_SampleRate);	//GUI polls for shed level changes
+}
 
-	g_pTestBench->CreateGeneratorSamples(Length/2, (TYPECPX*)pIQData, m_SampleRate);
-	m_NoiseProc.ProcessBlanker(Length/2, (TYPECPX*)pIQData, (TYPECPX*)pIQData);
+///////////////////////////////////////////////////////////////////////////////
+// Sends demodulator output to the soundcard.  Squelched output is sent
+// as silence so the resampler filtering is skipped.
+///////////////////////////////////////////////////////////////////////////////
+template <class T>
+void CSdrInterface::PutAudio(int Length, T* pData)
+{
+	if(m_Demodulator.IsAudioGated())
+		m_pSoundCardOut->PutOutSilence(Length);
+	else
+		m_pSoundCardOut->PutOutQueue(Length, pData);
+}
 
-	if(m_NcoSpurCalActive)	//if performing NCO spur calibration
-		NcoSpurCalibrate(pIQData, Length);
-	//accumulate samples into m_DataBuf until have enough to perform an FFT
+///////////////////////////////////////////////////////////////////////////////
+// Accumulates I/Q samples times Scale into m_DataBuf until there are
+// enough to perform a display FFT.  A new frame is only started once the
+// screen has taken the last one so no time is spent converting samples
+// that would be thrown away.
+///////////////////////////////////////////////////////////////////////////////
+template <class T>
+void CSdrInterface::PutInDisplayBuf(const T* pData, int Length, double Scale)
+{
 	for(int i=0; i<Length; i++)
 	{
+		if( (0==m_FftBufPos) && !m_ScreenUpateFinished )
+			return;
 		if(m_FftBufPos&1)	//apply I/Q DC offset correction to all samples
-			m_DataBuf[m_FftBufPos++] = pIQData[i] - m_NCOSpurOffsetQ;
+			m_DataBuf[m_FftBufPos++] = Scale*(double)pData[i] - m_NCOSpurOffsetQ;
 		else
-			m_DataBuf[m_FftBufPos++] = pIQData[i] - m_NCOSpurOffsetI;
+			m_DataBuf[m_FftBufPos++] = Scale*(double)pData[i] - m_NCOSpurOffsetI;
 		if(m_FftBufPos >= (m_FftSize*2) )
 		{
 			m_FftBufPos = 0;
-			if(++m_DisplaySkipCounter >= m_DisplaySkipValue )
-			{
-				m_DisplaySkipCounter = 0;
-				if(m_ScreenUpateFinished)
-				{
-					m_Fft.PutInDisplayFFT(m_FftSize, (TYPECPX*)m_DataBuf);
-					m_ScreenUpateFinished = FALSE;
-					emit NewFftData();
-				}
-			}
+			m_Fft.PutInDisplayFFT(m_FftSize, (TYPECPX*)m_DataBuf);
+			m_ScreenUpateFinished = FALSE;
+			m_FftFrameCount++;
 		}
 	}
-	TYPECPX SoundBuf[8192];
-	int n;
-	if(m_StereoOut)
-	{
-		n = m_Demodulator.ProcessData(Length/2, (TYPECPX*)pIQData, SoundBuf);
-		m_pSoundCardOut->PutOutQueue(n, SoundBuf);
-	}
-	else
-	{
-		n = m_Demodulator.ProcessData(Length/2, (TYPECPX*)pIQData, (TYPEREAL*)SoundBuf);
-		m_pSoundCardOut->PutOutQueue(n, (TYPEREAL*)SoundBuf);
-	}
 }
@@ -16,6 +16,7 @@
 #include "dsp/noiseproc.h"
 #include "interface/soundout.h"
 #include "interface/protocoldefs.h"
+#include "interface/loadgovernor.h"
 
 
 /////////////////////////////////////////////////////////////////////
@@ -56,7 +57,7 @@ public:
 	//called by TCP thread with new msg from radio to parse
 	void ParseAscpMsg(CAscpMsg *pMsg);
 	//called by IQData thread with new I/Q data to process
-	virtual void ProcessIQData( double* pIQData, int Length);
+	virtual void ProcessIQData( qint32* pIQData, int Length, double Scale);
 
 	void StartSdr();
 	void StopSdr();
@@ -64,7 +65,12 @@ public:
 									double MaxdB, double MindB,
 									qint32 StartFreq, qint32 StopFreq,
 									qint32* OutBuf );
+	bool GetScreenIntegerFFTData(qint32 MaxHeight, qint32 MaxWidth,
+									double MaxdB, double MindB,
+									qint32 StartFreq, qint32 StopFreq,
+									qint32* OutBufs[FFT_NUM_TRACES] );
 	void ScreenUpdateDone(){m_ScreenUpateFinished = TRUE;}
+	qint32 GetFftFrameCount(){return m_FftFrameCount;}
 	void KeepAlive();
 	void ManageNCOSpurOffsets( eNCOSPURCMD cmd, double* pNCONullValueI,  double* pNCONullValueQ);
 	void SetRx2Parameters(double Rx2Gain, double Rx2Phase);
@@ -73,6 +79,9 @@ public:
 	void GetSdrInfo();
 	void ReqStatus();
 	quint64 SetRxFreq(quint64 freq);
+	//tunes with the demod NCO if within MaxOffset Hz of the radio center
+	quint64 TuneFreq(quint64 freq, qint32 MaxOffset);
+	quint64 GetRxFreq(){return m_CurrentFrequency;}	//radio center frequency
 
 	//bunch of public members containing sdr related information and data
 	QString m_DeviceName;
@@ -88,7 +97,10 @@ public:
 				{ m_pSoundCardOut->Stop(); m_SoundInIndex = SoundInIndex;
 					m_SoundOutIndex = SoundOutIndex;  m_StereoOut = StereoOut;}
 
-	int GetRateError(){return m_pSoundCardOut->GetRateError();}
+	void SetSoundLatency(bool LowLatency, qint32 mSec){m_pSoundCardOut->SetLatencyMode(LowLatency, mSec);}
+	//tune and decimate the raw radio integers when nothing else needs full rate data
+	void SetIntFrontEnd(bool On){m_IntFrontEnd = On;}
+	void GetSoundStats(tSoundStats* pStats){m_pSoundCardOut->GetStats(pStats);}
 	void SetVolume(qint32 vol){ m_pSoundCardOut->SetVolume(vol); }
 
 	void SetChannelMode(qint32 channelmode);
@@ -106,12 +118,34 @@ public:
 	void SetFftAve(qint32 ave);
 	quint32 GetSdrFftAve(){return m_FftAve;}
 
+	void SetFftDetectors(qint32 detectormask);
+	qint32 GetFftDetectors(){return m_FftDetectors;}
+
+	//zoom spectrum(high resolution FFT of the decimated demod data)
+	void SetZoomFftSize(qint32 size);
+	qint32 GetZoomFftSize(){return m_ZoomFftSize;}
+	qint32 GetZoomSpan(){return (qint32)m_Demodulator.GetZoomSampleRate();}
+	qint32 GetZoomCenterOffset(){return (qint32)m_Demodulator.GetZoomCenterOffset();}
+	qint32 GetZoomFrameCount(){return m_Demodulator.GetZoomFrameCount();}
+	bool GetScreenIntegerZoomFFTData(qint32 MaxHeight, qint32 MaxWidth,
+									double MaxdB, double MindB,
+									qint32 StartFreq, qint32 StopFreq,
+									qint32* OutBuf )
+			{ return m_Demodulator.GetScreenIntegerZoomFFTData(MaxHeight, MaxWidth,
+									MaxdB, MindB, StartFreq, StopFreq, OutBuf); }
+
 	qint32 GetMaxBWFromIndex(qint32 index);
 	double GetSampleRateFromIndex(qint32 index);
 
-	void SetMaxDisplayRate(int updatespersec){m_MaxDisplayRate = updatespersec;
-							m_DisplaySkipValue = m_SampleRate/(m_FftSize*m_MaxDisplayRate);
-							m_DisplaySkipCounter = 0; }
+	//display rate is paced by the GUI display timer, FFT's are only done on request
+	void SetMaxDisplayRate(int updatespersec){m_MaxDisplayRate = updatespersec;}
+	qint32 GetMaxDisplayRate(){return m_MaxDisplayRate;}
+
+	//DSP thread load measurement and display work shedding level
+	qint32 GetLoadShedLevel(){return m_LoadGovernor.GetShedLevel();}
+	void ApplyLoadShedding();
+	qint32 GetDspLoad(){return m_LoadGovernor.GetLoadPercent();}
+	qint32 GetSquelchGatedPercent(){return m_Demodulator.GetGatedPercent();}
 
 	void SetDemod(int Mode, tDemodInfo CurrentDemodInfo);
 	void SetDemodFreq(qint64 Freq){m_Demodulator.SetDemodFreq((TYPEREAL)Freq);}
@@ -125,23 +159,28 @@ public:
 signals:
 	void NewStatus(int status);		//emitted when sdr status changes
 	void NewInfoData();				//emitted when sdr information is received after GetSdrInfo()
-	void NewFftData();				//emitted when new FFT data is available
 	void FreqChange(int freq);	//emitted if requested frequency has been clamped by radio
 
 private:
 	void SendAck(quint8 chan);
 	void Start6620Download();
 	void NcoSpurCalibrate(double* pData, qint32 length);
+	void UpdateScratchSize();
+	template <class T> void PutInDisplayBuf(const T* pData, int Length, double Scale);
+	template <class T> void PutAudio(int Length, T* pData);
+	quint64 ClampRxFreq(quint64 freq);
 
 
 	bool m_Running;
 	bool m_ScreenUpateFinished;
 	bool m_StereoOut;
+	bool m_IntFrontEnd;
 	qint32 m_BandwidthIndex;
-	qint32 m_DisplaySkipCounter;
-	qint32 m_DisplaySkipValue;
+	volatile qint32 m_FftFrameCount;
 	qint32 m_FftSize;
 	qint32 m_FftAve;
+	qint32 m_FftDetectors;
+	qint32 m_ZoomFftSize;
 	qint32 m_FftBufPos;
 	qint32 m_KeepAliveCounter;
 	qint32 m_MaxBandwidth;
@@ -173,6 +212,7 @@ private:
 	CFft m_Fft;
 	CDemodulator m_Demodulator;
 	CNoiseProc m_NoiseProc;
+	CLoadGovernor m_LoadGovernor;
 	CSoundOut* m_pSoundCardOut;
 
 CIir m_Iir;
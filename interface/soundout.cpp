@@ -5,10 +5,16 @@
 // A fractional resampler is used to convert the users input rate to
 // the sound card rate and also perform frequency lock between the
 // two clock domains.
+//	The frequency lock is a PI loop that holds the output queue at a
+// target fill level by trimming the resampler ratio every block. In low
+// latency mode the target is a few tens of mSec and the loop is faster.
 //
 // History:
 //	2010-09-15  Initial creation MSW
 //	2011-03-27  Initial release
+//	2026-10-19  Added low latency mode and PI rate control loop
+//	2026-10-19  Added PutOutSilence() for squelched audio
+//	2026-10-19  Data rate change flushes the queues from the sound thread
 /////////////////////////////////////////////////////////////////////
 
 //==========================================================================================
@@ -44,12 +50,16 @@
 #include "interface/sdrinterface.h"
 #include <QDebug>
 #include <math.h>
+#include <string.h>
 
 #define SOUNDCARD_RATE 48000	//output soundcard sample rate
 //#define SOUNDCARD_RATE 44100
 
-#define FILTERQLEVEL_ALPHA 0.001
-#define P_GAIN 2.38e-7		//Proportional gain
+#define NORMAL_LOOP_BW 0.01		//rate control loop natural frequency in Hz
+#define LOWLAT_LOOP_BW 0.1
+#define LOOP_ZETA 0.707			//rate control loop damping factor
+#define LEVEL_FILTER_RATIO 8.0	//queue level filter bandwidth relative to loop
+#define MAX_RATE_CORRECTION 1000e-6	//max resampler ratio correction
 
 #define TEST_ERROR 1.0
 //#define TEST_ERROR 1.001	//use to force fixed sample rate error for testing
@@ -69,10 +79,17 @@ CSoundOut::CSoundOut(QObject *parent) :
 	m_OutRatio = 1.0;
 	m_OutAudioFormat.setFrequency(SOUNDCARD_RATE);
 	m_OutResampler.Init(8192);
+	m_pScratch = NULL;
 	m_RateCorrection = 0.0;
+	m_RateInteg = 0.0;
+	m_PpmError = 0;
+	m_LatencymSec = 0;
+	m_Underflows = 0;
+	m_Overflows = 0;
 	m_Gain = 1.0;
 	m_Startup = true;
 	m_BlockingMode = false;
+	SetLatencyMode(false, MAX_LATENCY_MSEC);
 }
 
 CSoundOut::~CSoundOut()
@@ -114,6 +131,10 @@ QAudioDeviceInfo  DeviceInfo;
 		//initialize the data queue variables
 		m_UserDataRate = 1;	//force user data rate to be changed
 		ChangeUserDataRate(UsrDataRate);
+		m_Underflows = 0;
+		m_Overflows = 0;
+		if(m_LowLatency)	//keep soundcard buffer about the same size as the queue target
+			m_pAudioOutput->setBufferSize(m_TargetLevel*2*m_OutAudioFormat.channels());
 		m_pOutput = m_pAudioOutput->start(); //start QT AudioOutput
 		//determine how long to sleep between low level reads based on samplerate and period size
 		m_BlockTime = ( 250*m_pAudioOutput->periodSize() )/
@@ -140,6 +161,8 @@ void CSoundOut::Stop()
 	if(!m_ThreadQuit)
 	{
 		m_ThreadQuit = TRUE;
+		m_WakeSem.release();
+		m_SpaceSem.release();
 		m_pAudioOutput->stop();
 		wait(500);
 	}
@@ -159,21 +182,73 @@ void CSoundOut::ChangeUserDataRate(double UsrDataRate)
 	{
 		m_UserDataRate = UsrDataRate;
 //qDebug()<<"SoundOutRatio"<<(1.0/m_OutRatio);
-		for(int i=0; i<OUTQSIZE ;i++)	//zero buffer for data output
-		{
-			m_OutQueueMono[i] = 0;
-			m_OutQueueStereo[i].re = 0;
-			m_OutQueueStereo[i].im = 0;
-		}
 		m_OutRatio = m_UserDataRate/m_OutAudioFormat.frequency();
-		m_OutQHead = 0;
-		m_OutQTail = 0;
-		m_OutQLevel = 0;
-		m_AveOutQLevel = OUTQSIZE/2;
-		m_Startup = true;
+		//the sound thread owns the queue tail so have it drop the old rate data
+		m_FlushReq.fetchAndStoreOrdered(1);
 	}
 }
 
+/////////////////////////////////////////////////////////////////////
+// Selects normal or low latency mode.
+// Normal mode holds the output queue half full(abt 170mSec) with a slow
+// rate loop. Low latency mode holds TargetmSec in the queue with a faster
+// loop and a soundcard buffer of about the same size.
+/////////////////////////////////////////////////////////////////////
+void CSoundOut::SetLatencyMode(bool LowLatency, int TargetmSec)
+{
+	m_LowLatency = LowLatency;
+	double bw;
+	if(m_LowLatency)
+	{
+		if(TargetmSec < MIN_LATENCY_MSEC)
+			TargetmSec = MIN_LATENCY_MSEC;
+		if(TargetmSec > MAX_LATENCY_MSEC)
+			TargetmSec = MAX_LATENCY_MSEC;
+		m_TargetLevel = (TargetmSec*SOUNDCARD_RATE)/1000;
+		bw = LOWLAT_LOOP_BW;
+	}
+	else
+	{
+		m_TargetLevel = OUTQSIZE/2;
+		bw = NORMAL_LOOP_BW;
+	}
+	//PI loop on queue level in seconds: wn^2 = Ki, 2*zeta*wn = Kp
+	double wn = K_2PI*bw;
+	m_LoopKp = 2.0*LOOP_ZETA*wn;
+	m_LoopKi = wn*wn;
+	m_LevelTau = 1.0/(wn*LEVEL_FILTER_RATIO);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Returns the most samples the resampler can output for numsamples
+// input samples at the largest rate correction.
+/////////////////////////////////////////////////////////////////////
+int CSoundOut::GetMaxResampleLength(int numsamples)
+{
+	double ratio = TEST_ERROR*m_OutRatio*(1.0 - MAX_RATE_CORRECTION);
+	return (int)( (double)numsamples/ratio ) + 2;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Returns the scratch arena bytes PutOutQueue() needs for numsamples
+/////////////////////////////////////////////////////////////////////
+int CSoundOut::GetScratchBytes(int numsamples)
+{
+	return CScratchArena::AlignedSize(GetMaxResampleLength(numsamples)*sizeof(TYPESTEREO16));
+}
+
+/////////////////////////////////////////////////////////////////////
+// Returns rate error, latency and over/underflow statistics
+/////////////////////////////////////////////////////////////////////
+void CSoundOut::GetStats(tSoundStats* pStats)
+{
+	pStats->PpmError = m_PpmError;
+	pStats->LatencymSec = m_LatencymSec;
+	pStats->TargetmSec = (m_TargetLevel*1000)/SOUNDCARD_RATE;
+	pStats->Underflows = m_Underflows;
+	pStats->Overflows = m_Overflows;
+}
+
 /////////////////////////////////////////////////////////////////////
 // Sets/changes volume control gain  0 <= vol <= 99
 //range scales to attenuation(gain) of -50dB to 0dB
@@ -192,58 +267,23 @@ void CSoundOut::SetVolume(qint32 vol)
 ////////////////////////////////////////////////////////////////
 //Called by application to put COMPLEX input into
 // STEREO 2 channel soundcard output queue
+// The queue is lock free so the DSP thread never waits on the
+// sound thread unless in blocking mode.
 ////////////////////////////////////////////////////////////////
 void CSoundOut::PutOutQueue(int numsamples, TYPECPX* pData )
 {
-TYPESTEREO16 RData[OUTQSIZE];	//buffer to hold resampled data
-int i;
-bool overflow = false;
 	if(( 0==numsamples) || m_ThreadQuit)
 		return;
+	int mark = m_pScratch->GetMark();
+	TYPESTEREO16* RData = m_pScratch->Alloc<TYPESTEREO16>(GetMaxResampleLength(numsamples));
 	//Call Resampler to match sample rates between radio and sound card
 	numsamples = m_OutResampler.Resample(numsamples, TEST_ERROR*m_OutRatio *(1.0+m_RateCorrection),
 										 pData, RData, m_Gain);
 
 g_pTestBench->DisplayData(numsamples, RData, SOUNDCARD_RATE, PROFILE_5);
 
-	if(m_BlockingMode)	//if in Blocking Mode then wait for soundcard queue to be available
-	{
-		for( i=0; i<numsamples; i++)
-		{
-			while( ((m_OutQHead+1) & (OUTQSIZE-1)) == m_OutQTail)
-				msleep(10);	//wait if Queue is full
-			m_OutQueueStereo[m_OutQHead++] = RData[i];
-			m_OutQHead &= (OUTQSIZE-1);
-			m_OutQLevel++;
-		}
-	}
-	else
-	{	//here if non-blocking mode so need to deal with possible over/under flow
-		m_Mutex.lock();
-		for( i=0; i<numsamples; i++)
-		{
-			m_OutQueueStereo[m_OutQHead++] = RData[i];
-			m_OutQHead &= (OUTQSIZE-1);
-			m_OutQLevel++;
-			if(m_OutQHead==m_OutQTail)	//if full
-			{	//remove 1/4 a queue's worth of data
-				m_OutQTail += OUTQSIZE/4;
-				m_OutQTail &= (OUTQSIZE-1);
-				m_OutQLevel -= OUTQSIZE/4;
-				i = numsamples;		//force break out of for loop
-				overflow = true;
-			}
-		}
-		if(overflow)
-		{
-			qDebug()<<"Snd Overflow";
-			g_pTestBench->SendDebugTxt("Snd Overflow");
-			m_AveOutQLevel = m_OutQLevel;
-		}
-		//calculate average Queue fill level
-		m_AveOutQLevel = (1.0-FILTERQLEVEL_ALPHA)*m_AveOutQLevel + FILTERQLEVEL_ALPHA*(double)m_OutQLevel;
-		m_Mutex.unlock();
-	}
+	PutQueue(m_OutQueueStereo, numsamples, RData);
+	m_pScratch->Release(mark);
 }
 
 ////////////////////////////////////////////////////////////////
@@ -252,11 +292,10 @@ g_pTestBench->DisplayData(numsamples, RData, SOUNDCARD_RATE, PROFILE_5);
 ////////////////////////////////////////////////////////////////
 void CSoundOut::PutOutQueue(int numsamples, TYPEREAL* pData )
 {
-TYPEMONO16 RData[OUTQSIZE];	//buffer to hold resampled data
-int i;
-bool overflow = false;
 	if(( 0==numsamples) || m_ThreadQuit)
 		return;
+	int mark = m_pScratch->GetMark();
+	TYPEMONO16* RData = m_pScratch->Alloc<TYPEMONO16>(GetMaxResampleLength(numsamples));
 
 	//Call Resampler to match sample rates between radio and sound card
 	numsamples = m_OutResampler.Resample(numsamples, TEST_ERROR*m_OutRatio *(1.0+m_RateCorrection),
@@ -264,116 +303,135 @@ bool overflow = false;
 
 g_pTestBench->DisplayData(numsamples, RData, SOUNDCARD_RATE, PROFILE_5);
 
-	if(m_BlockingMode)	//if in Blocking Mode then wait for soundcard queue to be available
+	PutQueue(m_OutQueueMono, numsamples, RData);
+	m_pScratch->Release(mark);
+}
+
+////////////////////////////////////////////////////////////////
+//Called by application in place of PutOutQueue() when all
+// 'numsamples' output samples are squelched.  The resampler only
+// steps its time so silence goes into the queue without any
+// filtering and the rate control keeps running.
+////////////////////////////////////////////////////////////////
+void CSoundOut::PutOutSilence(int numsamples)
+{
+	if(( 0==numsamples) || m_ThreadQuit)
+		return;
+	numsamples = m_OutResampler.Skip(numsamples, TEST_ERROR*m_OutRatio *(1.0+m_RateCorrection));
+	int mark = m_pScratch->GetMark();
+	if(m_StereoOut)
 	{
-		for( i=0; i<numsamples; i++)
-		{
-			while( ((m_OutQHead+1) & (OUTQSIZE-1)) == m_OutQTail)
-				msleep(10);	//wait if Queue is full
-			m_OutQueueMono[m_OutQHead++] = RData[i];
-			m_OutQHead &= (OUTQSIZE-1);
-			m_OutQLevel++;
-		}
+		TYPESTEREO16* RData = m_pScratch->Alloc<TYPESTEREO16>(numsamples);
+		memset(RData, 0, numsamples*sizeof(TYPESTEREO16));
+		PutQueue(m_OutQueueStereo, numsamples, RData);
 	}
 	else
-	{	//here if non-blocking mode so need to deal with possible over/under flow
-		m_Mutex.lock();
-		for( i=0; i<numsamples; i++)
-		{
-			m_OutQueueMono[m_OutQHead++] = RData[i];
-			m_OutQHead &= (OUTQSIZE-1);
-			m_OutQLevel++;
-			if(m_OutQHead==m_OutQTail)	//if full
-			{	//remove 1/4 a queue's worth of data
-				m_OutQTail += OUTQSIZE/4;
-				m_OutQTail &= (OUTQSIZE-1);
-				m_OutQLevel -= OUTQSIZE/4;
-				i = numsamples;		//force break out of for loop
-				overflow = true;
-			}
-		}
-		if(overflow)
+	{
+		TYPEMONO16* RData = m_pScratch->Alloc<TYPEMONO16>(numsamples);
+		memset(RData, 0, numsamples*sizeof(TYPEMONO16));
+		PutQueue(m_OutQueueMono, numsamples, RData);
+	}
+	m_pScratch->Release(mark);
+}
+
+////////////////////////////////////////////////////////////////
+//Puts resampled output samples into the soundcard queue
+////////////////////////////////////////////////////////////////
+template <class T>
+void CSoundOut::PutQueue(CSpscQueue<T, OUTQSIZE>& Queue, int numsamples, T* pData)
+{
+	int n = Queue.Put(numsamples, pData);
+	if( (n > 0) && (0 == m_WakeSem.available()) )
+		m_WakeSem.release();	//wake the sound thread for the new data
+	if(m_BlockingMode)	//if in Blocking Mode then wait for soundcard queue to be available
+	{
+		while( (n < numsamples) && !m_ThreadQuit)
 		{
-			qDebug()<<"Snd Overflow";
-			g_pTestBench->SendDebugTxt("Snd Overflow");
-			m_AveOutQLevel = m_OutQLevel;
+			m_SpaceSem.tryAcquire(1, 100);	//sound thread releases after reading
+			int m = Queue.Put(numsamples-n, &pData[n]);
+			if( (m > 0) && (0 == m_WakeSem.available()) )
+				m_WakeSem.release();
+			n += m;
 		}
-		//calculate average Queue fill level
-		m_AveOutQLevel = (1.0-FILTERQLEVEL_ALPHA)*m_AveOutQLevel + FILTERQLEVEL_ALPHA*(double)m_OutQLevel;
-		m_Mutex.unlock();
+	}
+	else if(n < numsamples)
+	{	//queue is full so have sound thread remove data down to the target level
+		m_OverflowReq.fetchAndStoreOrdered(1);
+		m_Overflows++;
+		qDebug()<<"Snd Overflow";
+		g_pTestBench->SendDebugTxt("Snd Overflow");
 	}
 }
 
+////////////////////////////////////////////////////////////////
+//Restarts the rate control loop and waits for the queue to refill.
+// Called by CSoundOut worker thread after a queue flush.
+////////////////////////////////////////////////////////////////
+void CSoundOut::ResetRateControl()
+{
+	m_AveOutQLevel = m_TargetLevel;
+	m_RateInteg = 0.0;
+	m_RateCorrection = 0.0;
+	m_Startup = true;
+}
+
 ////////////////////////////////////////////////////////////////
 //Called by CSoundOut worker thread to get new samples from queue
 // This routine is called from a worker thread so must be careful.
+// Only this thread reads from the queue and updates the fill level
+// average and rate error.
 //   MONO version
 ////////////////////////////////////////////////////////////////
 void CSoundOut::GetOutQueue(int numsamples, TYPEMONO16* pData )
 {
 int i;
-bool underflow = false;
-	m_Mutex.lock();
+	if(m_FlushReq.fetchAndStoreOrdered(0))
+	{	//user data rate changed so drop everything queued at the old rate
+		m_OutQueueMono.Discard(m_OutQueueMono.GetLevel());
+		m_OverflowReq.fetchAndStoreOrdered(0);
+		ResetRateControl();
+	}
+	if(m_OverflowReq.fetchAndStoreOrdered(0))
+	{	//producer found queue full so remove data down to the target level
+		m_OutQueueMono.Discard(m_OutQueueMono.GetLevel() - m_TargetLevel);
+		m_AveOutQLevel = m_OutQueueMono.GetLevel();
+	}
 	if(m_Startup)
 	{	//if no data in queue yet just stuff in silence until something is put in queue
 		for( i=0; i<numsamples; i++)
 			pData[i] = 0;
-		if(m_OutQLevel>OUTQSIZE/2)
-		{
+		if(m_OutQueueMono.GetLevel()>m_TargetLevel)
+		{	//keep rate loop integrator since the clock error has not changed
 			m_Startup = false;
-			m_RateUpdateCount = -5*SOUNDCARD_RATE;	//delay first error update to let settle
-			m_PpmError = 0;
-			m_AveOutQLevel = m_OutQLevel;
-			m_UpdateToggle = true;
-			}
+			m_AveOutQLevel = m_OutQueueMono.GetLevel();
+		}
 		else
 		{
-			m_Mutex.unlock();
 			return;
 		}
 	}
 
-	for( i=0; i<numsamples; i++)
-	{
-		if(m_OutQHead!=m_OutQTail)
+	int n = m_OutQueueMono.Get(numsamples, pData);
+	if(m_BlockingMode && (0 == m_SpaceSem.available()) )
+		m_SpaceSem.release();
+	if(n < numsamples)
+	{	//queue went empty so pad with silence and refill queue before playing again
+		for( i=n; i<numsamples; i++)
+			pData[i] = 0;
+		m_Startup = true;
+		m_Underflows++;
+		if(!m_BlockingMode)
 		{
-			pData[i] = m_OutQueueMono[m_OutQTail++];
-			m_OutQTail &= (OUTQSIZE-1);
-			m_OutQLevel--;
-		}
-		else	//queue went empty
-		{	//backup queue ptr and use previous data in queue
-			m_OutQTail -= (OUTQSIZE/4);
-			m_OutQTail &= (OUTQSIZE-1);
-			pData[i] = m_OutQueueMono[m_OutQTail];
-			m_OutQLevel += (OUTQSIZE/4);
-			underflow = true;
+			qDebug()<<"Snd Underflow";
+			g_pTestBench->SendDebugTxt("Snd Underflow");
 		}
-	}
-
-	if(m_BlockingMode)
-	{	//if in blocking mode just return
-		m_Mutex.unlock();
 		return;
 	}
 
-	//calculate average Queue fill level
-	m_AveOutQLevel = (1.0-FILTERQLEVEL_ALPHA)*m_AveOutQLevel + FILTERQLEVEL_ALPHA*m_OutQLevel;
-	if(underflow)
-	{
-		qDebug()<<"Snd Underflow";
-		g_pTestBench->SendDebugTxt("Snd Underflow");
-		m_AveOutQLevel = m_OutQLevel;
-	}
+	if(m_BlockingMode)	//if in blocking mode just return
+		return;
 
-	// See if time to update rate error calculation routine
-	m_RateUpdateCount += numsamples;
-	if(m_RateUpdateCount >= SOUNDCARD_RATE)	//every second
-	{
-		CalcError();
-		m_RateUpdateCount = 0;
-	}
-	m_Mutex.unlock();
+	UpdateRateControl(numsamples, m_OutQueueMono.GetLevel());
 }
 
 ////////////////////////////////////////////////////////////////
@@ -384,8 +442,17 @@ bool underflow = false;
 void CSoundOut::GetOutQueue(int numsamples, TYPESTEREO16* pData )
 {
 int i;
-bool underflow = false;
-	m_Mutex.lock();
+	if(m_FlushReq.fetchAndStoreOrdered(0))
+	{	//user data rate changed so drop everything queued at the old rate
+		m_OutQueueStereo.Discard(m_OutQueueStereo.GetLevel());
+		m_OverflowReq.fetchAndStoreOrdered(0);
+		ResetRateControl();
+	}
+	if(m_OverflowReq.fetchAndStoreOrdered(0))
+	{	//producer found queue full so remove data down to the target level
+		m_OutQueueStereo.Discard(m_OutQueueStereo.GetLevel() - m_TargetLevel);
+		m_AveOutQLevel = m_OutQueueStereo.GetLevel();
+	}
 	if(m_Startup)
 	{	//if no data in queue yet just stuff in silence until something is put in queue
 		for( i=0; i<numsamples; i++)
@@ -393,83 +460,78 @@ bool underflow = false;
 			pData[i].re = 0;
 			pData[i].im = 0;
 		}
-		if(m_OutQLevel>OUTQSIZE/2)
-		{
+		if(m_OutQueueStereo.GetLevel()>m_TargetLevel)
+		{	//keep rate loop integrator since the clock error has not changed
 			m_Startup = false;
-			m_RateUpdateCount = -5*SOUNDCARD_RATE;	//delay first error update to let settle
-			m_PpmError = 0;
-			m_AveOutQLevel = m_OutQLevel;
-			m_UpdateToggle = true;
-			}
+			m_AveOutQLevel = m_OutQueueStereo.GetLevel();
+		}
 		else
 		{
-			m_Mutex.unlock();
 			return;
 		}
 	}
 
-	for( i=0; i<numsamples; i++)
-	{
-		if(m_OutQHead!=m_OutQTail)
+	int n = m_OutQueueStereo.Get(numsamples, pData);
+	if(m_BlockingMode && (0 == m_SpaceSem.available()) )
+		m_SpaceSem.release();
+	if(n < numsamples)
+	{	//queue went empty so pad with silence and refill queue before playing again
+		for( i=n; i<numsamples; i++)
 		{
-			pData[i] = m_OutQueueStereo[m_OutQTail++];
-			m_OutQTail &= (OUTQSIZE-1);
-			m_OutQLevel--;
+			pData[i].re = 0;
+			pData[i].im = 0;
 		}
-		else	//queue went empty
-		{	//backup queue ptr and use previous data in queue
-			m_OutQTail -= (OUTQSIZE/4);
-			m_OutQTail &= (OUTQSIZE-1);
-			pData[i] = m_OutQueueStereo[m_OutQTail];
-			m_OutQLevel += (OUTQSIZE/4);
-			underflow = true;
+		m_Startup = true;
+		m_Underflows++;
+		if(!m_BlockingMode)
+		{
+			qDebug()<<"Snd Underflow";
+			g_pTestBench->SendDebugTxt("Snd Underflow");
 		}
-	}
-	if(m_BlockingMode)
-	{	//if in blocking mode just return
-		m_Mutex.unlock();
 		return;
 	}
-	//calculate average Queue fill level
-	m_AveOutQLevel = (1.0-FILTERQLEVEL_ALPHA)*m_AveOutQLevel + FILTERQLEVEL_ALPHA*m_OutQLevel;
 
-	if(underflow)
-	{
-		qDebug()<<"Snd Underflow";
-		g_pTestBench->SendDebugTxt("Snd Underflow");
-		m_AveOutQLevel = m_OutQLevel;
-	}
-	// See if time to update rate error calculation routine
-	m_RateUpdateCount += numsamples;
-	if(m_RateUpdateCount >= SOUNDCARD_RATE)	//every second
-	{
-		CalcError();
-		m_RateUpdateCount = 0;
-	}
-	m_Mutex.unlock();
+	if(m_BlockingMode)	//if in blocking mode just return
+		return;
+
+	UpdateRateControl(numsamples, m_OutQueueStereo.GetLevel());
 }
 
 ////////////////////////////////////////////////////////////////
-// Called alternately from the Get routines to update the
-// error correction process
+// Called from the Get routines every block to update the
+// rate control loop that keeps the output queue at m_TargetLevel.
+// The queue level is lowpass filtered to remove the sawtooth from
+// the block writes and reads, then a PI controller sets the resampler
+// rate correction.  pos error == level too high so output fewer samples.
 ////////////////////////////////////////////////////////////////
-void CSoundOut::CalcError()
+void CSoundOut::UpdateRateControl(int numsamples, int level)
 {
-double error;
-	error = (double)(m_AveOutQLevel - OUTQSIZE/2 );	//neg==level is too low  pos == level is to high
-	error = error * P_GAIN;
-	m_RateCorrection = error;
+	double dt = (double)numsamples/(double)SOUNDCARD_RATE;
+	double alpha = dt/m_LevelTau;
+	if(alpha > 1.0)
+		alpha = 1.0;
+	m_AveOutQLevel += alpha*((double)level - m_AveOutQLevel);
+	double error = (m_AveOutQLevel - (double)m_TargetLevel)/(double)SOUNDCARD_RATE;	//in Sec
+
+	m_RateInteg += m_LoopKi*error*dt;
+	if(m_RateInteg > MAX_RATE_CORRECTION)
+		m_RateInteg = MAX_RATE_CORRECTION;
+	else if(m_RateInteg < -MAX_RATE_CORRECTION)
+		m_RateInteg = -MAX_RATE_CORRECTION;
+	double correction = m_LoopKp*error + m_RateInteg;
+	if(correction > MAX_RATE_CORRECTION)
+		correction = MAX_RATE_CORRECTION;
+	else if(correction < -MAX_RATE_CORRECTION)
+		correction = -MAX_RATE_CORRECTION;
+	m_RateCorrection = correction;
 	m_PpmError = (int)( m_RateCorrection*1e6 );
-	if( abs(m_PpmError) > 500)
-	{
-		qDebug()<<"SoundOut "<<m_PpmError << m_AveOutQLevel;
-		g_pTestBench->SendDebugTxt("Snd error>500ppm");
-	}
 }
 
 //////////////////////////////////////////////////////////////////////////
 // Worker thread polls QAudioOutput device to see if there is room
 // to put more data into it and then calls GetOutQueue(..) to get more data.
+// Data is only written once a full device period is free and the thread
+// otherwise waits on a semaphore so Stop() can wake it immediately.
 // This thread was needed because the normal "pull" mechanism of Qt does
 // not work very well since it depends on the main process signal-slot event
 // queue and you get dropouts if the GUI gets busy.
@@ -482,7 +544,7 @@ void CSoundOut::run()
 			(QAudio::ActiveState == m_pAudioOutput->state() ) )
 		{	//Process sound data while soundcard is active and no errors
 			unsigned int len =  m_pAudioOutput->bytesFree();	//in bytes
-			if( len>0 )
+			if( (len>0) && ((int)len >= m_pAudioOutput->periodSize()) )
 			{
 				//limit size to SOUND_WRITEBUFSIZE
 				if(len > SOUND_WRITEBUFSIZE)
@@ -498,10 +560,16 @@ void CSoundOut::run()
 					GetOutQueue( len/2, (TYPEMONO16*)m_pData );
 				}
 				m_pOutput->write((char*)m_pData,len);
+				//latency is what is in the queue plus what the soundcard has buffered
+				int frame = m_StereoOut ? 4 : 2;
+				int queued = m_StereoOut ? m_OutQueueStereo.GetLevel() : m_OutQueueMono.GetLevel();
+				queued += (m_pAudioOutput->bufferSize() - m_pAudioOutput->bytesFree())/frame;
+				m_LatencymSec = (queued*1000)/SOUNDCARD_RATE;
 			}
 			else	//no room in sound card output buffer so wait
-			{		//not good but no other wait or blocking mechanism available
-				msleep(m_BlockTime);
+			{		//QAudioOutput notify() needs the GUI event loop so use a timed wait
+					//that PutQueue() ends early when new data is queued
+				m_WakeSem.tryAcquire(1, m_BlockTime);
 			}
 		}
 		else
@@ -12,12 +12,27 @@
 #include <QThread>
 #include <QList>
 #include <QMutex>
+#include <QSemaphore>
 #include <QAudioOutput>
 #include "dsp/fractresampler.h"
+#include "dsp/scratcharena.h"
+#include "interface/spscqueue.h"
 
 #define OUTQSIZE 16384	//max samples (keep power of 2 for ptr wrap around)
 #define SOUND_WRITEBUFSIZE 8192
 
+#define MIN_LATENCY_MSEC 10		//range of low latency mode target queue fill(min is one DSP block)
+#define MAX_LATENCY_MSEC 150
+
+typedef struct _sndstats
+{
+	int PpmError;		//current resampler rate correction
+	int LatencymSec;	//output queue plus soundcard buffer latency
+	int TargetmSec;		//target output queue latency
+	int Underflows;		//counts since Start()
+	int Overflows;
+}tSoundStats;
+
 class CSoundOut : public QThread
 {
 	Q_OBJECT
@@ -30,9 +45,14 @@ public:
 	void Stop();	//stops soundcard output
 	void PutOutQueue(int numsamples, TYPEREAL* pData );
 	void PutOutQueue(int numsamples, TYPECPX* pData );
+	void PutOutSilence(int numsamples);
 	void ChangeUserDataRate(double UsrDataRate);
 	void SetVolume(qint32 vol);
-	int GetRateError(){return (int)m_PpmError;}
+	void SetLatencyMode(bool LowLatency, int TargetmSec);	//call before Start()
+	void GetStats(tSoundStats* pStats);
+	//resampler output buffers come from the DSP pipeline's arena
+	void SetScratchArena(CScratchArena* pScratch){m_pScratch = pScratch;}
+	int GetScratchBytes(int numsamples);
 
 protected:
 	void run();		//implements worker thread loop
@@ -41,7 +61,10 @@ protected:
 private:
 	void GetOutQueue(int numsamples, TYPEMONO16* pData );
 	void GetOutQueue(int numsamples, TYPESTEREO16* pData );
-	void CalcError();
+	template <class T> void PutQueue(CSpscQueue<T, OUTQSIZE>& Queue, int numsamples, T* pData);
+	void UpdateRateControl(int numsamples, int level);
+	void ResetRateControl();
+	int GetMaxResampleLength(int numsamples);
 
 	QList<QAudioDeviceInfo> m_OutDevices;
 	QAudioDeviceInfo  m_OutDeviceInfo;
@@ -51,24 +74,34 @@ private:
 	QObject* m_pParent;
 	QMutex m_Mutex;
 	CFractResampler m_OutResampler;
+	CScratchArena* m_pScratch;
 
-	TYPEMONO16 m_OutQueueMono[OUTQSIZE];
-	TYPESTEREO16 m_OutQueueStereo[OUTQSIZE];
+	//lock free queues between the DSP thread(producer) and sound thread(consumer)
+	CSpscQueue<TYPEMONO16, OUTQSIZE> m_OutQueueMono;
+	CSpscQueue<TYPESTEREO16, OUTQSIZE> m_OutQueueStereo;
+	QAtomicInt m_OverflowReq;	//producer asks consumer to drop old data
+	QAtomicInt m_FlushReq;		//rate change asks consumer to empty the queue
+	QSemaphore m_WakeSem;		//wakes sound thread early on new data or when stopping
+	QSemaphore m_SpaceSem;		//wakes producer in blocking mode
 	bool m_BlockingMode;
 	bool m_ThreadQuit;
 	bool m_Startup;
 	bool m_StereoOut;
-	bool m_UpdateToggle;
-	quint32 m_OutQHead;
-	quint32 m_OutQTail;
+	bool m_LowLatency;
 	char m_pData[SOUND_WRITEBUFSIZE];
-	int m_RateUpdateCount;
-	int m_OutQLevel;
-	int m_PpmError;
+	int m_TargetLevel;		//output queue fill the rate control loop holds
+	volatile int m_PpmError;
+	volatile int m_LatencymSec;
+	volatile int m_Underflows;
+	volatile int m_Overflows;
 	double m_Gain;
 	double m_UserDataRate;
 	double m_OutRatio;
 	double m_RateCorrection;
+	double m_RateInteg;		//rate control loop integrator
+	double m_LoopKp;		//rate control loop gains
+	double m_LoopKi;
+	double m_LevelTau;		//queue level filter time constant
 	double m_AveOutQLevel;
 };
 #endif // SOUNDOUT_H
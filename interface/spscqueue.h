@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////
+// spscqueue.h: interface for the CSpscQueue template class.
+//
+//  This class implements a lock free single producer single consumer
+//ring buffer. One thread may only call Put() and one other thread may
+//only call Get() or Discard(). The head index is only written by the
+//producer and the tail index only by the consumer so no mutex is needed.
+//
+// History:
+//	2026-10-19  Initial creation
+//	2026-10-19  Plain acquire loads instead of read-modify-write
+//////////////////////////////////////////////////////////////////////
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicInt>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//SIZE must be a power of 2
+template <class T, int SIZE>
+class CSpscQueue
+{
+public:
+	CSpscQueue(){Reset();}
+
+	//only call when neither thread is using the queue
+	void Reset(){m_Head.fetchAndStoreOrdered(0); m_Tail.fetchAndStoreOrdered(0);}
+
+	//number of samples in queue(exact for the consumer, a lower bound for the producer)
+	int GetLevel(){return (Load(m_Head) - Load(m_Tail)) & (2*SIZE-1);}
+	int GetFree(){return SIZE - GetLevel();}
+
+	/////////////////////////////////////////////////////////////////////
+	// Producer side. Returns number of samples put which is less than
+	// numsamples if the queue becomes full.
+	/////////////////////////////////////////////////////////////////////
+	int Put(int numsamples, const T* pData)
+	{
+		int head = Load(m_Head);
+		int tail = Load(m_Tail);
+		int space = SIZE - ((head - tail) & (2*SIZE-1));
+		if(numsamples > space)
+			numsamples = space;
+		if(numsamples <= 0)
+			return 0;
+		for(int i=0; i<numsamples; i++)
+			m_Buf[(head+i) & (SIZE-1)] = pData[i];
+		//release makes the samples visible before the new head
+		m_Head.fetchAndStoreRelease((head + numsamples) & (2*SIZE-1));
+		return numsamples;
+	}
+
+	/////////////////////////////////////////////////////////////////////
+	// Consumer side. Returns number of samples read which is less than
+	// numsamples if the queue becomes empty.
+	/////////////////////////////////////////////////////////////////////
+	int Get(int numsamples, T* pData)
+	{
+		int tail = Load(m_Tail);
+		int head = Load(m_Head);
+		int level = (head - tail) & (2*SIZE-1);
+		if(numsamples > level)
+			numsamples = level;
+		if(numsamples <= 0)
+			return 0;
+		for(int i=0; i<numsamples; i++)
+			pData[i] = m_Buf[(tail+i) & (SIZE-1)];
+		//release keeps the reads ahead of handing the space back
+		m_Tail.fetchAndStoreRelease((tail + numsamples) & (2*SIZE-1));
+		return numsamples;
+	}
+
+	/////////////////////////////////////////////////////////////////////
+	// Consumer side. Throws away up to numsamples of the oldest samples.
+	/////////////////////////////////////////////////////////////////////
+	int Discard(int numsamples)
+	{
+		if(numsamples <= 0)
+			return 0;
+		int tail = Load(m_Tail);
+		int level = (Load(m_Head) - tail) & (2*SIZE-1);
+		if(numsamples > level)
+			numsamples = level;
+		m_Tail.fetchAndStoreRelease((tail + numsamples) & (2*SIZE-1));
+		return numsamples;
+	}
+
+private:
+	/////////////////////////////////////////////////////////////////////
+	// Acquire load of an index so the buffer accesses that follow are not
+	// moved ahead of it.  A read-modify-write would also write the other
+	// thread's cache line on every call.  Qt4 has no loadAcquire() so it
+	// reads the volatile value and adds a fence.
+	/////////////////////////////////////////////////////////////////////
+	static int Load(QAtomicInt& Index)
+	{
+#if QT_VERSION >= 0x050000
+		return Index.loadAcquire();
+#else
+		int val = Index;
+#if defined(_MSC_VER)
+		_ReadWriteBarrier();	//x86 loads are not reordered with later accesses
+#else
+		__sync_synchronize();
+#endif
+		return val;
+#endif
+	}
+
+	//indexes count modulo 2*SIZE so a full queue is different from an empty one
+	QAtomicInt m_Head;
+	QAtomicInt m_Tail;
+	T m_Buf[SIZE];
+};
+
+#endif // SPSCQUEUE_H